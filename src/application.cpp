@@ -21,6 +21,7 @@
 #include "util.h"
 #include "lsof.h"
 #include "disks.h"
+#include "gsm-sampler.h"
 
 extern "C" {
 #include "gsm-resources.h"
@@ -32,7 +33,8 @@ cb_solaris_mode_changed (Gio::Settings& settings,
                          GsmApplication*app)
 {
   app->config.solaris_mode = settings.get_boolean (key);
-  app->cpu_graph->clear_background ();
+  if (app->cpu_graph)
+    app->cpu_graph->clear_background ();
   if (app->timeout)
     proctable_update (app);
 }
@@ -43,7 +45,8 @@ cb_process_memory_in_iec_changed (Gio::Settings& settings,
                                   GsmApplication*app)
 {
   app->config.process_memory_in_iec = settings.get_boolean (key);
-  app->cpu_graph->clear_background ();
+  if (app->cpu_graph)
+    app->cpu_graph->clear_background ();
   if (app->timeout)
     proctable_update (app);
 }
@@ -54,8 +57,11 @@ cb_logarithmic_scale_changed (Gio::Settings& settings,
                               GsmApplication*app)
 {
   app->config.logarithmic_scale = settings.get_boolean (key);
-  app->mem_graph->clear_background ();
-  load_graph_reset (app->mem_graph);
+  if (app->mem_graph)
+    {
+      app->mem_graph->clear_background ();
+      load_graph_reset (app->mem_graph);
+    }
 }
 
 static void
@@ -64,8 +70,26 @@ cb_draw_stacked_changed (Gio::Settings& settings,
                          GsmApplication*app)
 {
   app->config.draw_stacked = settings.get_boolean (key);
-  app->cpu_graph->clear_background ();
-  load_graph_reset (app->cpu_graph);
+  if (app->cpu_graph)
+    {
+      app->cpu_graph->clear_background ();
+      load_graph_reset (app->cpu_graph);
+    }
+}
+
+static void
+cb_draw_heatmap_changed (Gio::Settings& settings,
+                         Glib::ustring  key,
+                         GsmApplication*app)
+{
+  app->config.draw_heatmap = settings.get_boolean (key);
+  if (app->cpu_graph)
+    {
+      if (app->cpu_graph->labels.cpu_legend)
+        gsm_cpu_legend_set_heatmap (app->cpu_graph->labels.cpu_legend, app->config.draw_heatmap);
+      app->cpu_graph->clear_background ();
+      load_graph_reset (app->cpu_graph);
+    }
 }
 
 static void
@@ -74,10 +98,16 @@ cb_draw_smooth_changed (Gio::Settings& settings,
                         GsmApplication*app)
 {
   app->config.draw_smooth = settings.get_boolean (key);
+  if (!app->cpu_graph)
+    return;
   app->cpu_graph->clear_background ();
   app->mem_graph->clear_background ();
   app->net_graph->clear_background ();
   app->disk_graph->clear_background ();
+#ifdef __linux__
+  app->pressure_graph->clear_background ();
+  app->cpu_times_graph->clear_background ();
+#endif
 }
 
 static void
@@ -86,7 +116,8 @@ cb_resources_memory_in_iec_changed (Gio::Settings& settings,
                                     GsmApplication*app)
 {
   app->config.resources_memory_in_iec = settings.get_boolean (key);
-  app->cpu_graph->clear_background ();
+  if (app->cpu_graph)
+    app->cpu_graph->clear_background ();
   if (app->timeout)
     proctable_update (app);
 }
@@ -98,7 +129,118 @@ cb_network_in_bits_changed (Gio::Settings& settings,
 {
   app->config.network_in_bits = settings.get_boolean (key);
   // force scale to be redrawn
-  app->net_graph->clear_background ();
+  if (app->net_graph)
+    app->net_graph->clear_background ();
+}
+
+static void
+cb_network_interface_changed (Gio::Settings& settings,
+                              Glib::ustring  key,
+                              GsmApplication*app)
+{
+  app->config.network_interface = settings.get_string (key);
+#ifdef __linux__
+  if (app->net_graph)
+    load_graph_select_interface (app->net_graph, app->config.network_interface.c_str ());
+#endif
+}
+
+static void
+cb_disk_device_changed (Gio::Settings& settings,
+                        Glib::ustring  key,
+                        GsmApplication*app)
+{
+  app->config.disk_device = settings.get_string (key);
+#ifdef __linux__
+  if (app->disk_graph)
+    load_graph_select_device (app->disk_graph, app->config.disk_device.c_str ());
+#endif
+}
+
+#ifdef __linux__
+/* A stall of 15 % of the time over a second */
+constexpr guint64 PRESSURE_STALL = 150000;
+constexpr guint64 PRESSURE_WINDOW = 1000000;
+
+static void
+cb_pressure_stall (GsmPressureResource resource,
+                   gpointer            data)
+{
+  GsmApplication *app = static_cast<GsmApplication *>(data);
+
+  procman_debug ("stall of pressure resource %d", resource);
+
+  for (LoadGraph *graph : { app->cpu_graph, app->cpu_times_graph, app->mem_graph, app->net_graph, app->disk_graph,
+                            app->pressure_graph })
+    if (graph)
+      load_graph_add_marker (graph, resource);
+
+  /* The processes of the time of the stall, not of the next update */
+  if (app->config.pressure_snapshot && app->tree)
+    proctable_update (app);
+}
+
+/* The triggers wake the process up on stalls only, whatever the update
+   intervals */
+static void
+setup_pressure_triggers (GsmApplication *app)
+{
+  const char *cgroup = app->config.pressure_cgroup.empty () ? NULL : app->config.pressure_cgroup.c_str ();
+
+  for (guint i = 0; i < GSM_PRESSURE_N_RESOURCES; i++)
+    {
+      g_autoptr (GError) error = NULL;
+
+      g_clear_pointer (&app->pressure_triggers[i], gsm_pressure_trigger_free);
+      app->pressure_triggers[i] = gsm_pressure_trigger_new (cgroup, GsmPressureResource (i),
+                                                            PRESSURE_STALL, PRESSURE_WINDOW,
+                                                            cb_pressure_stall, app, &error);
+      if (!app->pressure_triggers[i])
+        procman_debug ("no pressure trigger: %s", error->message);
+    }
+}
+#endif
+
+static void
+cb_pressure_cgroup_changed (Gio::Settings& settings,
+                            Glib::ustring  key,
+                            GsmApplication*app)
+{
+  app->config.pressure_cgroup = settings.get_string (key);
+#ifdef __linux__
+  if (app->pressure_graph)
+    load_graph_set_pressure_cgroup (app->pressure_graph, app->config.pressure_cgroup.c_str ());
+  setup_pressure_triggers (app);
+#endif
+}
+
+static void
+cb_show_cpu_times_changed (Gio::Settings& settings,
+                           Glib::ustring  key,
+                           GsmApplication*app)
+{
+  app->config.show_cpu_times = settings.get_boolean (key);
+  /* Not read while hidden, its points are left empty until shown */
+}
+
+static void
+cb_cpu_times_cpu_changed (Gio::Settings& settings,
+                          Glib::ustring  key,
+                          GsmApplication*app)
+{
+  app->config.cpu_times_cpu = settings.get_uint (key);
+#ifdef __linux__
+  if (app->cpu_times_graph)
+    load_graph_select_cpu (app->cpu_times_graph, app->config.cpu_times_cpu);
+#endif
+}
+
+static void
+cb_pressure_snapshot_changed (Gio::Settings& settings,
+                              Glib::ustring  key,
+                              GsmApplication*app)
+{
+  app->config.pressure_snapshot = settings.get_boolean (key);
 }
 
 static void
@@ -108,7 +250,8 @@ cb_network_total_in_bits_changed (Gio::Settings& settings,
 {
   app->config.network_total_in_bits = settings.get_boolean (key);
   // force scale to be redrawn
-  app->net_graph->clear_background ();
+  if (app->net_graph)
+    app->net_graph->clear_background ();
 }
 
 static void
@@ -127,6 +270,8 @@ cb_timeouts_changed (Gio::Settings& settings,
   else if (key == GSM_SETTING_GRAPH_UPDATE_INTERVAL)
     {
       app->config.graph_update_interval = settings.get_int (key);
+      if (!app->cpu_graph)
+        return;
       load_graph_change_speed (app->cpu_graph,
                                app->config.graph_update_interval);
       load_graph_change_speed (app->mem_graph,
@@ -135,6 +280,12 @@ cb_timeouts_changed (Gio::Settings& settings,
                                app->config.graph_update_interval);
       load_graph_change_speed (app->disk_graph,
                                app->config.graph_update_interval);
+#ifdef __linux__
+      load_graph_change_speed (app->pressure_graph,
+                               app->config.graph_update_interval);
+      load_graph_change_speed (app->cpu_times_graph,
+                               app->config.graph_update_interval);
+#endif
     }
 }
 
@@ -146,10 +297,17 @@ cb_data_points_changed (Gio::Settings& settings,
   app->config.graph_data_points = settings.get_int (key);
   unsigned points = app->config.graph_data_points + 2;
 
+  if (!app->cpu_graph)
+    return;
+
   load_graph_change_num_points (app->cpu_graph, points);
   load_graph_change_num_points (app->mem_graph, points);
   load_graph_change_num_points (app->net_graph, points);
   load_graph_change_num_points (app->disk_graph, points);
+#ifdef __linux__
+  load_graph_change_num_points (app->pressure_graph, points);
+  load_graph_change_num_points (app->cpu_times_graph, points);
+#endif
 }
 
 static void
@@ -197,6 +355,21 @@ apply_cpu_color_settings (Gio::Settings& settings,
   g_variant_unref (cpu_colors_var);
 }
 
+#ifdef __linux__
+static void
+apply_cpu_times_color_settings (Gio::Settings& settings,
+                                GsmApplication*app)
+{
+  const auto colors = settings.get_string_array (GSM_SETTING_CPU_TIMES_COLORS);
+
+  /* The defaults of the states missing from the setting */
+  const auto defaults = procman::generate_colors (G_N_ELEMENTS (app->config.cpu_times_color));
+
+  for (guint i = 0; i < G_N_ELEMENTS (app->config.cpu_times_color); i++)
+    gdk_rgba_parse (&app->config.cpu_times_color[i], i < colors.size () ? colors[i].c_str () : defaults[i].c_str ());
+}
+#endif
+
 static void
 cb_color_changed (Gio::Settings& settings,
                   Glib::ustring  key,
@@ -205,54 +378,127 @@ cb_color_changed (Gio::Settings& settings,
   if (key == GSM_SETTING_CPU_COLORS)
     {
       apply_cpu_color_settings (settings, app);
+      if (!app->cpu_graph)
+        return;
       for (int i = 0; i < app->config.num_cpus; i++)
         if (!gdk_rgba_equal (&app->cpu_graph->colors[i], &app->config.cpu_color[i]))
           {
             app->cpu_graph->colors[i] = app->config.cpu_color[i];
             break;
           }
+      if (app->cpu_graph->labels.cpu_legend)
+        gsm_cpu_legend_set_colors (app->cpu_graph->labels.cpu_legend, &app->cpu_graph->colors[0]);
+      app->cpu_graph->clear_background ();
+      return;
+    }
+
+#ifdef __linux__
+  if (key == GSM_SETTING_CPU_TIMES_COLORS)
+    {
+      apply_cpu_times_color_settings (settings, app);
+      if (!app->cpu_times_graph)
+        return;
+      std::copy_n (app->config.cpu_times_color, G_N_ELEMENTS (app->config.cpu_times_color),
+                   app->cpu_times_graph->colors.begin ());
+      app->cpu_times_graph->clear_background ();
       return;
     }
+#endif
 
   auto color = settings.get_string (key);
 
   if (key == GSM_SETTING_MEM_COLOR)
     {
       gdk_rgba_parse (&app->config.mem_color, color.c_str ());
-      app->mem_graph->colors.at (0) = app->config.mem_color;
+      if (app->mem_graph)
+        {
+          app->mem_graph->colors.at (0) = app->config.mem_color;
+          app->mem_graph->clear_background ();
+        }
     }
   else if (key == GSM_SETTING_SWAP_COLOR)
     {
       gdk_rgba_parse (&app->config.swap_color, color.c_str ());
-      app->mem_graph->colors.at (1) = app->config.swap_color;
+      if (app->mem_graph)
+        {
+          app->mem_graph->colors.at (1) = app->config.swap_color;
+          app->mem_graph->clear_background ();
+        }
     }
   else if (key == GSM_SETTING_NET_IN_COLOR)
     {
       gdk_rgba_parse (&app->config.net_in_color, color.c_str ());
-      app->net_graph->colors.at (0) = app->config.net_in_color;
+      if (app->net_graph)
+        {
+          app->net_graph->colors.at (0) = app->config.net_in_color;
+          app->net_graph->clear_background ();
+        }
     }
   else if (key == GSM_SETTING_NET_OUT_COLOR)
     {
       gdk_rgba_parse (&app->config.net_out_color, color.c_str ());
-      app->net_graph->colors.at (1) = app->config.net_out_color;
+      if (app->net_graph)
+        {
+          app->net_graph->colors.at (1) = app->config.net_out_color;
+          app->net_graph->clear_background ();
+        }
     }
   else if (key == GSM_SETTING_DISK_READ_COLOR)
     {
       gdk_rgba_parse (&app->config.disk_read_color, color.c_str ());
-      app->disk_graph->colors.at (0) = app->config.disk_read_color;
+      if (app->disk_graph)
+        {
+          app->disk_graph->colors.at (0) = app->config.disk_read_color;
+          app->disk_graph->clear_background ();
+        }
     }
   else if (key == GSM_SETTING_DISK_WRITE_COLOR)
     {
       gdk_rgba_parse (&app->config.disk_write_color, color.c_str ());
-      app->disk_graph->colors.at (1) = app->config.disk_write_color;
+      if (app->disk_graph)
+        {
+          app->disk_graph->colors.at (1) = app->config.disk_write_color;
+          app->disk_graph->clear_background ();
+        }
+    }
+  else if (key == GSM_SETTING_PRESSURE_CPU_COLOR)
+    {
+      gdk_rgba_parse (&app->config.pressure_cpu_color, color.c_str ());
+#ifdef __linux__
+      if (app->pressure_graph)
+        {
+          app->pressure_graph->colors.at (GSM_PRESSURE_CPU) = app->config.pressure_cpu_color;
+          app->pressure_graph->clear_background ();
+        }
+#endif
+    }
+  else if (key == GSM_SETTING_PRESSURE_MEMORY_COLOR)
+    {
+      gdk_rgba_parse (&app->config.pressure_memory_color, color.c_str ());
+#ifdef __linux__
+      if (app->pressure_graph)
+        {
+          app->pressure_graph->colors.at (GSM_PRESSURE_MEMORY) = app->config.pressure_memory_color;
+          app->pressure_graph->clear_background ();
+        }
+#endif
+    }
+  else if (key == GSM_SETTING_PRESSURE_IO_COLOR)
+    {
+      gdk_rgba_parse (&app->config.pressure_io_color, color.c_str ());
+#ifdef __linux__
+      if (app->pressure_graph)
+        {
+          app->pressure_graph->colors.at (GSM_PRESSURE_IO) = app->config.pressure_io_color;
+          app->pressure_graph->clear_background ();
+        }
+#endif
     }
 }
 
 void
 GsmApplication::load_settings ()
 {
-  glibtop_cpu cpu;
-
   this->settings = Gio::Settings::create (GSM_GSETTINGS_SCHEMA);
 
   config.current_tab = this->settings->get_string (GSM_SETTING_CURRENT_TAB);
@@ -277,11 +523,26 @@ GsmApplication::load_settings ()
     cb_draw_stacked_changed (*this->settings.operator-> (), key, this);
   });
 
+  config.draw_heatmap = this->settings->get_boolean (GSM_SETTING_DRAW_HEATMAP);
+  this->settings->signal_changed (GSM_SETTING_DRAW_HEATMAP).connect ([this](const Glib::ustring&key) {
+    cb_draw_heatmap_changed (*this->settings.operator-> (), key, this);
+  });
+
   config.draw_smooth = this->settings->get_boolean (GSM_SETTING_DRAW_SMOOTH);
   this->settings->signal_changed (GSM_SETTING_DRAW_SMOOTH).connect ([this](const Glib::ustring&key) {
     cb_draw_smooth_changed (*this->settings.operator-> (), key, this);
   });
 
+  config.show_cpu_times = this->settings->get_boolean (GSM_SETTING_SHOW_CPU_TIMES);
+  this->settings->signal_changed (GSM_SETTING_SHOW_CPU_TIMES).connect ([this](const Glib::ustring&key) {
+    cb_show_cpu_times_changed (*this->settings.operator-> (), key, this);
+  });
+
+  config.cpu_times_cpu = this->settings->get_uint (GSM_SETTING_CPU_TIMES_CPU);
+  this->settings->signal_changed (GSM_SETTING_CPU_TIMES_CPU).connect ([this](const Glib::ustring&key) {
+    cb_cpu_times_cpu_changed (*this->settings.operator-> (), key, this);
+  });
+
   config.resources_memory_in_iec = this->settings->get_boolean (GSM_SETTING_RESOURCES_MEMORY_IN_IEC);
   this->settings->signal_changed (GSM_SETTING_RESOURCES_MEMORY_IN_IEC).connect ([this](const Glib::ustring&key) {
     cb_resources_memory_in_iec_changed (*this->settings.operator-> (), key, this);
@@ -297,6 +558,30 @@ GsmApplication::load_settings ()
     cb_network_total_in_bits_changed (*this->settings.operator-> (), key, this);
   });
 
+  config.network_interface = this->settings->get_string (GSM_SETTING_NETWORK_INTERFACE);
+  this->settings->signal_changed (GSM_SETTING_NETWORK_INTERFACE).connect ([this](const Glib::ustring&key) {
+    cb_network_interface_changed (*this->settings.operator-> (), key, this);
+  });
+
+  config.disk_device = this->settings->get_string (GSM_SETTING_DISK_DEVICE);
+  this->settings->signal_changed (GSM_SETTING_DISK_DEVICE).connect ([this](const Glib::ustring&key) {
+    cb_disk_device_changed (*this->settings.operator-> (), key, this);
+  });
+
+  config.pressure_cgroup = this->settings->get_string (GSM_SETTING_PRESSURE_CGROUP);
+  this->settings->signal_changed (GSM_SETTING_PRESSURE_CGROUP).connect ([this](const Glib::ustring&key) {
+    cb_pressure_cgroup_changed (*this->settings.operator-> (), key, this);
+  });
+
+  config.pressure_snapshot = this->settings->get_boolean (GSM_SETTING_PRESSURE_SNAPSHOT);
+  this->settings->signal_changed (GSM_SETTING_PRESSURE_SNAPSHOT).connect ([this](const Glib::ustring&key) {
+    cb_pressure_snapshot_changed (*this->settings.operator-> (), key, this);
+  });
+
+#ifdef __linux__
+  setup_pressure_triggers (this);
+#endif
+
   auto cbtc = [this](const Glib::ustring&key) {
                 cb_timeouts_changed (*this->settings.operator-> (), key, this);
               };
@@ -311,10 +596,10 @@ GsmApplication::load_settings ()
     cb_data_points_changed (*this->settings.operator-> (), key, this);
   });
 
-  glibtop_get_cpu (&cpu);
-  frequency = cpu.frequency;
+  frequency = gsm_sampler_get_cpu (NULL)->frequency;
 
   config.num_cpus = glibtop_get_sysinfo ()->ncpu;  // or server->ncpu + 1
+  config.cpu_color.resize (config.num_cpus);
 
   apply_cpu_color_settings (*this->settings.operator-> (), this);
 
@@ -342,12 +627,30 @@ GsmApplication::load_settings ()
 
   gdk_rgba_parse (&config.disk_write_color, disk_write_color.empty () ? "#00f2000000c1" : disk_write_color.c_str ());
 
+  auto pressure_cpu_color = this->settings->get_string (GSM_SETTING_PRESSURE_CPU_COLOR);
+
+  gdk_rgba_parse (&config.pressure_cpu_color, pressure_cpu_color.empty () ? "#c061cb" : pressure_cpu_color.c_str ());
+
+  auto pressure_memory_color = this->settings->get_string (GSM_SETTING_PRESSURE_MEMORY_COLOR);
+
+  gdk_rgba_parse (&config.pressure_memory_color, pressure_memory_color.empty () ? "#2ec27e" : pressure_memory_color.c_str ());
+
+  auto pressure_io_color = this->settings->get_string (GSM_SETTING_PRESSURE_IO_COLOR);
+
+  gdk_rgba_parse (&config.pressure_io_color, pressure_io_color.empty () ? "#e5a50a" : pressure_io_color.c_str ());
+
 
   auto cbcc = [this](const Glib::ustring&key) {
                 cb_color_changed (*this->settings.operator-> (), key, this);
               };
 
-  for (auto k : { GSM_SETTING_CPU_COLORS, GSM_SETTING_MEM_COLOR, GSM_SETTING_SWAP_COLOR, GSM_SETTING_NET_IN_COLOR, GSM_SETTING_NET_OUT_COLOR, GSM_SETTING_DISK_READ_COLOR, GSM_SETTING_DISK_WRITE_COLOR })
+#ifdef __linux__
+  apply_cpu_times_color_settings (*this->settings.operator-> (), this);
+  this->settings->signal_changed (GSM_SETTING_CPU_TIMES_COLORS).connect (cbcc);
+#endif
+
+  for (auto k : { GSM_SETTING_CPU_COLORS, GSM_SETTING_MEM_COLOR, GSM_SETTING_SWAP_COLOR, GSM_SETTING_NET_IN_COLOR, GSM_SETTING_NET_OUT_COLOR, GSM_SETTING_DISK_READ_COLOR, GSM_SETTING_DISK_WRITE_COLOR,
+                  GSM_SETTING_PRESSURE_CPU_COLOR, GSM_SETTING_PRESSURE_MEMORY_COLOR, GSM_SETTING_PRESSURE_IO_COLOR })
     this->settings->signal_changed (k).connect (cbcc);
 }
 
@@ -369,6 +672,7 @@ GsmApplication::GsmApplication()
   search_button (NULL),
   search_entry (NULL),
   search_bar (NULL),
+  search_query (NULL),
   top_of_tree (NULL),
 
   last_vscroll_max (0.0),
@@ -382,6 +686,11 @@ GsmApplication::GsmApplication()
   mem_graph (NULL),
   net_graph (NULL),
   disk_graph (NULL),
+#ifdef __linux__
+  pressure_graph (NULL),
+  cpu_times_graph (NULL),
+  pressure_triggers (),
+#endif
 
   disk_list (NULL),
 
@@ -483,9 +792,15 @@ void
 GsmApplication::shutdown ()
 {
   if (timeout)
-    g_source_remove (timeout);
+    gsm_sampler_remove (timeout);
+
+#ifdef __linux__
+  for (auto &trigger : pressure_triggers)
+    g_clear_pointer (&trigger, gsm_pressure_trigger_free);
+#endif
 
   proctable_free_table (this);
+  delete search_query;
   delete smooth_refresh;
   delete pretty_table;
 
@@ -502,6 +817,8 @@ GsmApplication::on_startup ()
 
   g_resources_register (gsm_get_resource ());
 
+  procman_startup_phase ("begin");
+
   Gtk::Application::on_startup ();
 
   glibtop_init ();
@@ -552,7 +869,9 @@ GsmApplication::on_startup ()
   set_accel_for_action ("win.refresh", "<Control>r");
 
   load_settings ();
+  procman_startup_phase ("settings loaded");
 
   pretty_table = new PrettyTable ();
   smooth_refresh = new SmoothRefresh (settings);
+  procman_startup_phase ("caches created");
 }
@@ -7,6 +7,7 @@
 
 #include <algorithm>
 #include <mutex>
+#include <vector>
 
 struct LoadGraph;
 
@@ -15,9 +16,15 @@ struct LoadGraph;
 #include "prettytable.h"
 #include "procinfo.h"
 #include "proclist.h"
+#include "procquery.h"
 #include "smooth_refresh.h"
 #include "util.h"
 
+#ifdef __linux__
+#include "gsm-pressure.h"
+#include "gsm-procstat.h"
+#endif
+
 struct ProcConfig
   : private procman::NonCopyable
 {
@@ -26,12 +33,19 @@ struct ProcConfig
     update_interval (0),
     graph_update_interval (0),
     graph_data_points (0),
+    cpu_color (),
+#ifdef __linux__
+    cpu_times_color (),
+#endif
     mem_color (),
     swap_color (),
     net_in_color (),
     net_out_color (),
     disk_read_color (),
     disk_write_color (),
+    pressure_cpu_color (),
+    pressure_memory_color (),
+    pressure_io_color (),
     bg_color (),
     frame_color (),
     num_cpus (0),
@@ -39,25 +53,38 @@ struct ProcConfig
     process_memory_in_iec (true),
     logarithmic_scale (false),
     draw_stacked (false),
+    draw_heatmap (false),
     draw_smooth (true),
+    show_cpu_times (false),
+    cpu_times_cpu (0),
     resources_memory_in_iec (true),
     network_in_bits (false),
-    network_total_in_bits (false)
+    network_total_in_bits (false),
+    network_interface (),
+    disk_device (),
+    pressure_cgroup (),
+    pressure_snapshot (false)
   {
-    std::fill (&this->cpu_color[0], &this->cpu_color[GLIBTOP_NCPU], GdkRGBA ());
   }
 
   Glib::ustring current_tab;
   int update_interval;
   int graph_update_interval;
   int graph_data_points;
-  GdkRGBA cpu_color[GLIBTOP_NCPU];
+  std::vector<GdkRGBA> cpu_color;
+#ifdef __linux__
+  /* Of the busy states */
+  GdkRGBA cpu_times_color[GSM_CPU_IDLE];
+#endif
   GdkRGBA mem_color;
   GdkRGBA swap_color;
   GdkRGBA net_in_color;
   GdkRGBA net_out_color;
   GdkRGBA disk_read_color;
   GdkRGBA disk_write_color;
+  GdkRGBA pressure_cpu_color;
+  GdkRGBA pressure_memory_color;
+  GdkRGBA pressure_io_color;
   GdkRGBA bg_color;
   GdkRGBA frame_color;
   gint num_cpus;
@@ -65,10 +92,17 @@ struct ProcConfig
   bool process_memory_in_iec;
   bool logarithmic_scale;
   bool draw_stacked;
+  bool draw_heatmap;
   bool draw_smooth;
+  bool show_cpu_times;
+  guint cpu_times_cpu;
   bool resources_memory_in_iec;
   bool network_in_bits;
   bool network_total_in_bits;
+  Glib::ustring network_interface;
+  Glib::ustring disk_device;
+  Glib::ustring pressure_cgroup;
+  bool pressure_snapshot;
 };
 
 class GsmApplication final: public Gtk::Application, private procman::NonCopyable
@@ -113,6 +147,7 @@ public:
   GtkToggleButton *search_button;
   GtkSearchEntry *search_entry;
   GtkSearchBar *search_bar;
+  ProcQuery *search_query;
   GtkTreePath *top_of_tree;
 
   gdouble last_vscroll_max;
@@ -126,6 +161,12 @@ public:
   LoadGraph *mem_graph;
   LoadGraph *net_graph;
   LoadGraph *disk_graph;
+#ifdef __linux__
+  LoadGraph *pressure_graph;
+  LoadGraph *cpu_times_graph;
+  /* Watched all the time, NULL without pressure triggers */
+  GsmPressureTrigger *pressure_triggers[GSM_PRESSURE_N_RESOURCES];
+#endif
 
   GsmDisksView *disk_list;
 
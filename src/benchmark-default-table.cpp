@@ -0,0 +1,102 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * Looks up the default icon of the processes of a typical desktop
+ * session, once by matching every default_table entry in turn, once
+ * with the combined regex and once with the memoized lookups, as done
+ * for every new process.
+ */
+
+#include <glib.h>
+
+#include <string>
+#include <vector>
+
+#include "defaulttable.h"
+
+#define N_ROUNDS 200
+
+static const char *const process_names[] = {
+  "systemd", "kthreadd", "rcu_gp", "kworker/0:1-events", "ksoftirqd/0",
+  "migration/0", "systemd-journald", "systemd-udevd", "systemd-oomd",
+  "systemd-resolved", "auditd", "dbus-broker", "dbus-broker-launch",
+  "NetworkManager", "polkitd", "rtkit-daemon", "accounts-daemon",
+  "bluetoothd", "upowerd", "udisksd", "cupsd", "chronyd", "crond", "atd",
+  "sshd", "ssh-agent", "gdm", "gdm-session-worker", "gnome-shell",
+  "gnome-session-binary", "gnome-keyring-daemon", "gsd-power", "gsd-color",
+  "gsd-media-keys", "gvfsd", "gvfsd-fuse", "dconf-service",
+  "evolution-source-registry", "evolution-alarm-notify", "tracker-miner-fs-3",
+  "pipewire", "wireplumber", "pipewire-pulse", "Xwayland", "ibus-daemon",
+  "xdg-desktop-portal", "xdg-document-portal", "gnome-terminal-server",
+  "bash", "zsh", "vim", "emacs", "git", "make", "gcc", "cc1plus", "ld",
+  "firefox", "Isolated Web Co", "WebExtensions", "nautilus", "code",
+  "gnome-system-monitor", "top", "containerd", "dockerd", "getty",
+};
+
+static size_t
+match_one_by_one (const std::vector<std::string> &names)
+{
+  size_t found = 0;
+
+  for (int round = 0; round < N_ROUNDS; round++)
+    for (const auto &name : names)
+      for (size_t i = 0; i != G_N_ELEMENTS (default_table); ++i)
+        if (default_table[i].command->match (name.c_str ()))
+          {
+            found++;
+            break;
+          }
+
+  return found;
+}
+
+static size_t
+match_combined (const std::vector<std::string> &names)
+{
+  DefaultTableMatcher matcher;
+  size_t found = 0;
+
+  for (int round = 0; round < N_ROUNDS; round++)
+    for (const auto &name : names)
+      found += matcher.lookup (name) != nullptr;
+
+  return found;
+}
+
+static size_t
+match_memoized (const std::vector<std::string> &names)
+{
+  DefaultTableMatcher matcher;
+  size_t found = 0;
+
+  for (int round = 0; round < N_ROUNDS; round++)
+    for (const auto &name : names)
+      found += matcher.match (name) != nullptr;
+
+  return found;
+}
+
+template<typename Func>
+static void
+run (const char                     *name,
+     const std::vector<std::string> &names,
+     Func                            func)
+{
+  const gint64 start = g_get_monotonic_time ();
+  const size_t n = func (names);
+  const gint64 end = g_get_monotonic_time ();
+
+  g_print ("%-24s %6zu matches %10.3f ms\n", name, n, (end - start) / 1000.0);
+}
+
+int
+main (int, char **)
+{
+  const std::vector<std::string> names (process_names, process_names + G_N_ELEMENTS (process_names));
+
+  run ("one regex per entry", names, match_one_by_one);
+  run ("combined regex", names, match_combined);
+  run ("memoized", names, match_memoized);
+
+  return 0;
+}
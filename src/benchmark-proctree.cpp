@@ -0,0 +1,165 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * Builds the dependency tree of a synthetic 10k processes forest, once
+ * with the former repeated scan over the list of new processes and once
+ * with the topological pass over ProcTree.
+ */
+
+#include <glib.h>
+
+#include <algorithm>
+#include <list>
+#include <set>
+#include <vector>
+
+#include "proctree.h"
+
+#define N_PROCESSES 10000
+#define N_ROOTS 8
+
+struct FakeProc
+{
+  pid_t pid;
+  pid_t ppid;
+};
+
+static std::vector<FakeProc>
+make_forest (GRand *rand)
+{
+  std::vector<pid_t> pids;
+  std::vector<FakeProc> procs;
+
+  for (pid_t pid = 1; pid <= N_PROCESSES; pid++)
+    pids.push_back (pid);
+
+  // pids wrap around, so a child can have a lower pid than its parent
+  for (size_t i = pids.size () - 1; i > 0; i--)
+    std::swap (pids[i], pids[g_rand_int_range (rand, 0, i + 1)]);
+
+  for (size_t i = 0; i < pids.size (); i++)
+    {
+      pid_t ppid = 0;
+
+      // half of the processes fork off one of the latest ones, which
+      // makes deep chains like build fan-outs
+      if (i >= N_ROOTS && g_rand_boolean (rand))
+        ppid = procs[i - g_rand_int_range (rand, 1, MIN (i, 4) + 1)].pid;
+      else if (i >= N_ROOTS)
+        ppid = procs[g_rand_int_range (rand, 0, i)].pid;
+
+      procs.push_back ({ pids[i], ppid });
+    }
+
+  std::sort (procs.begin (), procs.end (), [](const FakeProc &a, const FakeProc &b) {
+    return a.pid < b.pid;
+  });
+
+  return procs;
+}
+
+static size_t
+insert_by_scanning (const std::vector<FakeProc> &procs)
+{
+  std::list<const FakeProc *> addition;
+  std::set<pid_t> in_tree;
+  size_t inserted = 0;
+
+  for (const auto &p : procs)
+    addition.push_back (&p);
+
+  while (not addition.empty ())
+    {
+      auto it = addition.begin ();
+
+      while (it != addition.end ())
+        {
+          if ((*it)->ppid <= 0 or in_tree.find ((*it)->ppid) != in_tree.end ())
+            {
+              in_tree.insert ((*it)->pid);
+              inserted++;
+              it = addition.erase (it);
+              continue;
+            }
+          ++it;
+        }
+    }
+
+  return inserted;
+}
+
+static size_t
+insert_topologically (const std::vector<FakeProc> &procs)
+{
+  ProcTree<const FakeProc *> tree;
+  std::unordered_set<pid_t> addition;
+  size_t inserted = 0;
+
+  for (const auto &p : procs)
+    {
+      tree.set (p.pid, p.ppid, &p);
+      addition.insert (p.pid);
+    }
+
+  tree.foreach_topological (addition, [&inserted](pid_t) {
+    inserted++;
+  });
+
+  return inserted;
+}
+
+static size_t
+reparent_orphans (const std::vector<FakeProc> &procs)
+{
+  ProcTree<const FakeProc *> tree;
+  size_t moved = 0;
+
+  for (const auto &p : procs)
+    tree.set (p.pid, p.ppid, &p);
+
+  // every root dies and its children are adopted by init
+  for (const auto &p : procs)
+    {
+      if (p.ppid != 0)
+        continue;
+
+      const std::vector<pid_t> orphans = tree.children (p.pid);
+
+      tree.remove (p.pid);
+      for (pid_t orphan : orphans)
+        {
+          tree.set (orphan, 1, tree.value (orphan));
+          moved++;
+        }
+    }
+
+  return moved;
+}
+
+template<typename Func>
+static void
+run (const char                  *name,
+     const std::vector<FakeProc> &procs,
+     Func                         func)
+{
+  const gint64 start = g_get_monotonic_time ();
+  const size_t n = func (procs);
+  const gint64 end = g_get_monotonic_time ();
+
+  g_print ("%-24s %6zu processes %10.3f ms\n", name, n, (end - start) / 1000.0);
+}
+
+int
+main (int, char **)
+{
+  GRand *rand = g_rand_new_with_seed (42);
+  const std::vector<FakeProc> procs = make_forest (rand);
+
+  run ("scan addition list", procs, insert_by_scanning);
+  run ("topological pass", procs, insert_topologically);
+  run ("reparent orphans", procs, reparent_orphans);
+
+  g_rand_free (rand);
+
+  return 0;
+}
@@ -2,6 +2,7 @@
 #define _GSM_DEFAULT_TABLE_H_
 
 #include <string>
+#include <unordered_map>
 #include <glibmm/refptr.h>
 #include <glibmm/regex.h>
 
@@ -10,11 +11,13 @@
 struct PrettyTableItem
 {
   Glib::RefPtr<Glib::Regex> command;
+  std::string pattern;
   std::string icon;
 
   PrettyTableItem (const std::string &a_command,
                    const std::string &a_icon)
     : command (Glib::Regex::create (("^(" + a_command + ")$").c_str ())),
+    pattern (a_command),
     icon (a_icon)
   {
   }
@@ -51,4 +54,84 @@ static const PrettyTableItem default_table[] = {
 
 #undef ITEM
 
+/*
+  All the commands of default_table compiled into a single regex, each
+  one as a named alternative.  Alternatives are tried in order, so the
+  first entry matching the whole command wins, as when matching them one
+  by one.  Results are remembered per command.
+*/
+class DefaultTableMatcher
+{
+public:
+  DefaultTableMatcher ()
+  {
+    std::string pattern = "^(?:";
+
+    for (size_t i = 0; i != G_N_ELEMENTS (default_table); ++i)
+      {
+        if (i)
+          pattern += '|';
+        pattern += "(?<i" + std::to_string (i) + ">" + default_table[i].pattern + ")";
+      }
+
+    pattern += ")$";
+
+    regex = Glib::Regex::create (pattern, Glib::Regex::CompileFlags::OPTIMIZE);
+
+    // the entries may have groups of their own
+    for (size_t i = 0; i != G_N_ELEMENTS (default_table); ++i)
+      groups[i] = g_regex_get_string_number (regex->gobj (), ("i" + std::to_string (i)).c_str ());
+  }
+
+  // memoized
+  const PrettyTableItem *
+  match (const std::string &cmd)
+  {
+    const auto [it, inserted] = cache.try_emplace (cmd, nullptr);
+
+    if (inserted)
+      {
+        // process names come and go, do not grow forever
+        if (cache.size () > MAX_CACHED)
+          {
+            cache.clear ();
+            return cache[cmd] = lookup (cmd);
+          }
+        it->second = lookup (cmd);
+      }
+
+    return it->second;
+  }
+
+  const PrettyTableItem *
+  lookup (const std::string &cmd) const
+  {
+    const PrettyTableItem *item = nullptr;
+    GMatchInfo *info = NULL;
+
+    if (g_regex_match (regex->gobj (), cmd.c_str (), GRegexMatchFlags (0), &info))
+      for (size_t i = 0; i != G_N_ELEMENTS (default_table); ++i)
+        {
+          int start = -1, end = -1;
+
+          if (g_match_info_fetch_pos (info, groups[i], &start, &end) && start != -1)
+            {
+              item = &default_table[i];
+              break;
+            }
+        }
+
+    g_match_info_free (info);
+
+    return item;
+  }
+
+private:
+  static const size_t MAX_CACHED = 4096;
+
+  Glib::RefPtr<Glib::Regex> regex;
+  int groups[G_N_ELEMENTS (default_table)];    // number of the group of each entry
+  std::unordered_map<std::string, const PrettyTableItem *> cache;
+};
+
 #endif /* _GSM_DEFAULT_TABLE_H_ */
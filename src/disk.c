@@ -23,6 +23,8 @@ struct _GsmDisk {
   uint64_t available;
   uint64_t used;
   int percentage;
+  /* The usage was asked but did not come in time */
+  gboolean unresponsive;
   char *display_device;
   char *display_directory;
 };
@@ -42,6 +44,7 @@ enum {
   PROP_AVAILABLE,
   PROP_USED,
   PROP_PERCENTAGE,
+  PROP_UNRESPONSIVE,
   PROP_DISPLAY_DEVICE,
   PROP_DISPLAY_DIRECTORY,
   N_PROPS
@@ -101,6 +104,9 @@ gsm_disk_get_property (GObject    *object,
     case PROP_PERCENTAGE:
       g_value_set_int (value, self->percentage);
       break;
+    case PROP_UNRESPONSIVE:
+      g_value_set_boolean (value, self->unresponsive);
+      break;
     case PROP_DISPLAY_DEVICE:
       g_value_set_string (value, self->display_device);
       break;
@@ -166,6 +172,12 @@ gsm_disk_set_property (GObject      *object,
       self->percentage = g_value_get_int (value);
       g_object_notify_by_pspec (object, pspec);
       break;
+    case PROP_UNRESPONSIVE:
+      if (self->unresponsive != g_value_get_boolean (value)) {
+        self->unresponsive = g_value_get_boolean (value);
+        g_object_notify_by_pspec (object, pspec);
+      }
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
   }
@@ -217,6 +229,10 @@ gsm_disk_class_init (GsmDiskClass *klass)
     g_param_spec_int ("percentage", NULL, NULL,
                       0, G_MAXINT, 0,
                       G_PARAM_READWRITE | G_PARAM_EXPLICIT_NOTIFY | G_PARAM_STATIC_STRINGS);
+  properties[PROP_UNRESPONSIVE] =
+    g_param_spec_boolean ("unresponsive", NULL, NULL,
+                          FALSE,
+                          G_PARAM_READWRITE | G_PARAM_EXPLICIT_NOTIFY | G_PARAM_STATIC_STRINGS);
   properties[PROP_DISPLAY_DEVICE] =
     g_param_spec_string ("display-device", NULL, NULL,
                          NULL,
@@ -4,6 +4,9 @@
 
 #include "config.h"
 
+#include <errno.h>
+#include <sys/statvfs.h>
+
 #include <glib/gi18n.h>
 
 #include <gtk/gtk.h>
@@ -13,11 +16,34 @@
 
 #include "column-view-persister.h"
 #include "disk.h"
+#include "gsm-sampler.h"
 #include "settings-keys.h"
 
 #include "disks.h"
 
 
+/* A hung network or FUSE mount blocks statvfs () for minutes, or for
+ * good, so the usage of each mount is asked from a thread and the mount
+ * is shown as not responding past this delay */
+#define FSUSAGE_TIMEOUT_MS 2000
+/* A hung mount keeps its thread, the others still have some */
+#define FSUSAGE_MAX_THREADS 8
+
+
+/* The usage of a mount, asked from the pool */
+typedef struct {
+  GWeakRef view;
+  char *devname;
+  char *mountdir;
+  char *type;
+  GFile *directory;
+  guint deadline;
+  /* Filled by the thread */
+  glibtop_fsusage usage;
+  int saved_errno;
+} FsUsageQuery;
+
+
 struct _GsmDisksView {
   AdwBin parent_instance;
 
@@ -35,6 +61,9 @@ struct _GsmDisksView {
 
   guint timeout;
   GHashTable *known_directories;
+  /* The queries still running, by directory, one at most per mount */
+  GHashTable *queries;
+  GThreadPool *pool;
   GSettings *settings;
   GVolumeMonitor *monitor;
 };
@@ -56,7 +85,7 @@ static inline void
 clear_timeout (GsmDisksView *self)
 {
   g_debug ("disks: clear timeout");
-  g_clear_handle_id (&self->timeout, g_source_remove);
+  g_clear_handle_id (&self->timeout, gsm_sampler_remove);
 }
 
 
@@ -67,6 +96,11 @@ gsm_disks_view_dispose (GObject *object)
 
   clear_timeout (self);
   g_clear_pointer (&self->known_directories, g_hash_table_unref);
+  g_clear_pointer (&self->queries, g_hash_table_unref);
+  /* Without waiting for the threads stuck on a mount */
+  if (self->pool) {
+    g_thread_pool_free (g_steal_pointer (&self->pool), TRUE, FALSE);
+  }
   g_clear_object (&self->settings);
   g_clear_object (&self->monitor);
 
@@ -122,6 +156,35 @@ fsusage_stats (const glibtop_fsusage *buf,
 }
 
 
+static void
+fsusage_query_clear (FsUsageQuery *query)
+{
+  g_weak_ref_clear (&query->view);
+  g_free (query->devname);
+  g_free (query->mountdir);
+  g_free (query->type);
+  g_clear_object (&query->directory);
+}
+
+
+static void
+fsusage_query_unref (gpointer data)
+{
+  g_atomic_rc_box_release_full (data, (GDestroyNotify) fsusage_query_clear);
+}
+
+
+/* Once it is no longer waited for, its thread may still run */
+static void
+fsusage_query_drop (gpointer data)
+{
+  FsUsageQuery *query = data;
+
+  g_clear_handle_id (&query->deadline, g_source_remove);
+  fsusage_query_unref (query);
+}
+
+
 static inline GHashTable *
 get_current_directories (GsmDisksView *self)
 {
@@ -133,12 +196,17 @@ get_current_directories (GsmDisksView *self)
   GHashTableIter iter;
   GFile *directory;
 
-  /* Produce a hashset of the current keys */
+  /* Produce a hashset of the current keys, shown or still asked */
   g_hash_table_iter_init (&iter, self->known_directories);
   while (g_hash_table_iter_next (&iter, (gpointer *) &directory, NULL)) {
     g_hash_table_add (current_directories, g_object_ref (directory));
   }
 
+  g_hash_table_iter_init (&iter, self->queries);
+  while (g_hash_table_iter_next (&iter, (gpointer *) &directory, NULL)) {
+    g_hash_table_add (current_directories, g_object_ref (directory));
+  }
+
   return g_steal_pointer (&current_directories);
 }
 
@@ -156,6 +224,9 @@ drop_leftover_directories (GsmDisksView *self,
     g_autoptr (GsmDisk) disk = NULL;
     guint position;
 
+    /* Its usage, when it comes, is for a mount that is gone */
+    g_hash_table_remove (self->queries, directory);
+
     if (!g_hash_table_steal_extended (self->known_directories,
                                       directory,
                                       (gpointer *) &stolen_key,
@@ -170,60 +241,155 @@ drop_leftover_directories (GsmDisksView *self,
 }
 
 
-static inline void
-handle_entry (GsmDisksView             *self,
-              GPtrArray                *new_disks,
-              GHashTable               *leftover_directories,
-              const glibtop_mountentry *entry)
+/* Shows the usage of the mount of @query, or that it did not come in
+ * time if @usage is NULL, keeping the sizes known before */
+static void
+set_disk_usage (GsmDisksView          *self,
+                FsUsageQuery          *query,
+                const glibtop_fsusage *usage)
 {
-  glibtop_fsusage usage;
-  uint64_t bused, bfree, bavail, btotal;
-  int percentage;
-  g_autoptr (GFile) device = g_file_new_for_path (entry->devname);
-  g_autoptr (GFile) directory = g_file_new_for_path (entry->mountdir);
-  GsmDisk *existing_disk = NULL;
-
-  glibtop_get_fsusage (&usage, entry->mountdir);
-
-  /* If this was already a known directory, save it from being cleaned up */
-  g_hash_table_remove (leftover_directories, directory);
-
-  if (!self->show_all_fs && usage.blocks == 0) {
-    return;
-  }
-
-  fsusage_stats (&usage, &bused, &bfree, &bavail, &btotal, &percentage);
-
+  uint64_t bused = 0, bfree = 0, bavail = 0, btotal = 0;
+  int percentage = 0;
+  g_autoptr (GFile) device = g_file_new_for_path (query->devname);
   /* if we can find a row with the same mountpoint, we get it but we
    * still need to update all the fields.
    * This makes selection persistent.
    */
-  existing_disk = g_hash_table_lookup (self->known_directories, directory);
-  if (existing_disk) {
+  GsmDisk *existing_disk =
+    g_hash_table_lookup (self->known_directories, query->directory);
+
+  if (usage) {
+    if (!self->show_all_fs && usage->blocks == 0) {
+      if (existing_disk) {
+        g_object_set (existing_disk, "unresponsive", FALSE, NULL);
+      }
+      return;
+    }
+
+    fsusage_stats (usage, &bused, &bfree, &bavail, &btotal, &percentage);
+  }
+
+  if (existing_disk && usage) {
     gsm_disk_set_device (existing_disk, device);
     g_object_set (existing_disk,
-                  "type", entry->type,
+                  "type", query->type,
                   "total", btotal,
                   "free", bfree,
                   "available", bavail,
                   "used", bused,
                   "percentage", percentage,
+                  "unresponsive", FALSE,
                   NULL);
+  } else if (existing_disk) {
+    g_object_set (existing_disk, "unresponsive", TRUE, NULL);
   } else {
     g_autoptr (GsmDisk) disk = gsm_disk_new (device,
-                                             directory,
-                                             entry->type,
+                                             query->directory,
+                                             query->type,
                                              btotal,
                                              bfree,
                                              bavail,
                                              bused,
                                              percentage);
 
+    g_object_set (disk, "unresponsive", usage == NULL, NULL);
     g_hash_table_insert (self->known_directories,
-                         g_steal_pointer (&directory),
+                         g_object_ref (query->directory),
                          g_object_ref (disk));
-    g_ptr_array_add (new_disks, g_steal_pointer (&disk));
+    g_list_store_insert (self->list_store, 0, disk);
+  }
+}
+
+
+static gboolean
+fsusage_done (gpointer data)
+{
+  FsUsageQuery *query = data;
+  g_autoptr (GsmDisksView) self = g_weak_ref_get (&query->view);
+
+  /* Unless the view is gone, or the mount, or it was asked again */
+  if (!self || g_hash_table_lookup (self->queries, query->directory) != query) {
+    return G_SOURCE_REMOVE;
+  }
+
+  if (query->saved_errno) {
+    g_debug ("disks: %s: %s", query->mountdir, g_strerror (query->saved_errno));
+  }
+
+  set_disk_usage (self, query, &query->usage);
+  g_hash_table_remove (self->queries, query->directory);
+
+  return G_SOURCE_REMOVE;
+}
+
+
+static gboolean
+fsusage_timed_out (gpointer data)
+{
+  FsUsageQuery *query = data;
+  g_autoptr (GsmDisksView) self = g_weak_ref_get (&query->view);
+
+  query->deadline = 0;
+
+  if (!self || g_hash_table_lookup (self->queries, query->directory) != query) {
+    return G_SOURCE_REMOVE;
+  }
+
+  /* Still waited for, not asked again until it answers */
+  g_debug ("disks: %s not responding", query->mountdir);
+  set_disk_usage (self, query, NULL);
+
+  return G_SOURCE_REMOVE;
+}
+
+
+/* In a thread of the pool, as glibtop_get_fsusage () would: statvfs ()
+ * is all it needs of it and libgtop is not thread safe */
+static void
+query_fsusage (gpointer data,
+               G_GNUC_UNUSED gpointer user_data)
+{
+  FsUsageQuery *query = data;
+  struct statvfs buf;
+
+  if (statvfs (query->mountdir, &buf) == 0) {
+    query->usage.blocks = buf.f_blocks;
+    query->usage.bfree = buf.f_bfree;
+    query->usage.bavail = buf.f_bavail;
+    query->usage.files = buf.f_files;
+    query->usage.ffree = buf.f_ffree;
+    query->usage.block_size = buf.f_frsize;
+  } else {
+    /* Shown as empty, like libgtop does */
+    query->saved_errno = errno;
   }
+
+  /* Handing the reference over */
+  g_idle_add_full (G_PRIORITY_DEFAULT, fsusage_done, query, fsusage_query_unref);
+}
+
+
+static void
+ask_fsusage (GsmDisksView             *self,
+             const glibtop_mountentry *entry,
+             GFile                    *directory)
+{
+  FsUsageQuery *query = g_atomic_rc_box_new0 (FsUsageQuery);
+
+  g_weak_ref_init (&query->view, self);
+  query->devname = g_strdup (entry->devname);
+  query->mountdir = g_strdup (entry->mountdir);
+  query->type = g_strdup (entry->type);
+  query->directory = g_object_ref (directory);
+  query->deadline = g_timeout_add_full (G_PRIORITY_DEFAULT,
+                                        FSUSAGE_TIMEOUT_MS,
+                                        fsusage_timed_out,
+                                        g_atomic_rc_box_acquire (query),
+                                        fsusage_query_unref);
+
+  /* The table has its reference, the thread has another */
+  g_hash_table_insert (self->queries, g_object_ref (directory), query);
+  g_thread_pool_push (self->pool, g_atomic_rc_box_acquire (query), NULL);
 }
 
 
@@ -233,21 +399,22 @@ disks_update (GsmDisksView *self)
   g_autoptr (GHashTable) leftover_directories =
     get_current_directories (self);
   g_autofree glibtop_mountentry *entries;
-  g_autoptr (GPtrArray) new_disks =
-    g_ptr_array_new_null_terminated (10, g_object_unref, TRUE);
   glibtop_mountlist mountlist;
 
   entries = glibtop_get_mountlist (&mountlist, self->show_all_fs);
 
   for (guint i = 0; i < mountlist.number; i++) {
-    handle_entry (self, new_disks, leftover_directories, &entries[i]);
-  }
+    g_autoptr (GFile) directory = g_file_new_for_path (entries[i].mountdir);
 
-  g_list_store_splice (self->list_store,
-                       0,
-                       0,
-                       new_disks->pdata,
-                       new_disks->len);
+    /* If this was already a known directory, save it from being cleaned up */
+    g_hash_table_remove (leftover_directories, directory);
+
+    /* The rows are updated as the answers come, a mount that has not
+     * answered yet is not asked again */
+    if (!g_hash_table_contains (self->queries, directory)) {
+      ask_fsusage (self, &entries[i], directory);
+    }
+  }
 
   drop_leftover_directories (self, leftover_directories);
 }
@@ -272,9 +439,7 @@ setup_timeout (GsmDisksView *self, gboolean reset)
   clear_timeout (self);
 
   g_debug ("disks: start timeout");
-  g_clear_handle_id (&self->timeout, g_source_remove);
-  self->timeout = g_timeout_add (self->update_interval, disks_timeout, self);
-  g_source_set_name_by_id (self->timeout, "refresh disks");
+  self->timeout = gsm_sampler_add (self->update_interval, disks_timeout, self);
   disks_update (self);
 }
 
@@ -355,6 +520,14 @@ format_size (G_GNUC_UNUSED GObject *object,
 }
 
 
+static char *
+format_unresponsive (G_GNUC_UNUSED GObject *object,
+                     gboolean               unresponsive)
+{
+  return unresponsive ? g_strdup (_("Not responding")) : NULL;
+}
+
+
 static char *
 format_percentage (G_GNUC_UNUSED GObject *object,
                    int                    percentage)
@@ -436,6 +609,7 @@ gsm_disks_view_class_init (GsmDisksViewClass *klass)
 
   gtk_widget_class_bind_template_callback (widget_class, format_size);
   gtk_widget_class_bind_template_callback (widget_class, format_percentage);
+  gtk_widget_class_bind_template_callback (widget_class, format_unresponsive);
   gtk_widget_class_bind_template_callback (widget_class, activate_disk);
 
   g_type_ensure (GSM_TYPE_COLUMN_VIEW_PERSISTER);
@@ -466,6 +640,16 @@ gsm_disks_view_init (GsmDisksView *self)
                                                    (GEqualFunc) g_file_equal,
                                                    g_object_unref,
                                                    g_object_unref);
+  self->queries = g_hash_table_new_full (g_file_hash,
+                                         (GEqualFunc) g_file_equal,
+                                         g_object_unref,
+                                         fsusage_query_drop);
+  self->pool = g_thread_pool_new_full (query_fsusage,
+                                       NULL,
+                                       fsusage_query_unref,
+                                       FSUSAGE_MAX_THREADS,
+                                       FALSE,
+                                       NULL);
 
   self->settings = g_settings_new (GSM_GSETTINGS_SCHEMA);
 
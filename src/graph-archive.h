@@ -0,0 +1,171 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#pragma once
+
+#include <glib.h>
+
+#include <algorithm>
+#include <initializer_list>
+#include <vector>
+
+struct GraphArchiveTier
+{
+  guint seconds;                // duration of a bucket
+  guint buckets;                // number of buckets kept
+};
+
+/*
+ * History of the values of a graph at coarser resolutions than the
+ * GraphHistory of the raw points, with a fixed memory use.
+ *
+ * Every tier sums the values up in buckets of a fixed duration, keeping
+ * their min, max and mean, and keeps its latest buckets in a ring.  The
+ * values are added to every tier as they come in, a bucket is complete
+ * as soon as its time is over.  The buckets of a tier are addressed by
+ * their age: 0 is the current one, the one still being filled.
+ */
+class GraphArchive
+{
+public:
+  static constexpr gint64 NO_BUCKET = G_MININT64;
+
+  struct Bucket
+  {
+    float min;
+    float max;
+    float sum;
+    guint32 count;
+
+    float
+    mean () const
+    {
+      return count ? sum / count : -1.0f;
+    }
+  };
+
+  GraphArchive ()
+    : n_series (0),
+    rings ()
+  {
+  }
+
+  GraphArchive (guint                                   series,
+                std::initializer_list<GraphArchiveTier> tiers)
+    : n_series (series),
+    rings ()
+  {
+    for (const auto &tier : tiers)
+      rings.push_back ({ tier, NO_BUCKET, 0, std::vector<Bucket>(series * tier.buckets, EMPTY) });
+  }
+
+  guint
+  series () const
+  {
+    return n_series;
+  }
+
+  guint
+  n_tiers () const
+  {
+    return rings.size ();
+  }
+
+  const GraphArchiveTier &
+  tier (guint t) const
+  {
+    return rings[t].tier;
+  }
+
+  // number of the current bucket of tier @t since the clock started,
+  // NO_BUCKET before the first value
+  gint64
+  latest_bucket (guint t) const
+  {
+    return rings[t].current;
+  }
+
+  // adds the values of every series taken at @time, in microseconds of
+  // a clock that does not go back, a negative value meaning no value
+  void
+  add (gint64       time,
+       const float *values)
+  {
+    for (auto &ring : rings)
+      {
+        const gint64 duration = G_USEC_PER_SEC * gint64 (ring.tier.seconds);
+        // rounded down, for the times before the clock started too
+        const gint64 current = time >= 0 ? time / duration : (time + 1) / duration - 1;
+
+        if (ring.current == NO_BUCKET)
+          ring.current = current;
+
+        if (G_UNLIKELY (current < ring.current))
+          continue;
+
+        // empties the buckets of the time without values too
+        for (gint64 k = std::min (current - ring.current, gint64 (ring.tier.buckets)); k > 0; k--)
+          {
+            ring.head = ring.head + 1 == ring.tier.buckets ? 0 : ring.head + 1;
+            for (guint j = 0; j < n_series; j++)
+              ring.buckets[j * ring.tier.buckets + ring.head] = EMPTY;
+          }
+        ring.current = current;
+
+        for (guint j = 0; j < n_series; j++)
+          {
+            Bucket &b = ring.buckets[j * ring.tier.buckets + ring.head];
+            const float value = values[j];
+
+            if (value < 0.0f)
+              continue;
+
+            if (b.count == 0)
+              b.min = b.max = value;
+
+            b.min = std::min (b.min, value);
+            b.max = std::max (b.max, value);
+            b.sum += value;
+            b.count++;
+          }
+      }
+  }
+
+  // drops every value, when they change meaning
+  void
+  clear ()
+  {
+    for (auto &ring : rings)
+      {
+        ring.current = NO_BUCKET;
+        ring.head = 0;
+        std::fill (ring.buckets.begin (), ring.buckets.end (), EMPTY);
+      }
+  }
+
+  const Bucket &
+  get (guint t,
+       guint series,
+       guint age) const
+  {
+    const Ring &ring = rings[t];
+    const guint slot = age <= ring.head ? ring.head - age : ring.head + ring.tier.buckets - age;
+
+    return ring.buckets[series * ring.tier.buckets + slot];
+  }
+
+private:
+  static constexpr Bucket EMPTY = { 0.0f, 0.0f, 0.0f, 0 };
+
+  struct Ring
+  {
+    GraphArchiveTier tier;
+    gint64 current;
+    guint head;
+    std::vector<Bucket> buckets;
+  };
+
+  guint n_series;
+  std::vector<Ring> rings;
+};
@@ -0,0 +1,227 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#pragma once
+
+#include <glib.h>
+
+#include <algorithm>
+#include <vector>
+
+/*
+ * Fixed size history of the values of a graph, -1.0 meaning no value.
+ *
+ * The values are kept in a ring, one contiguous run of points per series,
+ * and addressed by their age: 0 is the latest point, size () - 1 the
+ * oldest one.  Adding a point only moves the head.
+ */
+class GraphHistory
+{
+public:
+  GraphHistory ()
+    : n_series (0),
+    n_points (0),
+    head (0),
+    n_pushed (0),
+    values ()
+  {
+  }
+
+  GraphHistory (guint series,
+                guint points)
+    : n_series (series),
+    n_points (points),
+    head (0),
+    n_pushed (0),
+    values (std::vector<double>(series * points, -1.0))
+  {
+  }
+
+  guint
+  size () const
+  {
+    return n_points;
+  }
+
+  // absolute index of the latest point, it grows by one with each push ()
+  guint64
+  latest_index () const
+  {
+    return n_pushed;
+  }
+
+  // makes room for a new latest point, dropping the oldest one
+  void
+  push ()
+  {
+    if (G_UNLIKELY (n_points == 0))
+      return;
+
+    n_pushed++;
+
+    head = head + 1 == n_points ? 0 : head + 1;
+
+    for (guint j = 0; j < n_series; j++)
+      values[j * n_points + head] = -1.0;
+  }
+
+  double &
+  at (guint series,
+      guint age)
+  {
+    return values[series * n_points + slot (age)];
+  }
+
+  double
+  at (guint series,
+      guint age) const
+  {
+    return values[series * n_points + slot (age)];
+  }
+
+  // Calls @func (age, value) on the points of @series, from the latest to
+  // the oldest one.
+  template<typename Func>
+  void
+  foreach (guint series,
+           Func  func) const
+  {
+    const double *run = &values[series * n_points];
+    guint age = 0;
+
+    for (guint i = head + 1; i-- > 0; age++)
+      func (age, run[i]);
+    for (guint i = n_points; i-- > head + 1; age++)
+      func (age, run[i]);
+  }
+
+  void
+  reset ()
+  {
+    std::fill (values.begin (), values.end (), -1.0);
+  }
+
+  // keeps the latest points, new ones are empty
+  void
+  resize (guint points)
+  {
+    std::vector<double> resized (n_series * points, -1.0);
+    const guint kept = std::min (points, n_points);
+
+    // the latest point ends up at kept - 1, the head of the new ring
+    for (guint j = 0; j < n_series; j++)
+      for (guint age = 0; age < kept; age++)
+        resized[j * points + kept - 1 - age] = at (j, age);
+
+    values.swap (resized);
+    n_points = points;
+    head = kept ? kept - 1 : 0;
+  }
+
+private:
+  guint
+  slot (guint age) const
+  {
+    return age <= head ? head - age : head + n_points - age;
+  }
+
+  guint n_series;
+  guint n_points;
+  guint head;
+  guint64 n_pushed;
+  std::vector<double> values;
+};
+
+/*
+ * Min/max summary of runs of consecutive points of a GraphHistory, to
+ * draw histories having more points than pixels.  Bucket b holds the
+ * points of absolute index b * points_per_bucket () + 1 to
+ * (b + 1) * points_per_bucket (), the last buckets are kept in a ring.
+ */
+class GraphBuckets
+{
+public:
+  struct Bucket
+  {
+    double min;
+    double max;
+    double first;
+    double last;
+  };
+
+  GraphBuckets ()
+    : n_series (0),
+    n_buckets (0),
+    per_bucket (1),
+    buckets ()
+  {
+  }
+
+  GraphBuckets (guint series,
+                guint count,
+                guint points_per_bucket)
+    : n_series (series),
+    n_buckets (count),
+    per_bucket (points_per_bucket),
+    buckets (std::vector<Bucket>(series * count, EMPTY))
+  {
+  }
+
+  guint
+  points_per_bucket () const
+  {
+    return per_bucket;
+  }
+
+  guint64
+  bucket_of (guint64 index) const
+  {
+    return (index - 1) / per_bucket;
+  }
+
+  // adds the point of absolute @index of @history, the points of a bucket
+  // being added in order
+  void
+  add (const GraphHistory &history,
+       guint64             index)
+  {
+    const guint64 bucket = bucket_of (index);
+    const guint age = history.latest_index () - index;
+
+    for (guint j = 0; j < n_series; j++)
+      {
+        Bucket &b = buckets[j * n_buckets + bucket % n_buckets];
+        const double value = history.at (j, age);
+
+        // first point of the bucket, the slot held an older one
+        if ((index - 1) % per_bucket == 0)
+          b = EMPTY;
+
+        if (value == -1.0)
+          continue;
+
+        if (b.first == -1.0)
+          b = { value, value, value, value };
+
+        b.min = std::min (b.min, value);
+        b.max = std::max (b.max, value);
+        b.last = value;
+      }
+  }
+
+  const Bucket &
+  get (guint   series,
+       guint64 bucket) const
+  {
+    return buckets[series * n_buckets + bucket % n_buckets];
+  }
+
+private:
+  static constexpr Bucket EMPTY = { -1.0, -1.0, -1.0, -1.0 };
+
+  guint n_series;
+  guint n_buckets;
+  guint per_bucket;
+  std::vector<Bucket> buckets;
+};
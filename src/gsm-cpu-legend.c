@@ -0,0 +1,314 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include <config.h>
+
+#include <math.h>
+#include <string.h>
+
+#include <glib/gi18n.h>
+
+#include "gsm-cpu-legend.h"
+
+#define SWATCH_SIZE 12
+#define SPACING 4
+#define COLUMN_SPACING 12
+/* One layout per tenth of a percent */
+#define N_VALUES 1001
+
+struct _GsmCpuLegend
+{
+  GtkWidget parent_instance;
+
+  guint n_cpus;
+  GdkRGBA *colors;
+  float *loads;
+  gboolean heatmap;
+
+  /* The text only depends on the CPU and on the rounded load, so every
+   * layout is made once and drawn again as long as the font stays */
+  PangoLayout **names;
+  PangoLayout *values[N_VALUES];
+  PangoAttrList *tnum;
+  int name_width;
+  int value_width;
+  int line_height;
+};
+
+G_DEFINE_FINAL_TYPE (GsmCpuLegend, gsm_cpu_legend, GTK_TYPE_WIDGET)
+
+static const struct
+{
+  float load;
+  GdkRGBA color;
+} heat_stops[] = {
+  { 0.00f, { 0.208f, 0.518f, 0.894f, 0.00f } },
+  { 0.25f, { 0.208f, 0.518f, 0.894f, 0.60f } },
+  { 0.60f, { 0.965f, 0.827f, 0.176f, 0.85f } },
+  { 1.00f, { 0.878f, 0.106f, 0.141f, 1.00f } },
+};
+
+void
+gsm_cpu_legend_heat_color (float    load,
+                           GdkRGBA *color)
+{
+  guint i;
+
+  load = CLAMP (load, 0.0f, 1.0f);
+
+  for (i = 1; i < G_N_ELEMENTS (heat_stops) - 1 && load > heat_stops[i].load; i++)
+    ;
+
+  const GdkRGBA *from = &heat_stops[i - 1].color;
+  const GdkRGBA *to = &heat_stops[i].color;
+  const float t = (load - heat_stops[i - 1].load) / (heat_stops[i].load - heat_stops[i - 1].load);
+
+  color->red = from->red + t * (to->red - from->red);
+  color->green = from->green + t * (to->green - from->green);
+  color->blue = from->blue + t * (to->blue - from->blue);
+  color->alpha = from->alpha + t * (to->alpha - from->alpha);
+}
+
+static void
+gsm_cpu_legend_clear_layouts (GsmCpuLegend *self)
+{
+  if (self->names)
+    {
+      for (guint i = 0; i < self->n_cpus; i++)
+        g_object_unref (self->names[i]);
+      g_clear_pointer (&self->names, g_free);
+    }
+
+  for (guint i = 0; i < N_VALUES; i++)
+    g_clear_object (&self->values[i]);
+}
+
+static PangoLayout *
+gsm_cpu_legend_get_value (GsmCpuLegend *self,
+                          float         load)
+{
+  const guint permille = lrintf (CLAMP (load, 0.0f, 1.0f) * 1000.0f);
+
+  if (!self->values[permille])
+    {
+      // Translators: CPU usage percentage label: 95.7%
+      gchar *text = g_strdup_printf (_("%.1f%%"), permille / 10.0);
+
+      self->values[permille] = gtk_widget_create_pango_layout (GTK_WIDGET (self), text);
+      pango_layout_set_attributes (self->values[permille], self->tnum);
+      g_free (text);
+    }
+
+  return self->values[permille];
+}
+
+static void
+gsm_cpu_legend_ensure_layouts (GsmCpuLegend *self)
+{
+  int width, height;
+
+  if (self->names)
+    return;
+
+  self->names = g_new (PangoLayout *, self->n_cpus);
+  self->name_width = 0;
+  self->line_height = SWATCH_SIZE;
+
+  for (guint i = 0; i < self->n_cpus; i++)
+    {
+      gchar *text = self->n_cpus == 1 ? g_strdup (_("CPU")) : g_strdup_printf (_("CPU%d"), i + 1);
+
+      self->names[i] = gtk_widget_create_pango_layout (GTK_WIDGET (self), text);
+      g_free (text);
+
+      pango_layout_get_pixel_size (self->names[i], &width, &height);
+      self->name_width = MAX (self->name_width, width);
+      self->line_height = MAX (self->line_height, height);
+    }
+
+  pango_layout_get_pixel_size (gsm_cpu_legend_get_value (self, 1.0f), &width, &height);
+  self->value_width = width;
+  self->line_height = MAX (self->line_height, height) + 2;
+}
+
+static int
+gsm_cpu_legend_entry_width (GsmCpuLegend *self)
+{
+  gsm_cpu_legend_ensure_layouts (self);
+
+  return SWATCH_SIZE + SPACING + self->name_width + SPACING + self->value_width + COLUMN_SPACING;
+}
+
+static guint
+gsm_cpu_legend_columns (GsmCpuLegend *self,
+                        int           width)
+{
+  const guint columns = (width + COLUMN_SPACING) / gsm_cpu_legend_entry_width (self);
+
+  return CLAMP (columns, 1, MAX (self->n_cpus, 1));
+}
+
+static void
+gsm_cpu_legend_measure (GtkWidget      *widget,
+                        GtkOrientation  orientation,
+                        int             for_size,
+                        int            *minimum,
+                        int            *natural,
+                        int            *minimum_baseline,
+                        int            *natural_baseline)
+{
+  GsmCpuLegend *self = GSM_CPU_LEGEND (widget);
+  const int entry_width = gsm_cpu_legend_entry_width (self);
+
+  if (orientation == GTK_ORIENTATION_HORIZONTAL)
+    {
+      *minimum = entry_width - COLUMN_SPACING;
+      *natural = MIN (self->n_cpus, 8) * entry_width - COLUMN_SPACING;
+    }
+  else
+    {
+      const guint columns = for_size < 0 ? MIN (self->n_cpus, 8) : gsm_cpu_legend_columns (self, for_size);
+      const guint rows = (self->n_cpus + columns - 1) / columns;
+
+      *minimum = *natural = rows * self->line_height;
+    }
+}
+
+static GtkSizeRequestMode
+gsm_cpu_legend_get_request_mode (GtkWidget *)
+{
+  return GTK_SIZE_REQUEST_HEIGHT_FOR_WIDTH;
+}
+
+static void
+gsm_cpu_legend_snapshot (GtkWidget   *widget,
+                         GtkSnapshot *snapshot)
+{
+  GsmCpuLegend *self = GSM_CPU_LEGEND (widget);
+  const int entry_width = gsm_cpu_legend_entry_width (self);
+  const guint columns = gsm_cpu_legend_columns (self, gtk_widget_get_width (widget));
+  const guint rows = (self->n_cpus + columns - 1) / columns;
+  GdkRGBA foreground;
+
+  gtk_widget_get_color (widget, &foreground);
+
+  for (guint i = 0; i < self->n_cpus; i++)
+    {
+      /* Column after column, like the former grid of labels */
+      const float x = (i / rows) * entry_width;
+      const float y = (i % rows) * self->line_height;
+      graphene_rect_t swatch;
+      GdkRGBA color;
+      PangoLayout *value = gsm_cpu_legend_get_value (self, self->loads[i]);
+      int value_width;
+
+      if (self->heatmap)
+        gsm_cpu_legend_heat_color (self->loads[i], &color);
+      else
+        color = self->colors[i];
+
+      graphene_rect_init (&swatch, x, y + (self->line_height - SWATCH_SIZE) / 2, SWATCH_SIZE, SWATCH_SIZE);
+      gtk_snapshot_append_color (snapshot, &color, &swatch);
+
+      gtk_snapshot_save (snapshot);
+      gtk_snapshot_translate (snapshot, &GRAPHENE_POINT_INIT (x + SWATCH_SIZE + SPACING, y + 1));
+      gtk_snapshot_append_layout (snapshot, self->names[i], &foreground);
+      gtk_snapshot_restore (snapshot);
+
+      /* Right aligned, the digits are tabular */
+      pango_layout_get_pixel_size (value, &value_width, NULL);
+      gtk_snapshot_save (snapshot);
+      gtk_snapshot_translate (snapshot,
+                              &GRAPHENE_POINT_INIT (x + entry_width - COLUMN_SPACING - value_width, y + 1));
+      gtk_snapshot_append_layout (snapshot, value, &foreground);
+      gtk_snapshot_restore (snapshot);
+    }
+}
+
+static void
+gsm_cpu_legend_css_changed (GtkWidget         *widget,
+                            GtkCssStyleChange *change)
+{
+  GTK_WIDGET_CLASS (gsm_cpu_legend_parent_class)->css_changed (widget, change);
+
+  gsm_cpu_legend_clear_layouts (GSM_CPU_LEGEND (widget));
+  gtk_widget_queue_resize (widget);
+}
+
+static void
+gsm_cpu_legend_finalize (GObject *object)
+{
+  GsmCpuLegend *self = GSM_CPU_LEGEND (object);
+
+  gsm_cpu_legend_clear_layouts (self);
+  pango_attr_list_unref (self->tnum);
+  g_free (self->colors);
+  g_free (self->loads);
+
+  G_OBJECT_CLASS (gsm_cpu_legend_parent_class)->finalize (object);
+}
+
+static void
+gsm_cpu_legend_class_init (GsmCpuLegendClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  GtkWidgetClass *widget_class = GTK_WIDGET_CLASS (klass);
+
+  object_class->finalize = gsm_cpu_legend_finalize;
+  widget_class->measure = gsm_cpu_legend_measure;
+  widget_class->get_request_mode = gsm_cpu_legend_get_request_mode;
+  widget_class->snapshot = gsm_cpu_legend_snapshot;
+  widget_class->css_changed = gsm_cpu_legend_css_changed;
+
+  gtk_widget_class_set_css_name (widget_class, "cpulegend");
+}
+
+static void
+gsm_cpu_legend_init (GsmCpuLegend *self)
+{
+  self->tnum = pango_attr_list_new ();
+  pango_attr_list_insert (self->tnum, pango_attr_font_features_new ("tnum=1"));
+}
+
+GsmCpuLegend *
+gsm_cpu_legend_new (guint n_cpus)
+{
+  GsmCpuLegend *self = g_object_new (GSM_TYPE_CPU_LEGEND, NULL);
+
+  self->n_cpus = n_cpus;
+  self->colors = g_new0 (GdkRGBA, n_cpus);
+  self->loads = g_new0 (float, n_cpus);
+
+  return self;
+}
+
+void
+gsm_cpu_legend_set_colors (GsmCpuLegend  *self,
+                           const GdkRGBA *colors)
+{
+  g_return_if_fail (GSM_IS_CPU_LEGEND (self));
+
+  memcpy (self->colors, colors, self->n_cpus * sizeof *colors);
+  gtk_widget_queue_draw (GTK_WIDGET (self));
+}
+
+void
+gsm_cpu_legend_set_loads (GsmCpuLegend *self,
+                          const float  *loads)
+{
+  g_return_if_fail (GSM_IS_CPU_LEGEND (self));
+
+  memcpy (self->loads, loads, self->n_cpus * sizeof *loads);
+  gtk_widget_queue_draw (GTK_WIDGET (self));
+}
+
+void
+gsm_cpu_legend_set_heatmap (GsmCpuLegend *self,
+                            gboolean      heatmap)
+{
+  g_return_if_fail (GSM_IS_CPU_LEGEND (self));
+
+  self->heatmap = heatmap;
+  gtk_widget_queue_draw (GTK_WIDGET (self));
+}
@@ -0,0 +1,36 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#pragma once
+
+#include <gtk/gtk.h>
+
+G_BEGIN_DECLS
+
+/*
+ * Legend of the CPU graph drawn as a single widget: a swatch, the name and
+ * the usage of every CPU, flowing in as many columns as fit in the width.
+ * Used instead of a color picker and two labels per CPU on machines with
+ * many of them.
+ */
+#define GSM_TYPE_CPU_LEGEND (gsm_cpu_legend_get_type ())
+G_DECLARE_FINAL_TYPE (GsmCpuLegend, gsm_cpu_legend, GSM, CPU_LEGEND, GtkWidget)
+
+GsmCpuLegend * gsm_cpu_legend_new (guint n_cpus);
+
+/* @colors and @loads hold one entry per CPU, loads between 0 and 1 */
+void           gsm_cpu_legend_set_colors (GsmCpuLegend  *self,
+                                          const GdkRGBA *colors);
+void           gsm_cpu_legend_set_loads (GsmCpuLegend *self,
+                                         const float  *loads);
+
+/* Whether the swatches show the heat of the CPUs rather than their color */
+void           gsm_cpu_legend_set_heatmap (GsmCpuLegend *self,
+                                           gboolean      heatmap);
+
+/* Color of a load between 0 and 1 in the CPU heatmap */
+void           gsm_cpu_legend_heat_color (float    load,
+                                          GdkRGBA *color);
+
+G_END_DECLS
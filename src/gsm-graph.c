@@ -19,6 +19,7 @@
  */
 
 #include "gsm-graph.h"
+#include "gsm-sampler.h"
 #include "glib.h"
 
 #include <glib/gi18n.h>
@@ -51,6 +52,9 @@ static GParamSpec* obj_properties[NUM_PROPS] = {
 
 G_DEFINE_TYPE_WITH_CODE (GsmGraph, gsm_graph, GTK_TYPE_DRAWING_AREA, G_ADD_PRIVATE(GsmGraph))
 
+static void gsm_graph_map (GtkWidget *widget);
+static void gsm_graph_unmap (GtkWidget *widget);
+
 static void
 gsm_graph_css_changed (GtkWidget *widget,
                        GtkCssStyleChange*)
@@ -139,6 +143,8 @@ gsm_graph_class_init (GsmGraphClass *klass)
   GtkWidgetClass *widget_class = GTK_WIDGET_CLASS (klass);
 
   widget_class->css_changed = gsm_graph_css_changed;
+  widget_class->map = gsm_graph_map;
+  widget_class->unmap = gsm_graph_unmap;
 
   object_class->set_property = gsm_graph_set_property;
   object_class->get_property = gsm_graph_get_property;
@@ -187,8 +193,7 @@ gsm_graph_dispose (GObject *self)
   if (priv->background)
     cairo_surface_destroy (priv->background);
 
-  if (priv->redraw_timeout)
-    g_source_remove (priv->redraw_timeout);
+  g_clear_handle_id (&priv->sample_timeout, gsm_sampler_remove);
 
   G_OBJECT_CLASS (gsm_graph_parent_class)->dispose (G_OBJECT (self));
 }
@@ -203,35 +208,112 @@ gsm_graph_finalize (GObject *self)
 }
 
 static void
-_gsm_graph_state_flags_changed (GtkWidget *widget,
+_gsm_graph_state_flags_changed (GtkWidget *,
                                 GtkStateFlags*,
                                 gpointer   self)
 {
-  GsmGraph *graph = GSM_GRAPH (self);
+  gsm_graph_force_refresh (GSM_GRAPH (self));
+}
+
+/*
+ * The lines move by frames_per_unit steps between two samples, paced by
+ * the frame clock.  The tick callback only runs while a step is left to
+ * draw, so that a still or hidden graph doesn't wake the frame clock up.
+ */
+static gboolean
+_gsm_graph_tick (GtkWidget     *widget,
+                 GdkFrameClock *frame_clock,
+                 gpointer)
+{
+  GsmGraphPrivate *priv = gsm_graph_get_instance_private (GSM_GRAPH (widget));
+  const guint last = MAX (priv->frames_per_unit, 1) - 1;
+  const gint64 elapsed = MAX (gdk_frame_clock_get_frame_time (frame_clock) - priv->sample_time, 0);
+  const guint counter = MIN (elapsed * (last + 1) / (priv->speed * 1000), last);
 
-  gsm_graph_force_refresh (graph);
-  if (gtk_widget_is_visible (widget))
-    gsm_graph_start (graph);
-  else
-    gsm_graph_stop (graph);
+  if (counter != priv->render_counter)
+    {
+      priv->render_counter = counter;
+      gtk_widget_queue_draw (widget);
+    }
+
+  if (counter < last)
+    return G_SOURCE_CONTINUE;
+
+  priv->tick_id = 0;
+  return G_SOURCE_REMOVE;
+}
+
+static void
+_gsm_graph_update_tick (GsmGraph *self)
+{
+  GsmGraphPrivate *priv = gsm_graph_get_instance_private (self);
+  const gboolean animate = priv->draw && gtk_widget_get_mapped (GTK_WIDGET (self));
+
+  if (animate && priv->tick_id == 0)
+    priv->tick_id = gtk_widget_add_tick_callback (GTK_WIDGET (self), _gsm_graph_tick, NULL, NULL);
+  else if (!animate && priv->tick_id != 0)
+    {
+      gtk_widget_remove_tick_callback (GTK_WIDGET (self), priv->tick_id);
+      priv->tick_id = 0;
+    }
+}
+
+static void
+_gsm_graph_sample (GsmGraph *self)
+{
+  GsmGraphPrivate *priv = gsm_graph_get_instance_private (self);
+
+  priv->data_function (priv->update_data);
+  priv->sample_time = g_get_monotonic_time ();
+  priv->render_counter = 0;
+
+  if (gsm_graph_is_started (self) && gtk_widget_get_mapped (GTK_WIDGET (self)))
+    {
+      gtk_widget_queue_draw (GTK_WIDGET (self));
+      _gsm_graph_update_tick (self);
+    }
 }
 
 static gboolean
-_gsm_graph_update (GsmGraph *self)
+_gsm_graph_sample_timeout (GsmGraph *self)
+{
+  _gsm_graph_sample (self);
+
+  return G_SOURCE_CONTINUE;
+}
+
+static void
+_gsm_graph_restart_sampling (GsmGraph *self)
 {
   GsmGraphPrivate *priv = gsm_graph_get_instance_private (self);
-  if (priv->render_counter == priv->frames_per_unit - 1)
-    priv->data_function (priv->update_data);
 
-  if (gsm_graph_is_started (self))
-    gtk_widget_queue_draw (GTK_WIDGET (self));
+  g_clear_handle_id (&priv->sample_timeout, gsm_sampler_remove);
+  priv->sample_timeout = gsm_sampler_add (priv->speed,
+                                          (GSourceFunc)_gsm_graph_sample_timeout,
+                                          self);
+}
 
-  priv->render_counter++;
+static void
+gsm_graph_map (GtkWidget *widget)
+{
+  GTK_WIDGET_CLASS (gsm_graph_parent_class)->map (widget);
 
-  if (priv->render_counter >= priv->frames_per_unit)
-    priv->render_counter = 0;
+  _gsm_graph_update_tick (GSM_GRAPH (widget));
+}
 
-  return TRUE;
+static void
+gsm_graph_unmap (GtkWidget *widget)
+{
+  GsmGraphPrivate *priv = gsm_graph_get_instance_private (GSM_GRAPH (widget));
+
+  // hidden behind another page or in a collapsed section
+  if (priv->tick_id)
+    {
+      gtk_widget_remove_tick_callback (widget, priv->tick_id);
+      priv->tick_id = 0;
+    }
+
+  GTK_WIDGET_CLASS (gsm_graph_parent_class)->unmap (widget);
 }
 
 static void
@@ -323,19 +405,11 @@ void gsm_graph_set_speed (GsmGraph *self, guint speed)
 {
   g_return_if_fail (GSM_IS_GRAPH (self));
   GsmGraphPrivate *priv = gsm_graph_get_instance_private (self);
-  guint drawing_refresh_speed = speed;
 
   if (priv->speed != speed) {
     priv->speed = speed;
-    if (priv->redraw_timeout) {
-      g_source_remove (priv->redraw_timeout);
-      if (priv->frames_per_unit && (priv->frames_per_unit > 0)) {
-        drawing_refresh_speed = (speed / priv->frames_per_unit);
-      }
-      priv->redraw_timeout = g_timeout_add (drawing_refresh_speed,
-                                            (GSourceFunc)_gsm_graph_update,
-                                            self);
-    }
+    if (priv->sample_timeout)
+      _gsm_graph_restart_sampling (self);
     gsm_graph_clear_background (self);
   }
 }
@@ -344,23 +418,12 @@ void gsm_graph_set_data_function (GsmGraph *self, GSourceFunc function, gpointer
 {
   g_return_if_fail (GSM_IS_GRAPH (self));
   GsmGraphPrivate *priv = gsm_graph_get_instance_private (self);
-  guint drawing_refresh_speed = priv->speed;
-
-  if (priv->redraw_timeout) {
-    g_source_remove (priv->redraw_timeout);
-  }
 
   priv->data_function = function;
   priv->update_data = data;
 
-  if (gsm_graph_is_started (self)) {
-    if (priv->frames_per_unit && (priv->frames_per_unit > 0)) {
-      drawing_refresh_speed = (priv->speed / priv->frames_per_unit);
-    }
-    priv->redraw_timeout = g_timeout_add (drawing_refresh_speed,
-                                          (GSourceFunc)_gsm_graph_update,
-                                          self);
-  }
+  if (priv->sample_timeout)
+    _gsm_graph_restart_sampling (self);
 }
 
 
@@ -375,7 +438,7 @@ run_data_function (GsmGraph *self)
 
   g_return_if_fail (priv->data_function != NULL);
 
-  priv->data_function (priv->update_data);
+  _gsm_graph_sample (self);
 
   g_object_unref (self);
 }
@@ -386,30 +449,21 @@ gsm_graph_start (GsmGraph *self)
 {
   _gsm_graph_set_draw (self, TRUE);
   GsmGraphPrivate *priv = gsm_graph_get_instance_private (self);
-  guint drawing_refresh_speed = priv->speed;
   g_return_if_fail ( priv->data_function != NULL);
 
-  if (priv->redraw_timeout == 0)
+  if (priv->sample_timeout == 0)
     {
       // space 2 calls with a small time interval so there's a delta for the CPU load graph
       g_timeout_add_once (300,
                           (GSourceOnceFunc) run_data_function,
                           g_object_ref (self));
 
-      priv->data_function(priv->update_data);
-      priv->redraw_timeout = g_timeout_add (priv->speed,
-                                            (GSourceFunc)_gsm_graph_update,
-                                            self);
-  }
-  if (priv->redraw_timeout) {
-    g_source_remove (priv->redraw_timeout);
-  }
-  if (priv->frames_per_unit && (priv->frames_per_unit > 0)) {
-    drawing_refresh_speed = (priv->speed / priv->frames_per_unit);
-  }
-  priv->redraw_timeout = g_timeout_add (drawing_refresh_speed,
-                                        (GSourceFunc)_gsm_graph_update,
-                                        self);
+      _gsm_graph_sample (self);
+      _gsm_graph_restart_sampling (self);
+    }
+
+  _gsm_graph_update_tick (self);
+  gtk_widget_queue_draw (GTK_WIDGET (self));
 }
 
 void
@@ -495,6 +549,7 @@ void
 gsm_graph_stop (GsmGraph *self)
 {
   _gsm_graph_set_draw (self, FALSE);
+  _gsm_graph_update_tick (self);
 }
 
 gboolean
@@ -47,13 +47,18 @@ struct _GsmGraphPrivate
   
   guint render_counter;
   guint frames_per_unit;
-  guint redraw_timeout;
+  // samples the data every speed ms, whether the graph is drawn or not
+  guint sample_timeout;
+  // moves the lines between two samples, only while the graph is mapped
+  guint tick_id;
+  // monotonic time of the latest sample
+  gint64 sample_time;
 
   // used for displaying, configurable
 
   // font size for labels
   double fontsize;
-  // refresh timeout
+  // sampling interval, in ms
   guint speed;
   // draw y axis with logarithmic scale instead of default linear
   gboolean logarithmic_scale;
@@ -0,0 +1,170 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include <config.h>
+
+#include <glibtop.h>
+#include <glibtop/cpu.h>
+
+#include "gsm-sampler.h"
+
+/* Callbacks due this close after a tick are run on it rather than on a
+ * tick of their own */
+#define COALESCE_TIME (50 * G_TIME_SPAN_MILLISECOND)
+
+typedef struct
+{
+  guint id;
+  gint64 period;
+  /* Monotonic time of the next call */
+  gint64 due;
+  /* NULL once removed */
+  GSourceFunc function;
+  gpointer data;
+} Client;
+
+static struct
+{
+  GPtrArray *clients;
+  guint last_id;
+  guint timeout;
+  /* The ticks are multiples of the periods since then */
+  gint64 epoch;
+  /* Time of the tick being run, 0 in between */
+  gint64 tick;
+
+  glibtop_cpu cpu;
+  gint64 cpu_time;
+} sampler;
+
+static void schedule (void);
+
+static gint64
+next_due (const Client *client,
+          gint64        after)
+{
+  return sampler.epoch + ((after - sampler.epoch) / client->period + 1) * client->period;
+}
+
+static gboolean
+run_tick (gpointer)
+{
+  const gint64 now = g_get_monotonic_time ();
+
+  sampler.timeout = 0;
+  sampler.tick = now;
+
+  /* The callbacks may add clients, which are due later on */
+  for (guint i = 0; i < sampler.clients->len; i++)
+    {
+      Client *client = g_ptr_array_index (sampler.clients, i);
+
+      if (!client->function || client->due > now + COALESCE_TIME)
+        continue;
+
+      client->due = next_due (client, now + COALESCE_TIME);
+      if (!client->function (client->data))
+        client->function = NULL;
+    }
+
+  sampler.tick = 0;
+  schedule ();
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+schedule (void)
+{
+  gint64 earliest = G_MAXINT64;
+
+  g_clear_handle_id (&sampler.timeout, g_source_remove);
+
+  for (guint i = sampler.clients->len; i-- > 0;)
+    {
+      const Client *client = g_ptr_array_index (sampler.clients, i);
+
+      if (client->function)
+        earliest = MIN (earliest, client->due);
+      else
+        g_ptr_array_remove_index (sampler.clients, i);
+    }
+
+  if (earliest == G_MAXINT64)
+    return;
+
+  const gint64 delay = MAX (earliest - g_get_monotonic_time (), 0);
+
+  sampler.timeout = g_timeout_add ((delay + G_TIME_SPAN_MILLISECOND - 1) / G_TIME_SPAN_MILLISECOND,
+                                   run_tick, NULL);
+  g_source_set_name_by_id (sampler.timeout, "gsm sampler");
+}
+
+guint
+gsm_sampler_add (guint       interval,
+                 GSourceFunc function,
+                 gpointer    data)
+{
+  Client *client;
+
+  g_return_val_if_fail (function != NULL, 0);
+
+  if (!sampler.clients)
+    {
+      sampler.clients = g_ptr_array_new_with_free_func (g_free);
+      sampler.epoch = g_get_monotonic_time ();
+    }
+
+  client = g_new (Client, 1);
+  client->id = ++sampler.last_id;
+  client->period = MAX (interval, 1) * G_TIME_SPAN_MILLISECOND;
+  client->due = next_due (client, g_get_monotonic_time ());
+  client->function = function;
+  client->data = data;
+  g_ptr_array_add (sampler.clients, client);
+
+  /* Rescheduled once the current tick is over */
+  if (!sampler.tick)
+    schedule ();
+
+  return client->id;
+}
+
+void
+gsm_sampler_remove (guint id)
+{
+  g_return_if_fail (sampler.clients != NULL);
+
+  for (guint i = 0; i < sampler.clients->len; i++)
+    {
+      Client *client = g_ptr_array_index (sampler.clients, i);
+
+      if (client->id == id)
+        {
+          client->function = NULL;
+          if (!sampler.tick)
+            schedule ();
+          return;
+        }
+    }
+
+  g_critical ("gsm sampler: no client with id %u", id);
+}
+
+const glibtop_cpu *
+gsm_sampler_get_cpu (gint64 *time)
+{
+  /* Outside of a tick, sharing an earlier sample would leave the deltas
+   * of the caller at 0 */
+  if (!sampler.tick || sampler.cpu_time < sampler.tick)
+    {
+      glibtop_get_cpu (&sampler.cpu);
+      sampler.cpu_time = sampler.tick ? sampler.tick : g_get_monotonic_time ();
+    }
+
+  if (time)
+    *time = sampler.cpu_time;
+
+  return &sampler.cpu;
+}
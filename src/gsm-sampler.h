@@ -0,0 +1,35 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#pragma once
+
+#include <glib.h>
+#include <glibtop/cpu.h>
+
+G_BEGIN_DECLS
+
+/*
+ * Single scheduler for the periodic updates of every view: the graphs,
+ * the process list, the file systems and the process dialogs.
+ *
+ * The callbacks are called on ticks shared by all of them, on multiples
+ * of their interval since the sampler started, so that views updated
+ * every 1 and every 3 seconds wake the process up together.  The kernel
+ * sources read by several views are read once per tick, and every view
+ * gets the same sample with the same time.
+ */
+
+/* Calls @function every @interval ms until it returns G_SOURCE_REMOVE,
+ * like g_timeout_add (); returns an id for gsm_sampler_remove () */
+guint               gsm_sampler_add (guint       interval,
+                                     GSourceFunc function,
+                                     gpointer    data);
+void                gsm_sampler_remove (guint id);
+
+/* CPU times of the current tick, read when first needed.  Outside of a
+ * tick, they are read again on each call.  @time, if not NULL, gets the
+ * monotonic time of the sample. */
+const glibtop_cpu * gsm_sampler_get_cpu (gint64 *time);
+
+G_END_DECLS
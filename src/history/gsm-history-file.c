@@ -0,0 +1,257 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <gio/gio.h>
+
+#include "gsm-history-file.h"
+
+#define MAGIC "GSMHIST"
+#define HEADER_SIZE 64
+
+typedef struct {
+  char magic[8];
+  guint32 version;
+  guint32 n_values;
+  guint32 n_records;
+  guint32 record_size;
+  /* Sequence number of the latest record, 0 when empty.  Record s is
+   * in slot (s - 1) % n_records. */
+  guint64 head;
+} Header;
+
+typedef struct {
+  /* Written last, 0 while the record is being written */
+  guint64 sequence;
+  gint64 time;
+  guint32 checksum;
+  guint32 padding;
+  float values[];
+} Record;
+
+G_STATIC_ASSERT (sizeof (Header) <= HEADER_SIZE);
+
+struct _GsmHistoryFile {
+  int fd;
+  guint8 *map;
+  gsize size;
+  Header *header;
+  guint n_values;
+  guint n_records;
+  gsize record_size;
+};
+
+
+static inline Record *
+get_record (GsmHistoryFile *file, guint64 sequence)
+{
+  return (Record *) (file->map + HEADER_SIZE + ((sequence - 1) % file->n_records) * file->record_size);
+}
+
+
+/* FNV-1a over the sequence, the time and the values */
+static guint32
+checksum (const Record *record, guint64 sequence, guint n_values)
+{
+  const guint8 *bytes[] = { (const guint8 *) &sequence, (const guint8 *) &record->time,
+                            (const guint8 *) record->values };
+  const gsize sizes[] = { sizeof sequence, sizeof record->time, n_values * sizeof (float) };
+  guint32 hash = 2166136261u;
+
+  for (gsize i = 0; i < G_N_ELEMENTS (bytes); i++)
+    for (gsize k = 0; k < sizes[i]; k++)
+      hash = (hash ^ bytes[i][k]) * 16777619u;
+
+  return hash;
+}
+
+
+static gboolean
+is_valid (GsmHistoryFile *file, guint64 sequence)
+{
+  const Record *record = get_record (file, sequence);
+
+  return sequence != 0
+         && __atomic_load_n (&record->sequence, __ATOMIC_ACQUIRE) == sequence
+         && record->checksum == checksum (record, sequence, file->n_values);
+}
+
+
+static gboolean
+header_matches (const Header *header, guint n_values, guint n_records, gsize record_size)
+{
+  return memcmp (header->magic, MAGIC, sizeof header->magic) == 0
+         && header->version == GSM_HISTORY_FILE_VERSION
+         && header->n_values == n_values
+         && header->n_records == n_records
+         && header->record_size == record_size;
+}
+
+
+GsmHistoryFile *
+gsm_history_file_open (const char *path,
+                       guint       n_values,
+                       guint       n_records,
+                       GError    **error)
+{
+  g_autofree GsmHistoryFile *file = g_new0 (GsmHistoryFile, 1);
+  struct stat st;
+  gboolean fresh;
+
+  g_return_val_if_fail (path != NULL, NULL);
+  g_return_val_if_fail (n_values > 0 && n_records > 0, NULL);
+
+  file->n_values = n_values;
+  file->n_records = n_records;
+  file->record_size = (sizeof (Record) + n_values * sizeof (float) + 7) & ~(gsize) 7;
+  file->size = HEADER_SIZE + n_records * file->record_size;
+
+  file->fd = g_open (path, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+  if (file->fd < 0) {
+    int saved_errno = errno;
+
+    g_set_error (error, G_IO_ERROR, g_io_error_from_errno (saved_errno),
+                 "Cannot open %s: %s", path, g_strerror (saved_errno));
+    return NULL;
+  }
+
+  /* A single writer, the other instances go without history */
+  if (flock (file->fd, LOCK_EX | LOCK_NB) < 0 || fstat (file->fd, &st) < 0) {
+    int saved_errno = errno;
+
+    g_set_error (error, G_IO_ERROR, g_io_error_from_errno (saved_errno),
+                 "Cannot use %s: %s", path, g_strerror (saved_errno));
+    close (file->fd);
+    return NULL;
+  }
+
+  fresh = (gsize) st.st_size != file->size;
+  if (fresh && (ftruncate (file->fd, 0) < 0 || ftruncate (file->fd, file->size) < 0)) {
+    int saved_errno = errno;
+
+    g_set_error (error, G_IO_ERROR, g_io_error_from_errno (saved_errno),
+                 "Cannot resize %s: %s", path, g_strerror (saved_errno));
+    close (file->fd);
+    return NULL;
+  }
+
+  file->map = mmap (NULL, file->size, PROT_READ | PROT_WRITE, MAP_SHARED, file->fd, 0);
+  if (file->map == MAP_FAILED) {
+    int saved_errno = errno;
+
+    g_set_error (error, G_IO_ERROR, g_io_error_from_errno (saved_errno),
+                 "Cannot map %s: %s", path, g_strerror (saved_errno));
+    close (file->fd);
+    return NULL;
+  }
+
+  file->header = (Header *) file->map;
+
+  if (fresh || !header_matches (file->header, n_values, n_records, file->record_size)) {
+    memset (file->map, 0, file->size);
+    memcpy (file->header->magic, MAGIC, sizeof file->header->magic);
+    file->header->version = GSM_HISTORY_FILE_VERSION;
+    file->header->n_values = n_values;
+    file->header->n_records = n_records;
+    file->header->record_size = file->record_size;
+  }
+
+  /* The header is updated after the record, catch up with the records
+   * written right before a crash */
+  while (is_valid (file, file->header->head + 1))
+    file->header->head++;
+
+  return g_steal_pointer (&file);
+}
+
+
+void
+gsm_history_file_close (GsmHistoryFile *file)
+{
+  if (file == NULL)
+    return;
+
+  munmap (file->map, file->size);
+  close (file->fd);
+  g_free (file);
+}
+
+
+void
+gsm_history_file_append (GsmHistoryFile *file,
+                         gint64          time,
+                         const float    *values)
+{
+  const guint64 sequence = file->header->head + 1;
+  Record *record = get_record (file, sequence);
+
+  __atomic_store_n (&record->sequence, 0, __ATOMIC_RELEASE);
+
+  record->time = time;
+  memcpy (record->values, values, file->n_values * sizeof (float));
+  record->checksum = checksum (record, sequence, file->n_values);
+
+  __atomic_store_n (&record->sequence, sequence, __ATOMIC_RELEASE);
+  file->header->head = sequence;
+}
+
+
+void
+gsm_history_file_clear (GsmHistoryFile *file)
+{
+  /* The sequences too, or the next open would catch up with them */
+  memset (file->map + HEADER_SIZE, 0, file->size - HEADER_SIZE);
+  file->header->head = 0;
+}
+
+
+guint
+gsm_history_file_get_n_values (GsmHistoryFile *file)
+{
+  return file->n_values;
+}
+
+
+guint
+gsm_history_file_get_length (GsmHistoryFile *file)
+{
+  return MIN (file->header->head, file->n_records);
+}
+
+
+gboolean
+gsm_history_file_get (GsmHistoryFile *file,
+                      guint           age,
+                      gint64         *time,
+                      const float   **values)
+{
+  const Record *record;
+  guint64 sequence;
+
+  if (age >= gsm_history_file_get_length (file))
+    return FALSE;
+
+  sequence = file->header->head - age;
+  if (!is_valid (file, sequence))
+    return FALSE;
+
+  record = get_record (file, sequence);
+  if (time)
+    *time = record->time;
+  if (values)
+    *values = record->values;
+
+  return TRUE;
+}
@@ -0,0 +1,57 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#pragma once
+
+#include <glib.h>
+#include <gmodule.h>
+
+G_BEGIN_DECLS
+
+/*
+ * Fixed size ring of samples kept in a memory mapped file, so that the
+ * graphs get their history back after a restart or a crash.
+ *
+ * A record holds the time of a sample, in microseconds of the real time
+ * clock, and a fixed number of float values.  The file is a cache in the
+ * native byte order: it is started again whenever its version or its
+ * layout do not match the requested one.  A record torn by a crash fails
+ * its checksum and is skipped.
+ */
+typedef struct _GsmHistoryFile GsmHistoryFile;
+
+#define GSM_HISTORY_FILE_VERSION 1
+
+G_MODULE_EXPORT
+GsmHistoryFile *gsm_history_file_open         (const char      *path,
+                                               guint            n_values,
+                                               guint            n_records,
+                                               GError         **error);
+G_MODULE_EXPORT
+void            gsm_history_file_close        (GsmHistoryFile  *file);
+
+G_MODULE_EXPORT
+void            gsm_history_file_append       (GsmHistoryFile  *file,
+                                               gint64           time,
+                                               const float     *values);
+
+/* Drops all the records, when the values change meaning */
+G_MODULE_EXPORT
+void            gsm_history_file_clear        (GsmHistoryFile  *file);
+
+G_MODULE_EXPORT
+guint           gsm_history_file_get_n_values (GsmHistoryFile  *file);
+/* Number of records written and still in the ring */
+G_MODULE_EXPORT
+guint           gsm_history_file_get_length   (GsmHistoryFile  *file);
+/* Record @age records before the latest one, points into the mapping */
+G_MODULE_EXPORT
+gboolean        gsm_history_file_get          (GsmHistoryFile  *file,
+                                               guint            age,
+                                               gint64          *time,
+                                               const float    **values);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (GsmHistoryFile, gsm_history_file_close)
+
+G_END_DECLS
@@ -0,0 +1,149 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <glib.h>
+
+#include "gsm-history-file.c"
+
+
+static void
+test_history_ring (void)
+{
+  g_autofree char *dir = g_dir_make_tmp ("gsm-history-XXXXXX", NULL);
+  g_autofree char *path = g_build_filename (dir, "test.history", NULL);
+  GsmHistoryFile *file = gsm_history_file_open (path, 2, 8, NULL);
+  const float *values;
+  gint64 time;
+
+  g_assert_nonnull (file);
+  g_assert_false (gsm_history_file_get (file, 0, NULL, NULL));
+
+  /* Wraps around, the oldest records are dropped */
+  for (guint i = 1; i < 20; i++)
+    {
+      const float record[] = { i, -1.0f };
+
+      gsm_history_file_append (file, i * G_USEC_PER_SEC, record);
+    }
+  gsm_history_file_close (file);
+
+  /* Kept across runs */
+  file = gsm_history_file_open (path, 2, 8, NULL);
+  g_assert_cmpuint (gsm_history_file_get_length (file), ==, 8);
+  for (guint age = 0; age < 8; age++)
+    {
+      g_assert_true (gsm_history_file_get (file, age, &time, &values));
+      g_assert_cmpint (time, ==, (19 - age) * G_USEC_PER_SEC);
+      g_assert_cmpfloat (values[0], ==, 19 - age);
+      g_assert_cmpfloat (values[1], ==, -1.0f);
+    }
+  g_assert_false (gsm_history_file_get (file, 8, NULL, NULL));
+
+  /* Not caught up with after a clear */
+  gsm_history_file_clear (file);
+  g_assert_cmpuint (gsm_history_file_get_length (file), ==, 0);
+  gsm_history_file_close (file);
+  file = gsm_history_file_open (path, 2, 8, NULL);
+  g_assert_cmpuint (gsm_history_file_get_length (file), ==, 0);
+  gsm_history_file_close (file);
+
+  g_unlink (path);
+  g_rmdir (dir);
+}
+
+
+static void
+test_history_crash (void)
+{
+  g_autofree char *dir = g_dir_make_tmp ("gsm-history-XXXXXX", NULL);
+  g_autofree char *path = g_build_filename (dir, "test.history", NULL);
+  GsmHistoryFile *file = gsm_history_file_open (path, 1, 8, NULL);
+
+  for (guint i = 1; i <= 6; i++)
+    {
+      const float record[] = { i };
+
+      gsm_history_file_append (file, i * G_USEC_PER_SEC, record);
+    }
+
+  /* Torn record */
+  get_record (file, 3)->values[0] = 42.0f;
+  /* Crash between writing a record and the header */
+  file->header->head = 5;
+  gsm_history_file_close (file);
+
+  file = gsm_history_file_open (path, 1, 8, NULL);
+  g_assert_cmpuint (gsm_history_file_get_length (file), ==, 6);
+  g_assert_true (gsm_history_file_get (file, 0, NULL, NULL));
+  g_assert_false (gsm_history_file_get (file, 3, NULL, NULL));
+  g_assert_true (gsm_history_file_get (file, 4, NULL, NULL));
+  gsm_history_file_close (file);
+
+  g_unlink (path);
+  g_rmdir (dir);
+}
+
+
+static void
+test_history_layout (void)
+{
+  g_autofree char *dir = g_dir_make_tmp ("gsm-history-XXXXXX", NULL);
+  g_autofree char *path = g_build_filename (dir, "test.history", NULL);
+  const float record[] = { 1.0f, 2.0f, 3.0f };
+  GsmHistoryFile *file = gsm_history_file_open (path, 3, 8, NULL);
+
+  gsm_history_file_append (file, G_USEC_PER_SEC, record);
+  gsm_history_file_close (file);
+
+  /* Another number of values, the history starts again */
+  file = gsm_history_file_open (path, 2, 8, NULL);
+  g_assert_cmpuint (gsm_history_file_get_length (file), ==, 0);
+  gsm_history_file_append (file, G_USEC_PER_SEC, record);
+  file->header->version = GSM_HISTORY_FILE_VERSION + 1;
+  gsm_history_file_close (file);
+
+  /* Another version */
+  file = gsm_history_file_open (path, 2, 8, NULL);
+  g_assert_cmpuint (gsm_history_file_get_length (file), ==, 0);
+  gsm_history_file_close (file);
+
+  g_unlink (path);
+  g_rmdir (dir);
+}
+
+
+static void
+test_history_single_writer (void)
+{
+  g_autofree char *dir = g_dir_make_tmp ("gsm-history-XXXXXX", NULL);
+  g_autofree char *path = g_build_filename (dir, "test.history", NULL);
+  g_autoptr (GError) error = NULL;
+  GsmHistoryFile *file = gsm_history_file_open (path, 1, 8, NULL);
+  GsmHistoryFile *other = gsm_history_file_open (path, 1, 8, &error);
+
+  /* The file is locked by the first instance */
+  g_assert_nonnull (file);
+  g_assert_null (other);
+  g_assert_nonnull (error);
+  gsm_history_file_close (file);
+
+  g_unlink (path);
+  g_rmdir (dir);
+}
+
+
+int
+main (int argc, char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/gnome-system-monitor/history/ring", test_history_ring);
+  g_test_add_func ("/gnome-system-monitor/history/crash", test_history_crash);
+  g_test_add_func ("/gnome-system-monitor/history/layout", test_history_layout);
+  g_test_add_func ("/gnome-system-monitor/history/single-writer", test_history_single_writer);
+
+  return g_test_run ();
+}
@@ -46,15 +46,16 @@
 #include "settings-keys.h"
 #include "legacy/gsm_color_button.h"
 
+/* Up to this many CPUs, each one gets a color picker and labels */
+constexpr gint CPU_LEGEND_MIN_CPUS = 32;
+
 static void
 search_text_changed (GtkEditable*,
                      gpointer data)
 {
   GsmApplication * const app = static_cast<GsmApplication *>(data);
 
-  gtk_tree_model_filter_refilter (GTK_TREE_MODEL_FILTER (gtk_tree_model_sort_get_model (
-                                                           GTK_TREE_MODEL_SORT (gtk_tree_view_get_model (
-                                                                                  GTK_TREE_VIEW (app->tree))))));
+  proctable_update_search (app);
   proctable_refresh_summary_headers(app);
 }
 
@@ -214,6 +215,44 @@ cb_disk_write_color_changed (GsmColorButton *cp,
   change_settings_color (*app->settings.operator-> (), GSM_SETTING_DISK_WRITE_COLOR, cp);
 }
 
+#ifdef __linux__
+static void
+cb_pressure_color_changed (GsmColorButton *cp,
+                           gpointer        data)
+{
+  static const char *const keys[] = {
+    GSM_SETTING_PRESSURE_CPU_COLOR, GSM_SETTING_PRESSURE_MEMORY_COLOR, GSM_SETTING_PRESSURE_IO_COLOR
+  };
+  GsmApplication *app = &GsmApplication::get ();
+
+  change_settings_color (*app->settings.operator-> (), keys[GPOINTER_TO_INT (data)], cp);
+}
+
+static void
+cb_cpu_times_color_changed (GsmColorButton *cp,
+                            gpointer        data)
+{
+  const guint state = GPOINTER_TO_UINT (data);
+  GsmApplication *app = &GsmApplication::get ();
+  std::vector<Glib::ustring> colors;
+
+  /* The whole array, from the colors shown for the missing ones */
+  for (guint i = 0; i < G_N_ELEMENTS (app->config.cpu_times_color); i++)
+    {
+      GdkRGBA c = app->config.cpu_times_color[i];
+      g_autofree char *color = NULL;
+
+      if (i == state)
+        gsm_color_button_get_color (cp, &c);
+      color = gdk_rgba_to_string (&c);
+      colors.push_back (color);
+    }
+
+  /* Just set the value and let the changed::cpu-times-colors signal callback do the rest. */
+  app->settings->set_string_array (GSM_SETTING_CPU_TIMES_COLORS, colors);
+}
+#endif
+
 static void
 create_sys_view (GsmApplication *app,
                  GtkBuilder     *builder)
@@ -225,6 +264,11 @@ create_sys_view (GsmApplication *app,
   GsmColorButton *color_picker;
 
   LoadGraph *cpu_graph, *mem_graph, *net_graph, *disk_graph;
+#ifdef __linux__
+  GtkBox *cpu_times_graph_box, *pressure_graph_box;
+  GtkExpander *cpu_times_expander, *pressure_expander;
+  LoadGraph *cpu_times_graph, *pressure_graph;
+#endif
 
   gint i;
   gchar *title_text;
@@ -247,49 +291,116 @@ create_sys_view (GsmApplication *app,
                    GTK_WIDGET (load_graph_get_widget (cpu_graph)));
 
   GtkGrid*cpu_table = GTK_GRID (gtk_builder_get_object (builder, "cpu_table"));
-  gint cols = 4 + app->config.num_cpus / 32;
-  gint rows = (app->config.num_cpus + cols - 1) / cols;
 
-  for (i = 0; i < app->config.num_cpus; i++)
+  /* Past a few dozens of CPUs, a picker and two labels each take too much
+     room and time to update, a single legend draws them all */
+  if (app->config.num_cpus > CPU_LEGEND_MIN_CPUS)
     {
-      GtkBox *temp_hbox;
+      GsmCpuLegend *legend = gsm_cpu_legend_new (app->config.num_cpus);
 
-      temp_hbox = GTK_BOX (gtk_box_new (GTK_ORIENTATION_HORIZONTAL, 0));
-      gtk_box_set_spacing (temp_hbox, 4);
-      if (i < cols)
-        gtk_grid_insert_column (cpu_table, i % cols);
-      if ((i + 1) % cols == cols)
-        gtk_grid_insert_row (cpu_table, (i + 1) / cols);
-      gtk_grid_attach (cpu_table, GTK_WIDGET (temp_hbox), i / rows, i % rows, 1, 1);
+      gsm_cpu_legend_set_colors (legend, &cpu_graph->colors[0]);
+      gsm_cpu_legend_set_heatmap (legend, app->config.draw_heatmap);
+      gtk_widget_set_hexpand (GTK_WIDGET (legend), TRUE);
+      gtk_grid_attach (cpu_table, GTK_WIDGET (legend), 0, 0, 1, 1);
+      load_graph_get_labels (cpu_graph)->cpu_legend = legend;
+    }
+  else
+    {
+      gint cols = 4 + app->config.num_cpus / 32;
+      gint rows = (app->config.num_cpus + cols - 1) / cols;
 
-      color_picker = gsm_color_button_new (&cpu_graph->colors.at (i), GSMCP_TYPE_CPU);
-      g_signal_connect (G_OBJECT (color_picker), "color-set",
-                        G_CALLBACK (cb_cpu_color_changed), GINT_TO_POINTER (i));
-      gtk_box_append (temp_hbox, GTK_WIDGET (color_picker));
-      gtk_widget_set_size_request (GTK_WIDGET (color_picker), 32, -1);
+      for (i = 0; i < app->config.num_cpus; i++)
+        {
+          GtkBox *temp_hbox;
+
+          temp_hbox = GTK_BOX (gtk_box_new (GTK_ORIENTATION_HORIZONTAL, 0));
+          gtk_box_set_spacing (temp_hbox, 4);
+          if (i < cols)
+            gtk_grid_insert_column (cpu_table, i % cols);
+          if ((i + 1) % cols == cols)
+            gtk_grid_insert_row (cpu_table, (i + 1) / cols);
+          gtk_grid_attach (cpu_table, GTK_WIDGET (temp_hbox), i / rows, i % rows, 1, 1);
+
+          color_picker = gsm_color_button_new (&cpu_graph->colors.at (i), GSMCP_TYPE_CPU);
+          g_signal_connect (G_OBJECT (color_picker), "color-set",
+                            G_CALLBACK (cb_cpu_color_changed), GINT_TO_POINTER (i));
+          gtk_box_append (temp_hbox, GTK_WIDGET (color_picker));
+          gtk_widget_set_size_request (GTK_WIDGET (color_picker), 32, -1);
+
+          if (app->config.num_cpus == 1)
+            label_text = g_strdup (_("CPU"));
+          else
+            label_text = g_strdup_printf (_("CPU%d"), i + 1);
+          title_text = g_strdup_printf (title_template, label_text);
+          label = GTK_LABEL (gtk_label_new (label_text));
+          if (app->config.num_cpus >= 10)
+            gtk_label_set_width_chars (label, log10 (app->config.num_cpus) + 1 + 4);
+          gsm_color_button_set_title (color_picker, title_text);
+          g_free (title_text);
+          gtk_box_append (temp_hbox, GTK_WIDGET (label));
+          g_free (label_text);
+
+          cpu_label = make_tnum_label ();
+
+          /* Reserve some space to avoid the layout changing with the values. */
+          gtk_label_set_width_chars (cpu_label, 6);
+          gtk_box_append (temp_hbox, GTK_WIDGET (cpu_label));
+          load_graph_get_labels (cpu_graph)->cpu[i] = cpu_label;
+        }
+    }
 
-      if (app->config.num_cpus == 1)
-        label_text = g_strdup (_("CPU"));
-      else
-        label_text = g_strdup_printf (_("CPU%d"), i + 1);
-      title_text = g_strdup_printf (title_template, label_text);
-      label = GTK_LABEL (gtk_label_new (label_text));
-      if (app->config.num_cpus >= 10)
-        gtk_label_set_width_chars (label, log10 (app->config.num_cpus) + 1 + 4);
+  app->cpu_graph = cpu_graph;
+
+  /* The CPU times box */
+
+#ifdef __linux__
+  cpu_times_graph_box = GTK_BOX (gtk_builder_get_object (builder, "cpu_times_graph_box"));
+  cpu_times_expander = GTK_EXPANDER (gtk_builder_get_object (builder, "cpu_times_expander"));
+  g_object_bind_property (cpu_times_expander, "expanded", cpu_times_expander, "vexpand", G_BINDING_DEFAULT);
+  g_settings_bind (app->settings->gobj (), GSM_SETTING_RESOURCES_CPU_TIMES_EXPANDED, G_OBJECT (cpu_times_expander), "expanded", G_SETTINGS_BIND_DEFAULT);
+  g_settings_bind (app->settings->gobj (), GSM_SETTING_SHOW_CPU_TIMES, G_OBJECT (cpu_times_expander), "visible", G_SETTINGS_BIND_GET);
+
+  cpu_times_graph = new LoadGraph (LOAD_GRAPH_CPU_TIMES);
+  gtk_widget_set_size_request (GTK_WIDGET (load_graph_get_widget (cpu_times_graph)), -1, 70);
+  gtk_box_prepend (cpu_times_graph_box,
+                   GTK_WIDGET (load_graph_get_widget (cpu_times_graph)));
+
+  table = GTK_GRID (gtk_builder_get_object (builder, "cpu_times_table"));
+
+  const char *const cpu_times_names[] = {
+    _("User"), _("Nice"), _("System"), _("I/O Wait"), _("IRQ"), _("Soft IRQ"),
+    // Translators: CPU time taken by the hypervisor for other virtual machines
+    _("Steal")
+  };
+
+  for (i = 0; i < GSM_CPU_IDLE; i++)
+    {
+      const gint column = 3 * (i / 2);
+      const gint row = i % 2;
+
+      color_picker = gsm_color_button_new (&cpu_times_graph->colors.at (i), GSMCP_TYPE_CPU);
+      gtk_widget_set_size_request (GTK_WIDGET (color_picker), 32, -1);
+      g_signal_connect (G_OBJECT (color_picker), "color-set",
+                        G_CALLBACK (cb_cpu_times_color_changed), GUINT_TO_POINTER (i));
+      title_text = g_strdup_printf (title_template, cpu_times_names[i]);
       gsm_color_button_set_title (color_picker, title_text);
       g_free (title_text);
-      gtk_box_append (temp_hbox, GTK_WIDGET (label));
-      g_free (label_text);
+      gtk_grid_attach (table, GTK_WIDGET (color_picker), column, row, 1, 1);
 
-      cpu_label = make_tnum_label ();
-
-      /* Reserve some space to avoid the layout changing with the values. */
-      gtk_label_set_width_chars (cpu_label, 6);
-      gtk_box_append (temp_hbox, GTK_WIDGET (cpu_label));
-      load_graph_get_labels (cpu_graph)->cpu[i] = cpu_label;
+      label = GTK_LABEL (gtk_label_new (cpu_times_names[i]));
+      gtk_widget_set_halign (GTK_WIDGET (label), GTK_ALIGN_START);
+      gtk_grid_attach (table, GTK_WIDGET (label), column + 1, row, 1, 1);
+      gtk_grid_attach (table, GTK_WIDGET (load_graph_get_labels (cpu_times_graph)->cpu_times[i]), column + 2, row, 1, 1);
     }
 
-  app->cpu_graph = cpu_graph;
+  gtk_widget_set_hexpand (GTK_WIDGET (load_graph_get_labels (cpu_times_graph)->cpu_times[GSM_CPU_IDLE - 1]), true);
+  gtk_grid_attach (table, GTK_WIDGET (load_graph_get_labels (cpu_times_graph)->cpu_times_cpu), 12, 0, 1, 2);
+
+  app->cpu_times_graph = cpu_times_graph;
+#else
+  /* The states come from /proc/stat */
+  gtk_widget_set_visible (GTK_WIDGET (gtk_builder_get_object (builder, "cpu_times_expander")), FALSE);
+#endif
 
   /** The memory box */
 
@@ -383,6 +494,9 @@ create_sys_view (GsmApplication *app,
   gtk_widget_set_hexpand (GTK_WIDGET (load_graph_get_labels (net_graph)->net_out), true);
   gtk_widget_set_halign (GTK_WIDGET (load_graph_get_labels (net_graph)->net_out), GTK_ALIGN_START);
 
+  if (load_graph_get_labels (net_graph)->net_interface)
+    gtk_grid_attach (table, GTK_WIDGET (load_graph_get_labels (net_graph)->net_interface), 7, 0, 1, 2);
+
   app->net_graph = net_graph;
 
   /* The disk box */
@@ -437,7 +551,67 @@ create_sys_view (GsmApplication *app,
   gtk_widget_set_hexpand (GTK_WIDGET (load_graph_get_labels (disk_graph)->disk_write), true);
   gtk_widget_set_halign (GTK_WIDGET (load_graph_get_labels (disk_graph)->disk_write), GTK_ALIGN_START);
 
+  if (load_graph_get_labels (disk_graph)->disk_device)
+    {
+      gtk_grid_attach (table, GTK_WIDGET (load_graph_get_labels (disk_graph)->disk_device), 7, 0, 1, 1);
+      gtk_grid_attach (table, GTK_WIDGET (load_graph_get_labels (disk_graph)->disk_details), 7, 1, 1, 1);
+    }
+
   app->disk_graph = disk_graph;
+
+  /* The pressure box */
+
+#ifdef __linux__
+  pressure_graph_box = GTK_BOX (gtk_builder_get_object (builder, "pressure_graph_box"));
+  pressure_expander = GTK_EXPANDER (gtk_builder_get_object (builder, "pressure_expander"));
+  g_object_bind_property (pressure_expander, "expanded", pressure_expander, "vexpand", G_BINDING_DEFAULT);
+  g_settings_bind (app->settings->gobj (), GSM_SETTING_RESOURCES_PRESSURE_EXPANDED, G_OBJECT (pressure_expander), "expanded", G_SETTINGS_BIND_DEFAULT);
+
+  pressure_graph = new LoadGraph (LOAD_GRAPH_PRESSURE);
+  gtk_widget_set_size_request (GTK_WIDGET (load_graph_get_widget (pressure_graph)), -1, 70);
+  gtk_box_prepend (pressure_graph_box,
+                   GTK_WIDGET (load_graph_get_widget (pressure_graph)));
+
+  /* Without pressure stall information, as with a kernel started with
+     psi=0, there is nothing to show */
+  gtk_widget_set_visible (GTK_WIDGET (pressure_expander), pressure_graph->pressure.reader != NULL);
+
+  table = GTK_GRID (gtk_builder_get_object (builder, "pressure_table"));
+
+  const char *const pressure_names[] = { _("CPU"), _("Memory"), _("I/O") };
+
+  for (i = 0; i < GSM_PRESSURE_N_RESOURCES; i++)
+    {
+      color_picker = gsm_color_button_new (&pressure_graph->colors.at (i), GSMCP_TYPE_CPU);
+      gtk_widget_set_valign (GTK_WIDGET (color_picker), GTK_ALIGN_CENTER);
+      gtk_widget_set_size_request (GTK_WIDGET (color_picker), 32, -1);
+      g_signal_connect (G_OBJECT (color_picker), "color-set",
+                        G_CALLBACK (cb_pressure_color_changed), GINT_TO_POINTER (i));
+      title_text = g_strdup_printf (title_template, pressure_names[i]);
+      gsm_color_button_set_title (color_picker, title_text);
+      g_free (title_text);
+      gtk_grid_attach (table, GTK_WIDGET (color_picker), 3 * i, 0, 1, 2);
+
+      label = GTK_LABEL (gtk_label_new (pressure_names[i]));
+      gtk_widget_set_halign (GTK_WIDGET (label), GTK_ALIGN_START);
+      gtk_grid_attach (table, GTK_WIDGET (label), 3 * i + 1, 0, 1, 1);
+      gtk_grid_attach (table, GTK_WIDGET (load_graph_get_labels (pressure_graph)->pressure[i]), 3 * i + 2, 0, 1, 1);
+
+      // Translators: the averages of the pressure stall over 10 s, 1 and 5 minutes
+      label = GTK_LABEL (gtk_label_new (_("Averages")));
+      gtk_widget_set_halign (GTK_WIDGET (label), GTK_ALIGN_START);
+      gtk_widget_add_css_class (GTK_WIDGET (label), "dim-label");
+      gtk_grid_attach (table, GTK_WIDGET (label), 3 * i + 1, 1, 1, 1);
+      gtk_grid_attach (table, GTK_WIDGET (load_graph_get_labels (pressure_graph)->pressure_avg[i]), 3 * i + 2, 1, 1, 1);
+      gtk_widget_set_hexpand (GTK_WIDGET (load_graph_get_labels (pressure_graph)->pressure_avg[i]), true);
+    }
+
+  gtk_grid_attach (table, GTK_WIDGET (load_graph_get_labels (pressure_graph)->pressure_cgroup), 3 * GSM_PRESSURE_N_RESOURCES, 0, 1, 2);
+
+  app->pressure_graph = pressure_graph;
+#else
+  gtk_widget_set_visible (GTK_WIDGET (gtk_builder_get_object (builder, "pressure_expander")), FALSE);
+#endif
   g_free (title_template);
 }
 
@@ -665,6 +839,19 @@ change_show_dependencies_state (GSimpleAction *action,
   app->settings->set_value (GSM_SETTING_SHOW_DEPENDENCIES, state_var);
 }
 
+static void
+change_show_top_processes_state (GSimpleAction *action,
+                                 GVariant      *state,
+                                 gpointer       data)
+{
+  GsmApplication *app = (GsmApplication *) data;
+
+  auto state_var = Glib::wrap (state, true);
+
+  g_simple_action_set_state (action, state);
+  app->settings->set_value (GSM_SETTING_SHOW_TOP_PROCESSES, state_var);
+}
+
 static void
 on_activate_priority (GSimpleAction *action,
                       GVariant      *parameter,
@@ -696,6 +883,45 @@ change_priority_state (GSimpleAction *action,
   g_simple_action_set_state (action, state);
 }
 
+/*
+  The resources view, with its graphs and per-CPU labels, is only built
+  when it is first shown, or when idle after the first frame.  The
+  builder is kept on the stack until then.
+*/
+static void
+ensure_sys_view (GsmApplication *app)
+{
+  if (app->cpu_graph)
+    return;
+
+  GtkBuilder *builder = GTK_BUILDER (g_object_get_data (G_OBJECT (app->stack), "sys-view-builder"));
+  const gint64 start = g_get_monotonic_time ();
+
+  create_sys_view (app, builder);
+  g_object_set_data (G_OBJECT (app->stack), "sys-view-builder", NULL);
+
+  procman_debug ("resources view built in %.1f ms", (g_get_monotonic_time () - start) / 1000.0);
+}
+
+static gboolean
+cb_create_sys_view_idle (gpointer data)
+{
+  ensure_sys_view ((GsmApplication *) data);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+cb_first_paint (GdkFrameClock *clock,
+                gpointer       data)
+{
+  g_signal_handlers_disconnect_by_func (clock, (gpointer) cb_first_paint, data);
+
+  procman_startup_phase ("first paint", true);
+
+  g_idle_add_full (G_PRIORITY_LOW, cb_create_sys_view_idle, data, NULL);
+}
+
 static void
 update_page_activities (GsmApplication *app)
 {
@@ -740,17 +966,27 @@ update_page_activities (GsmApplication *app)
 
   if (strcmp (current_page, "resources") == 0)
     {
+      ensure_sys_view (app);
+
       load_graph_start (app->cpu_graph);
       load_graph_start (app->mem_graph);
       load_graph_start (app->net_graph);
       load_graph_start (app->disk_graph);
+#ifdef __linux__
+      load_graph_start (app->cpu_times_graph);
+      load_graph_start (app->pressure_graph);
+#endif
     }
-  else
+  else if (app->cpu_graph)
     {
       load_graph_stop (app->cpu_graph);
       load_graph_stop (app->mem_graph);
       load_graph_stop (app->net_graph);
       load_graph_stop (app->disk_graph);
+#ifdef __linux__
+      load_graph_stop (app->cpu_times_graph);
+      load_graph_stop (app->pressure_graph);
+#endif
     }
 }
 
@@ -811,12 +1047,16 @@ cb_main_window_suspended (GtkWindow      *window,
         {
           proctable_freeze (app);
         }
-      else if (current_page == "resources")
+      else if (current_page == "resources" && app->cpu_graph)
         {
           load_graph_stop (app->cpu_graph);
           load_graph_stop (app->mem_graph);
           load_graph_stop (app->net_graph);
           load_graph_stop (app->disk_graph);
+#ifdef __linux__
+          load_graph_stop (app->cpu_times_graph);
+          load_graph_stop (app->pressure_graph);
+#endif
         }
     }
   else
@@ -826,12 +1066,16 @@ cb_main_window_suspended (GtkWindow      *window,
           proctable_update (app);
           proctable_thaw (app);
         }
-      else if (current_page == "resources")
+      else if (current_page == "resources" && app->cpu_graph)
         {
           load_graph_start (app->cpu_graph);
           load_graph_start (app->mem_graph);
           load_graph_start (app->net_graph);
           load_graph_start (app->disk_graph);
+#ifdef __linux__
+          load_graph_start (app->cpu_times_graph);
+          load_graph_start (app->pressure_graph);
+#endif
         }
     }
 }
@@ -857,7 +1101,8 @@ create_main_window (GsmApplication *app)
   /* create the main stack */
   app->stack = ADW_VIEW_STACK (gtk_builder_get_object (builder, "stack"));
   create_proc_view (app, builder);
-  create_sys_view (app, builder);
+  g_object_set_data_full (G_OBJECT (app->stack), "sys-view-builder",
+                          g_object_ref (builder), g_object_unref);
   app->disk_list = GSM_DISKS_VIEW (gtk_builder_get_object (builder, "disks_view"));
 
   app->app_menu_button = GTK_MENU_BUTTON (gtk_builder_get_object (builder, "app_menu_button"));
@@ -886,7 +1131,8 @@ create_main_window (GsmApplication *app)
     { "refresh", on_activate_refresh, NULL, NULL, NULL, { 0, 0, 0 } },
     { "show-page", on_activate_radio, "s", "'resources'", change_show_page_state, { 0, 0, 0 } },
     { "show-whose-processes", on_activate_radio, "s", "'all'", change_show_processes_state, { 0, 0, 0 } },
-    { "show-dependencies", on_activate_toggle, NULL, "false", change_show_dependencies_state, { 0, 0, 0 } }
+    { "show-dependencies", on_activate_toggle, NULL, "false", change_show_dependencies_state, { 0, 0, 0 } },
+    { "show-top-processes", on_activate_toggle, NULL, "false", change_show_top_processes_state, { 0, 0, 0 } }
   };
   g_action_map_add_action_entries (G_ACTION_MAP (app->main_window),
                                    win_action_entries,
@@ -920,6 +1166,11 @@ create_main_window (GsmApplication *app)
                          g_settings_get_value (app->settings->gobj (), GSM_SETTING_SHOW_DEPENDENCIES));
 
 
+  action = g_action_map_lookup_action (G_ACTION_MAP (app->main_window),
+                                       "show-top-processes");
+  g_action_change_state (action,
+                         g_settings_get_value (app->settings->gobj (), GSM_SETTING_SHOW_TOP_PROCESSES));
+
   action = g_action_map_lookup_action (G_ACTION_MAP (app->main_window),
                                        "show-whose-processes");
   g_action_change_state (action,
@@ -945,7 +1196,14 @@ create_main_window (GsmApplication *app)
 
   update_page_activities (app);
 
+  g_signal_connect (gtk_widget_get_frame_clock (GTK_WIDGET (app->main_window)),
+                    "after-paint",
+                    G_CALLBACK (cb_first_paint),
+                    app);
+
   g_object_unref (G_OBJECT (builder));
+
+  procman_startup_phase ("main window built");
 }
 
 static gboolean
@@ -981,7 +1239,8 @@ update_sensitivity (GsmApplication *app)
   const char * const processes_actions[] = { "refresh",
                                              "search",
                                              "show-whose-processes",
-                                             "show-dependencies" };
+                                             "show-dependencies",
+                                             "show-top-processes" };
 
   size_t i;
   gboolean processes_sensitivity, selected_sensitivity;
@@ -0,0 +1,350 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <linux/major.h>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <gio/gio.h>
+
+#include "gsm-diskstats.h"
+
+#define DISKSTATS "/proc/diskstats"
+#define SYSFS_BLOCK "/sys/class/block"
+
+struct _GsmDiskstats {
+  int fd;
+  char *buffer;
+  gsize buffer_size;
+  /* Where the devices are classified, a test one in the tests */
+  const char *sysfs;
+  /* Name to GsmDiskFlags + 1 of the devices listed by the last read,
+   * as a device is never renamed */
+  GHashTable *flags;
+};
+
+
+static void
+set_diskstats_error (GError **error, int saved_errno, const char *what)
+{
+  g_set_error (error, G_IO_ERROR, g_io_error_from_errno (saved_errno),
+               "%s: %s", what, g_strerror (saved_errno));
+}
+
+
+GsmDiskstats *
+gsm_diskstats_new (void)
+{
+  GsmDiskstats *self = g_new0 (GsmDiskstats, 1);
+
+  self->fd = -1;
+  self->buffer_size = 4096;
+  self->buffer = g_malloc (self->buffer_size);
+  self->sysfs = SYSFS_BLOCK;
+  self->flags = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+  return self;
+}
+
+
+void
+gsm_diskstats_free (GsmDiskstats *self)
+{
+  if (self == NULL) {
+    return;
+  }
+
+  if (self->fd >= 0) {
+    close (self->fd);
+  }
+  g_free (self->buffer);
+  g_hash_table_unref (self->flags);
+  g_free (self);
+}
+
+
+static gboolean
+sysfs_has (const char *sysfs, const char *name, const char *entry)
+{
+  g_autofree char *path = g_build_filename (sysfs, name, entry, NULL);
+
+  return g_access (path, F_OK) == 0;
+}
+
+
+static gboolean
+sysfs_has_slaves (const char *sysfs, const char *name)
+{
+  g_autofree char *path = g_build_filename (sysfs, name, "slaves", NULL);
+  g_autoptr (GDir) dir = g_dir_open (path, 0, NULL);
+
+  return dir && g_dir_read_name (dir) != NULL;
+}
+
+
+/* An unbound loop device, an md array not assembled yet and a dm device
+ * without a table have nothing below them yet */
+static gboolean
+may_get_slaves (const char *name, guint major)
+{
+  /* device-mapper has a dynamic major, and md arrays may have the
+   * extended one */
+  return major == LOOP_MAJOR || major == MD_MAJOR ||
+         g_str_has_prefix (name, "dm-") || g_str_has_prefix (name, "md");
+}
+
+
+static GsmDiskFlags
+classify (GsmDiskstats *self, const char *name, guint major)
+{
+  g_autofree char *sysfs_name = NULL;
+  gpointer value;
+  GsmDiskFlags flags = 0;
+
+  /* A whole disk is looked at again while it may still get slaves */
+  if (g_hash_table_lookup_extended (self->flags, name, NULL, &value) &&
+      (GPOINTER_TO_UINT (value) - 1 != 0 || !may_get_slaves (name, major))) {
+    return GPOINTER_TO_UINT (value) - 1;
+  }
+
+  /* cciss/c0d0 is cciss!c0d0 in sysfs */
+  sysfs_name = g_strdelimit (g_strdup (name), "/", '!');
+
+  if (sysfs_has (self->sysfs, sysfs_name, "partition")) {
+    flags |= GSM_DISK_PARTITION;
+  }
+  /* dm and md have the devices below them as slaves, a loop device
+   * has its file on another file system */
+  if (sysfs_has_slaves (self->sysfs, sysfs_name) || sysfs_has (self->sysfs, sysfs_name, "loop")) {
+    flags |= GSM_DISK_STACKED;
+  }
+
+  g_hash_table_insert (self->flags, g_strdup (name), GUINT_TO_POINTER (flags + 1));
+
+  return flags;
+}
+
+
+/* Sets the flags of @disks, and forgets the devices no longer listed:
+ * their names may come back as other devices */
+static void
+classify_disks (GsmDiskstats *self, GArray *disks)
+{
+  GHashTable *listed = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+  for (guint i = 0; i < disks->len; i++) {
+    GsmDiskStat *stat = &g_array_index (disks, GsmDiskStat, i);
+    gpointer name;
+
+    stat->flags = classify (self, stat->name, stat->major);
+
+    if (g_hash_table_steal_extended (self->flags, stat->name, &name, NULL)) {
+      g_hash_table_insert (listed, name, GUINT_TO_POINTER (stat->flags + 1));
+    }
+  }
+
+  g_hash_table_unref (self->flags);
+  self->flags = listed;
+}
+
+
+/* Returns the next field of the line at *@pos and moves past it */
+static const char *
+next_field (const char **pos, const char *end, gsize *len)
+{
+  const char *start = *pos;
+
+  while (start < end && (*start == ' ' || *start == '\t')) {
+    start++;
+  }
+
+  *pos = start;
+  while (*pos < end && **pos != ' ' && **pos != '\t') {
+    (*pos)++;
+  }
+
+  *len = *pos - start;
+
+  return start;
+}
+
+
+/*
+ * A line of /proc/diskstats, see Documentation/admin-guide/iostats.rst:
+ *   major minor name reads merged sectors ms writes merged sectors ms
+ *   in_flight io_ms weighted_ms [discards... [flushes...]]
+ */
+static gboolean
+parse_line (const char *line, const char *end, GsmDiskStat *stat)
+{
+  guint64 fields[11];
+  const char *pos = line;
+  const char *field;
+  gsize len;
+
+  for (guint i = 0; i < 2; i++) {
+    field = next_field (&pos, end, &len);
+    if (len == 0 || !g_ascii_isdigit (*field)) {
+      return FALSE;
+    }
+    fields[i] = g_ascii_strtoull (field, NULL, 10);
+  }
+
+  field = next_field (&pos, end, &len);
+  if (len == 0 || len >= sizeof stat->name) {
+    return FALSE;
+  }
+  memcpy (stat->name, field, len);
+  stat->name[len] = '\0';
+  stat->major = fields[0];
+  stat->minor = fields[1];
+
+  for (guint i = 0; i < G_N_ELEMENTS (fields); i++) {
+    field = next_field (&pos, end, &len);
+    if (len == 0 || !g_ascii_isdigit (*field)) {
+      return FALSE;
+    }
+    fields[i] = g_ascii_strtoull (field, NULL, 10);
+  }
+
+  stat->reads = fields[0];
+  stat->read_sectors = fields[2];
+  stat->read_ticks = fields[3];
+  stat->writes = fields[4];
+  stat->write_sectors = fields[6];
+  stat->write_ticks = fields[7];
+  stat->io_ticks = fields[9];
+
+  return TRUE;
+}
+
+
+/* Adds the devices of @contents, @size bytes of /proc/diskstats, to
+ * @disks, leaving the flags to the caller */
+static void
+parse_diskstats (const char *contents, gsize size, GArray *disks)
+{
+  const char *end = contents + size;
+
+  for (const char *line = contents; line < end;) {
+    const char *eol = memchr (line, '\n', end - line);
+    GsmDiskStat stat = { 0 };
+
+    if (eol == NULL) {
+      eol = end;
+    }
+
+    if (parse_line (line, eol, &stat)) {
+      g_array_append_val (disks, stat);
+    }
+
+    line = eol + 1;
+  }
+}
+
+
+/* Reads the whole file into the buffer, kept from one update to the
+ * next, with an offset as the file stays open */
+static gssize
+read_diskstats (GsmDiskstats *self, GError **error)
+{
+  gsize size = 0;
+
+  if (self->fd < 0) {
+    self->fd = g_open (DISKSTATS, O_RDONLY | O_CLOEXEC, 0);
+    if (self->fd < 0) {
+      set_diskstats_error (error, errno, DISKSTATS);
+      return -1;
+    }
+  }
+
+  for (;;) {
+    gssize count;
+
+    if (size == self->buffer_size) {
+      self->buffer_size *= 2;
+      self->buffer = g_realloc (self->buffer, self->buffer_size);
+    }
+
+    count = pread (self->fd, self->buffer + size, self->buffer_size - size, size);
+
+    if (count < 0 && errno == EINTR) {
+      continue;
+    }
+
+    if (count < 0) {
+      set_diskstats_error (error, errno, DISKSTATS);
+      return -1;
+    }
+
+    if (count == 0) {
+      return size;
+    }
+
+    size += count;
+  }
+}
+
+
+gboolean
+gsm_diskstats_read (GsmDiskstats  *self,
+                    GArray        *disks,
+                    GError       **error)
+{
+  gssize size;
+
+  g_return_val_if_fail (self != NULL, FALSE);
+
+  g_array_set_size (disks, 0);
+
+  size = read_diskstats (self, error);
+  if (size < 0) {
+    return FALSE;
+  }
+
+  parse_diskstats (self->buffer, size, disks);
+  classify_disks (self, disks);
+
+  return TRUE;
+}
+
+
+gboolean
+gsm_disk_stat_rates (const GsmDiskStat *old,
+                     const GsmDiskStat *now,
+                     double             seconds,
+                     GsmDiskRates      *rates)
+{
+  guint64 requests;
+
+  memset (rates, 0, sizeof *rates);
+
+  if (seconds <= 0.0 ||
+      now->reads < old->reads || now->writes < old->writes ||
+      now->read_sectors < old->read_sectors || now->write_sectors < old->write_sectors ||
+      now->read_ticks < old->read_ticks || now->write_ticks < old->write_ticks ||
+      now->io_ticks < old->io_ticks) {
+    return FALSE;
+  }
+
+  requests = (now->reads - old->reads) + (now->writes - old->writes);
+
+  /* The sectors of diskstats are 512 bytes, whatever the device */
+  rates->read_bytes = (now->read_sectors - old->read_sectors) * 512.0 / seconds;
+  rates->write_bytes = (now->write_sectors - old->write_sectors) * 512.0 / seconds;
+  rates->iops = requests / seconds;
+  if (requests > 0) {
+    rates->latency = (double) ((now->read_ticks - old->read_ticks) +
+                               (now->write_ticks - old->write_ticks)) / requests;
+  }
+  rates->utilization = MIN ((now->io_ticks - old->io_ticks) / (seconds * 1000.0), 1.0);
+
+  return TRUE;
+}
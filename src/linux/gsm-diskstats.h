@@ -0,0 +1,82 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#pragma once
+
+#include <glib.h>
+#include <gmodule.h>
+
+G_BEGIN_DECLS
+
+/*
+ * Counters of every block device read from a single parse of
+ * /proc/diskstats.  Each device is classified once from sysfs, so that
+ * the partitions and the devices stacked on other ones (device mapper,
+ * md RAID, loop), whose requests are counted again on the disks below
+ * them, can be left out of the totals.
+ */
+typedef struct _GsmDiskstats GsmDiskstats;
+
+typedef enum {
+  GSM_DISK_PARTITION = 1 << 0,
+  /* Has its requests sent to other block devices: dm, md, loop */
+  GSM_DISK_STACKED   = 1 << 1,
+} GsmDiskFlags;
+
+typedef struct {
+  char name[32];
+  guint major;
+  guint minor;
+  GsmDiskFlags flags;
+  /* Completed requests, sectors of 512 bytes and time spent in ms */
+  guint64 reads;
+  guint64 read_sectors;
+  guint64 read_ticks;
+  guint64 writes;
+  guint64 write_sectors;
+  guint64 write_ticks;
+  /* Time with requests in flight, in ms */
+  guint64 io_ticks;
+} GsmDiskStat;
+
+/* Derived from two samples of the same device */
+typedef struct {
+  double read_bytes;
+  double write_bytes;
+  double iops;
+  /* Average time of a request in ms, 0 without requests */
+  double latency;
+  /* Part of the time with requests in flight, 0 to 1 */
+  double utilization;
+} GsmDiskRates;
+
+G_MODULE_EXPORT
+GsmDiskstats *gsm_diskstats_new   (void);
+G_MODULE_EXPORT
+void          gsm_diskstats_free  (GsmDiskstats  *self);
+
+/* Replaces the content of @disks, an array of GsmDiskStat, with the
+ * block devices of the system */
+G_MODULE_EXPORT
+gboolean      gsm_diskstats_read  (GsmDiskstats  *self,
+                                   GArray        *disks,
+                                   GError       **error);
+
+/* Rates between @old and @now, @seconds apart; FALSE if the counters
+ * went back, as when the device was replaced */
+G_MODULE_EXPORT
+gboolean      gsm_disk_stat_rates (const GsmDiskStat *old,
+                                   const GsmDiskStat *now,
+                                   double             seconds,
+                                   GsmDiskRates      *rates);
+
+static inline gboolean
+gsm_disk_stat_is_whole_disk (const GsmDiskStat *stat)
+{
+  return !(stat->flags & (GSM_DISK_PARTITION | GSM_DISK_STACKED));
+}
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (GsmDiskstats, gsm_diskstats_free)
+
+G_END_DECLS
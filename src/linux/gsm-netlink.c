@@ -0,0 +1,257 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <linux/if_link.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+
+#include <glib.h>
+#include <gio/gio.h>
+
+#include "gsm-netlink.h"
+
+/* Large enough for any message of a dump, see NLMSG_GOODSIZE */
+#define BUFFER_SIZE 65536
+
+struct _GsmNetlink {
+  int fd;
+  guint32 seq;
+  guint8 *buffer;
+};
+
+
+static void
+set_error_from_errno (GError **error, int saved_errno, const char *what)
+{
+  g_set_error (error, G_IO_ERROR, g_io_error_from_errno (saved_errno),
+               "netlink: %s: %s", what, g_strerror (saved_errno));
+}
+
+
+GsmNetlink *
+gsm_netlink_new (GError **error)
+{
+  struct sockaddr_nl address = { .nl_family = AF_NETLINK };
+  GsmNetlink *self;
+  int fd;
+
+  fd = socket (AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+  if (fd < 0) {
+    set_error_from_errno (error, errno, "socket");
+    return NULL;
+  }
+
+  if (bind (fd, (struct sockaddr *) &address, sizeof address) < 0) {
+    set_error_from_errno (error, errno, "bind");
+    close (fd);
+    return NULL;
+  }
+
+  self = g_new0 (GsmNetlink, 1);
+  self->fd = fd;
+  self->buffer = g_malloc (BUFFER_SIZE);
+
+  return self;
+}
+
+
+void
+gsm_netlink_free (GsmNetlink *self)
+{
+  if (self == NULL) {
+    return;
+  }
+
+  close (self->fd);
+  g_free (self->buffer);
+  g_free (self);
+}
+
+
+static gboolean
+link_is_virtual (const struct rtattr *linkinfo)
+{
+  const struct rtattr *attr;
+  int len = RTA_PAYLOAD (linkinfo);
+
+  for (attr = RTA_DATA (linkinfo); RTA_OK (attr, len); attr = RTA_NEXT (attr, len)) {
+    if (attr->rta_type == IFLA_INFO_KIND && RTA_PAYLOAD (attr) > 1) {
+      return TRUE;
+    }
+  }
+
+  return FALSE;
+}
+
+
+static void
+parse_link (const struct nlmsghdr *message, GArray *links)
+{
+  const struct ifinfomsg *info = NLMSG_DATA (message);
+  const struct rtattr *attr;
+  int len = IFLA_PAYLOAD (message);
+  GsmNetLink link = { .index = info->ifi_index };
+  gboolean has_stats64 = FALSE;
+
+  if (message->nlmsg_len < NLMSG_LENGTH (sizeof *info)) {
+    return;
+  }
+
+  if (info->ifi_flags & IFF_UP) {
+    link.flags |= GSM_NET_LINK_UP;
+  }
+  if (info->ifi_flags & IFF_LOOPBACK) {
+    link.flags |= GSM_NET_LINK_LOOPBACK;
+  }
+
+  for (attr = IFLA_RTA (info); RTA_OK (attr, len); attr = RTA_NEXT (attr, len)) {
+    switch (attr->rta_type) {
+      case IFLA_IFNAME:
+        memcpy (link.name, RTA_DATA (attr), MIN (RTA_PAYLOAD (attr), sizeof link.name - 1));
+        break;
+
+      case IFLA_STATS64:
+        {
+          /* Not aligned on 8 bytes */
+          struct rtnl_link_stats64 stats = { 0 };
+
+          memcpy (&stats, RTA_DATA (attr), MIN (RTA_PAYLOAD (attr), sizeof stats));
+          link.rx_bytes = stats.rx_bytes;
+          link.tx_bytes = stats.tx_bytes;
+          has_stats64 = TRUE;
+        }
+        break;
+
+      case IFLA_STATS:
+        if (!has_stats64) {
+          struct rtnl_link_stats stats = { 0 };
+
+          memcpy (&stats, RTA_DATA (attr), MIN (RTA_PAYLOAD (attr), sizeof stats));
+          link.rx_bytes = stats.rx_bytes;
+          link.tx_bytes = stats.tx_bytes;
+        }
+        break;
+
+      case IFLA_LINKINFO:
+        if (link_is_virtual (attr)) {
+          link.flags |= GSM_NET_LINK_VIRTUAL;
+        }
+        break;
+
+      default:
+        break;
+    }
+  }
+
+  /* memcpy () above kept the last byte 0 */
+  if (link.name[0] != '\0') {
+    g_array_append_val (links, link);
+  }
+}
+
+
+/*
+ * Adds the links of the messages in @buffer to @links, sets @done once
+ * the end of the dump of sequence number @seq is reached.
+ */
+static gboolean
+parse_links (const guint8  *buffer,
+             gsize          size,
+             guint32        seq,
+             GArray        *links,
+             gboolean      *done,
+             GError       **error)
+{
+  const struct nlmsghdr *message;
+  int len = size;
+
+  for (message = (const struct nlmsghdr *) buffer; NLMSG_OK (message, len); message = NLMSG_NEXT (message, len)) {
+    if (message->nlmsg_seq != seq) {
+      continue;
+    }
+
+    switch (message->nlmsg_type) {
+      case NLMSG_DONE:
+        *done = TRUE;
+        return TRUE;
+
+      case NLMSG_ERROR:
+        {
+          const struct nlmsgerr *err = NLMSG_DATA (message);
+
+          if (message->nlmsg_len < NLMSG_LENGTH (sizeof *err)) {
+            set_error_from_errno (error, EBADMSG, "RTM_GETLINK");
+          } else {
+            set_error_from_errno (error, -err->error, "RTM_GETLINK");
+          }
+          return FALSE;
+        }
+
+      case RTM_NEWLINK:
+        parse_link (message, links);
+        break;
+
+      default:
+        break;
+    }
+  }
+
+  return TRUE;
+}
+
+
+gboolean
+gsm_netlink_get_links (GsmNetlink  *self,
+                       GArray      *links,
+                       GError     **error)
+{
+  struct {
+    struct nlmsghdr header;
+    struct ifinfomsg info;
+  } request = {
+    .header = {
+      .nlmsg_len = sizeof request,
+      .nlmsg_type = RTM_GETLINK,
+      .nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP,
+      .nlmsg_seq = ++self->seq,
+    },
+    .info = { .ifi_family = AF_UNSPEC },
+  };
+  gboolean done = FALSE;
+
+  g_return_val_if_fail (self != NULL, FALSE);
+
+  g_array_set_size (links, 0);
+
+  if (send (self->fd, &request, sizeof request, 0) < 0) {
+    set_error_from_errno (error, errno, "send");
+    return FALSE;
+  }
+
+  while (!done) {
+    ssize_t size = recv (self->fd, self->buffer, BUFFER_SIZE, 0);
+
+    if (size < 0 && errno == EINTR) {
+      continue;
+    }
+
+    if (size <= 0) {
+      set_error_from_errno (error, size < 0 ? errno : ECONNRESET, "recv");
+      return FALSE;
+    }
+
+    if (!parse_links (self->buffer, size, self->seq, links, &done, error)) {
+      return FALSE;
+    }
+  }
+
+  return TRUE;
+}
@@ -0,0 +1,50 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#pragma once
+
+#include <net/if.h>
+
+#include <glib.h>
+#include <gmodule.h>
+
+G_BEGIN_DECLS
+
+/*
+ * Statistics of every network interface read from a single rtnetlink
+ * RTM_GETLINK dump, rather than one read per interface: the counters of
+ * hundreds of interfaces come in a few messages.
+ */
+typedef struct _GsmNetlink GsmNetlink;
+
+typedef enum {
+  GSM_NET_LINK_UP       = 1 << 0,
+  GSM_NET_LINK_LOOPBACK = 1 << 1,
+  /* A software device, with a kind: bridge, veth, tun, bond, ... */
+  GSM_NET_LINK_VIRTUAL  = 1 << 2,
+} GsmNetLinkFlags;
+
+typedef struct {
+  int index;
+  char name[IF_NAMESIZE];
+  GsmNetLinkFlags flags;
+  guint64 rx_bytes;
+  guint64 tx_bytes;
+} GsmNetLink;
+
+G_MODULE_EXPORT
+GsmNetlink *gsm_netlink_new       (GError     **error);
+G_MODULE_EXPORT
+void        gsm_netlink_free      (GsmNetlink  *self);
+
+/* Replaces the content of @links, an array of GsmNetLink, with the
+ * interfaces of the system */
+G_MODULE_EXPORT
+gboolean    gsm_netlink_get_links (GsmNetlink  *self,
+                                   GArray      *links,
+                                   GError     **error);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (GsmNetlink, gsm_netlink_free)
+
+G_END_DECLS
@@ -0,0 +1,350 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <glib.h>
+#include <glib-unix.h>
+#include <glib/gstdio.h>
+#include <gio/gio.h>
+
+#include "gsm-pressure.h"
+
+#define PROC_PRESSURE "/proc/pressure"
+#define SYSFS_CGROUP "/sys/fs/cgroup"
+
+/* Unprivileged triggers have windows of a multiple of this */
+#define UNPRIVILEGED_WINDOW (2 * G_USEC_PER_SEC)
+
+struct _GsmPressure {
+  int fds[GSM_PRESSURE_N_RESOURCES];
+  char *paths[GSM_PRESSURE_N_RESOURCES];
+};
+
+struct _GsmPressureTrigger {
+  int fd;
+  char *path;
+  guint source;
+  GsmPressureResource resource;
+  GsmPressureTriggerFunc func;
+  gpointer user_data;
+};
+
+
+static void
+set_pressure_error (GError **error, int saved_errno, const char *path)
+{
+  g_set_error (error, G_IO_ERROR, g_io_error_from_errno (saved_errno),
+               "%s: %s", path, g_strerror (saved_errno));
+}
+
+
+static char *
+pressure_path (const char *cgroup, GsmPressureResource resource)
+{
+  static const char *const names[] = { "cpu", "memory", "io" };
+  g_autofree char *name = NULL;
+
+  G_STATIC_ASSERT (G_N_ELEMENTS (names) == GSM_PRESSURE_N_RESOURCES);
+
+  if (cgroup == NULL) {
+    return g_build_filename (PROC_PRESSURE, names[resource], NULL);
+  }
+
+  name = g_strconcat (names[resource], ".pressure", NULL);
+
+  return g_build_filename (SYSFS_CGROUP, cgroup, name, NULL);
+}
+
+
+GsmPressure *
+gsm_pressure_new (const char  *cgroup,
+                  GError     **error)
+{
+  g_autoptr (GsmPressure) self = g_new0 (GsmPressure, 1);
+
+  for (guint i = 0; i < GSM_PRESSURE_N_RESOURCES; i++) {
+    self->fds[i] = -1;
+  }
+
+  for (guint i = 0; i < GSM_PRESSURE_N_RESOURCES; i++) {
+    self->paths[i] = pressure_path (cgroup, i);
+    self->fds[i] = g_open (self->paths[i], O_RDONLY | O_CLOEXEC, 0);
+    if (self->fds[i] < 0) {
+      set_pressure_error (error, errno, self->paths[i]);
+      return NULL;
+    }
+  }
+
+  return g_steal_pointer (&self);
+}
+
+
+void
+gsm_pressure_free (GsmPressure *self)
+{
+  if (self == NULL) {
+    return;
+  }
+
+  for (guint i = 0; i < GSM_PRESSURE_N_RESOURCES; i++) {
+    if (self->fds[i] >= 0) {
+      close (self->fds[i]);
+    }
+    g_free (self->paths[i]);
+  }
+  g_free (self);
+}
+
+
+/*
+ * A line of a pressure file:
+ *   some avg10=0.12 avg60=0.05 avg300=0.01 total=123456
+ * returns FALSE if it is neither some nor full
+ */
+static gboolean
+parse_pressure_line (const char *line, GsmPressureStat *stat)
+{
+  GsmPressureLine *pressure;
+  const char *end;
+
+  if (g_str_has_prefix (line, "some ")) {
+    pressure = &stat->some;
+  } else if (g_str_has_prefix (line, "full ")) {
+    pressure = &stat->full;
+    stat->has_full = TRUE;
+  } else {
+    return FALSE;
+  }
+
+  for (const char *field = line + 5; *field != '\0' && *field != '\n'; field = end) {
+    end = field + strcspn (field, " \n");
+
+    if (g_str_has_prefix (field, "avg10=")) {
+      pressure->avg10 = g_ascii_strtod (field + 6, NULL);
+    } else if (g_str_has_prefix (field, "avg60=")) {
+      pressure->avg60 = g_ascii_strtod (field + 6, NULL);
+    } else if (g_str_has_prefix (field, "avg300=")) {
+      pressure->avg300 = g_ascii_strtod (field + 7, NULL);
+    } else if (g_str_has_prefix (field, "total=")) {
+      pressure->total = g_ascii_strtoull (field + 6, NULL, 10);
+    }
+
+    while (*end == ' ') {
+      end++;
+    }
+  }
+
+  return TRUE;
+}
+
+
+/* @contents has to be nul terminated */
+static void
+parse_pressure (const char *contents, GsmPressureStat *stat)
+{
+  memset (stat, 0, sizeof *stat);
+
+  for (const char *line = contents; line != NULL && *line != '\0';) {
+    const char *eol = strchr (line, '\n');
+
+    parse_pressure_line (line, stat);
+    line = eol ? eol + 1 : NULL;
+  }
+}
+
+
+static void
+list_cgroups (const char *root, const char *cgroup, GPtrArray *cgroups)
+{
+  g_autofree char *path = g_build_filename (root, cgroup, NULL);
+  g_autoptr (GDir) dir = g_dir_open (path, 0, NULL);
+  const char *name;
+
+  while (dir && (name = g_dir_read_name (dir)) != NULL) {
+    char *child;
+
+    if (!g_str_has_suffix (name, ".slice") &&
+        !(g_str_has_prefix (name, "user@") && g_str_has_suffix (name, ".service"))) {
+      continue;
+    }
+
+    child = cgroup[0] ? g_strconcat (cgroup, "/", name, NULL) : g_strdup (name);
+    g_ptr_array_add (cgroups, child);
+    list_cgroups (root, child, cgroups);
+  }
+}
+
+
+static int
+compare_cgroups (gconstpointer a, gconstpointer b)
+{
+  return strcmp (*(const char *const *) a, *(const char *const *) b);
+}
+
+
+static GStrv
+list_cgroups_below (const char *root)
+{
+  GPtrArray *cgroups = g_ptr_array_new ();
+
+  list_cgroups (root, "", cgroups);
+  g_ptr_array_sort (cgroups, compare_cgroups);
+  g_ptr_array_add (cgroups, NULL);
+
+  return (GStrv) g_ptr_array_free (cgroups, FALSE);
+}
+
+
+GStrv
+gsm_pressure_list_cgroups (void)
+{
+  return list_cgroups_below (SYSFS_CGROUP);
+}
+
+
+gboolean
+gsm_pressure_read (GsmPressure      *self,
+                   GsmPressureStat   stats[GSM_PRESSURE_N_RESOURCES],
+                   GError          **error)
+{
+  g_return_val_if_fail (self != NULL, FALSE);
+
+  for (guint i = 0; i < GSM_PRESSURE_N_RESOURCES; i++) {
+    /* Two lines of less than 80 characters */
+    char buffer[256];
+    gssize size;
+
+    do {
+      size = pread (self->fds[i], buffer, sizeof buffer - 1, 0);
+    } while (size < 0 && errno == EINTR);
+
+    if (size < 0) {
+      set_pressure_error (error, errno, self->paths[i]);
+      return FALSE;
+    }
+
+    buffer[size] = '\0';
+    parse_pressure (buffer, &stats[i]);
+  }
+
+  return TRUE;
+}
+
+
+double
+gsm_pressure_stall (const GsmPressureLine *old,
+                    const GsmPressureLine *now,
+                    gint64                 usec)
+{
+  if (usec <= 0 || now->total < old->total) {
+    return 0.0;
+  }
+
+  return CLAMP ((double) (now->total - old->total) / usec, 0.0, 1.0);
+}
+
+
+static gboolean
+trigger_cb (G_GNUC_UNUSED int fd, GIOCondition condition, gpointer data)
+{
+  GsmPressureTrigger *self = data;
+
+  if (condition & G_IO_ERR) {
+    /* The cgroup was removed */
+    g_debug ("%s: trigger removed", self->path);
+    self->source = 0;
+    return G_SOURCE_REMOVE;
+  }
+
+  self->func (self->resource, self->user_data);
+
+  return G_SOURCE_CONTINUE;
+}
+
+
+/* Returns 0 or the errno of the write */
+static int
+write_trigger (int fd, guint64 stall_us, guint64 window_us)
+{
+  char trigger[64];
+
+  g_snprintf (trigger, sizeof trigger, "some %" G_GUINT64_FORMAT " %" G_GUINT64_FORMAT,
+              stall_us, window_us);
+
+  /* With its nul byte, see Documentation/accounting/psi.rst */
+  return write (fd, trigger, strlen (trigger) + 1) < 0 ? errno : 0;
+}
+
+
+GsmPressureTrigger *
+gsm_pressure_trigger_new (const char              *cgroup,
+                          GsmPressureResource      resource,
+                          guint64                  stall_us,
+                          guint64                  window_us,
+                          GsmPressureTriggerFunc   func,
+                          gpointer                 user_data,
+                          GError                 **error)
+{
+  g_autoptr (GsmPressureTrigger) self = NULL;
+  int saved_errno;
+
+  g_return_val_if_fail (resource < GSM_PRESSURE_N_RESOURCES, NULL);
+  g_return_val_if_fail (stall_us > 0 && stall_us <= window_us, NULL);
+
+  self = g_new0 (GsmPressureTrigger, 1);
+  self->fd = -1;
+  self->path = pressure_path (cgroup, resource);
+  self->resource = resource;
+  self->func = func;
+  self->user_data = user_data;
+
+  self->fd = g_open (self->path, O_RDWR | O_NONBLOCK | O_CLOEXEC, 0);
+  if (self->fd < 0) {
+    set_pressure_error (error, errno, self->path);
+    return NULL;
+  }
+
+  saved_errno = write_trigger (self->fd, stall_us, window_us);
+
+  /* EINVAL for the window, or EPERM before Linux 6.5 */
+  if (saved_errno == EINVAL) {
+    const guint64 unprivileged = (window_us + UNPRIVILEGED_WINDOW - 1) / UNPRIVILEGED_WINDOW * UNPRIVILEGED_WINDOW;
+
+    if (unprivileged != window_us) {
+      saved_errno = write_trigger (self->fd, stall_us * unprivileged / window_us, unprivileged);
+    }
+  }
+
+  if (saved_errno) {
+    set_pressure_error (error, saved_errno, self->path);
+    return NULL;
+  }
+
+  self->source = g_unix_fd_add (self->fd, G_IO_PRI | G_IO_ERR, trigger_cb, self);
+
+  return g_steal_pointer (&self);
+}
+
+
+void
+gsm_pressure_trigger_free (GsmPressureTrigger *self)
+{
+  if (self == NULL) {
+    return;
+  }
+
+  g_clear_handle_id (&self->source, g_source_remove);
+  /* Which removes the trigger */
+  if (self->fd >= 0) {
+    close (self->fd);
+  }
+  g_free (self->path);
+  g_free (self);
+}
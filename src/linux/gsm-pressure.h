@@ -0,0 +1,97 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#pragma once
+
+#include <glib.h>
+#include <gmodule.h>
+
+G_BEGIN_DECLS
+
+/*
+ * Pressure stall information, see Documentation/accounting/psi.rst: the
+ * time tasks were stalled waiting for a CPU, for memory or for I/O, of
+ * the whole system or of a cgroup.
+ */
+typedef struct _GsmPressure GsmPressure;
+
+typedef enum {
+  GSM_PRESSURE_CPU,
+  GSM_PRESSURE_MEMORY,
+  GSM_PRESSURE_IO,
+  GSM_PRESSURE_N_RESOURCES
+} GsmPressureResource;
+
+typedef struct {
+  /* Percentages of stalled time over 10 s, 1 and 5 minutes */
+  double avg10;
+  double avg60;
+  double avg300;
+  /* Stalled time in µs */
+  guint64 total;
+} GsmPressureLine;
+
+typedef struct {
+  /* Some of the tasks stalled */
+  GsmPressureLine some;
+  /* All of them, none for the CPU of the system before Linux 5.13 */
+  GsmPressureLine full;
+  gboolean has_full;
+} GsmPressureStat;
+
+/* Of the system if @cgroup is NULL, else of the cgroup at this path
+ * below /sys/fs/cgroup */
+G_MODULE_EXPORT
+GsmPressure *gsm_pressure_new   (const char      *cgroup,
+                                 GError         **error);
+G_MODULE_EXPORT
+void         gsm_pressure_free  (GsmPressure     *self);
+
+G_MODULE_EXPORT
+gboolean     gsm_pressure_read  (GsmPressure     *self,
+                                 GsmPressureStat  stats[GSM_PRESSURE_N_RESOURCES],
+                                 GError         **error);
+
+/* The cgroups worth a look at their pressure, as paths below
+ * /sys/fs/cgroup, sorted: the slices of systemd, and the user managers
+ * with the applications of their users */
+G_MODULE_EXPORT
+GStrv        gsm_pressure_list_cgroups (void);
+
+/* Part of the @usec µs between @old and @now that was stalled, from 0
+ * to 1 */
+G_MODULE_EXPORT
+double       gsm_pressure_stall (const GsmPressureLine *old,
+                                 const GsmPressureLine *now,
+                                 gint64                 usec);
+
+/*
+ * A trigger of the kernel, which makes the pressure file readable when
+ * some task stalled @stall_us within a @window_us window, at most once
+ * per window.  It is watched from the main loop, without reading the
+ * file until then.
+ */
+typedef struct _GsmPressureTrigger GsmPressureTrigger;
+
+typedef void (*GsmPressureTriggerFunc) (GsmPressureResource resource,
+                                        gpointer            user_data);
+
+/* Without the CAP_SYS_RESOURCE capability, Linux 6.5 and later only
+ * take windows of a multiple of 2 s: the window is then rounded up and
+ * the stall scaled with it */
+G_MODULE_EXPORT
+GsmPressureTrigger *gsm_pressure_trigger_new  (const char              *cgroup,
+                                               GsmPressureResource      resource,
+                                               guint64                  stall_us,
+                                               guint64                  window_us,
+                                               GsmPressureTriggerFunc   func,
+                                               gpointer                 user_data,
+                                               GError                 **error);
+G_MODULE_EXPORT
+void                gsm_pressure_trigger_free (GsmPressureTrigger      *self);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (GsmPressure, gsm_pressure_free)
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (GsmPressureTrigger, gsm_pressure_trigger_free)
+
+G_END_DECLS
@@ -0,0 +1,272 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <gio/gio.h>
+
+#include "gsm-procstat.h"
+
+#define PROC_STAT "/proc/stat"
+
+struct _GsmProcStat {
+  int fd;
+  char *buffer;
+  gsize buffer_size;
+};
+
+/* The states of the fields of a cpu line, in their order; guest and
+ * guest_nice come after them but are already counted in user and nice */
+static const GsmCpuState cpu_fields[] = {
+  GSM_CPU_USER,
+  GSM_CPU_NICE,
+  GSM_CPU_SYSTEM,
+  GSM_CPU_IDLE,
+  GSM_CPU_IOWAIT,
+  GSM_CPU_IRQ,
+  GSM_CPU_SOFTIRQ,
+  GSM_CPU_STEAL,
+};
+
+
+static void
+set_proc_stat_error (GError **error, int saved_errno)
+{
+  g_set_error (error, G_IO_ERROR, g_io_error_from_errno (saved_errno),
+               "%s: %s", PROC_STAT, g_strerror (saved_errno));
+}
+
+
+GsmProcStat *
+gsm_proc_stat_new (void)
+{
+  GsmProcStat *self = g_new0 (GsmProcStat, 1);
+
+  self->fd = -1;
+  self->buffer_size = 4096;
+  self->buffer = g_malloc (self->buffer_size);
+
+  return self;
+}
+
+
+void
+gsm_proc_stat_free (GsmProcStat *self)
+{
+  if (self == NULL) {
+    return;
+  }
+
+  if (self->fd >= 0) {
+    close (self->fd);
+  }
+  g_free (self->buffer);
+  g_free (self);
+}
+
+
+/*
+ * A line of /proc/stat, nul terminated or followed by another one:
+ *   cpu3 user nice system idle iowait irq softirq steal guest guest_nice
+ * returns its row, 0 for the total, or -1 if it is not a cpu line.  Older
+ * kernels have less fields, the missing ones are left to 0.
+ */
+static int
+parse_cpu_line (const char *line, guint64 counters[GSM_CPU_N_STATES])
+{
+  const char *pos = line + 3;
+  char *end;
+  int row = 0;
+
+  if (!g_str_has_prefix (line, "cpu")) {
+    return -1;
+  }
+
+  if (g_ascii_isdigit (*pos)) {
+    const guint64 cpu = g_ascii_strtoull (pos, &end, 10);
+
+    if (cpu >= G_MAXINT) {
+      return -1;
+    }
+    row = cpu + 1;
+    pos = end;
+  }
+
+  if (*pos != ' ') {
+    return -1;
+  }
+
+  memset (counters, 0, GSM_CPU_N_STATES * sizeof *counters);
+
+  for (guint i = 0; i < G_N_ELEMENTS (cpu_fields); i++) {
+    while (*pos == ' ') {
+      pos++;
+    }
+    if (!g_ascii_isdigit (*pos)) {
+      break;
+    }
+    counters[cpu_fields[i]] = g_ascii_strtoull (pos, &end, 10);
+    pos = end;
+  }
+
+  return row;
+}
+
+
+/* Fills @times, zeroed, from @contents, nul terminated */
+static void
+parse_stat (const char *contents, guint n_cpus, guint64 *times)
+{
+  for (const char *line = contents; line != NULL && *line != '\0';) {
+    const char *eol = strchr (line, '\n');
+    guint64 counters[GSM_CPU_N_STATES];
+    const int row = parse_cpu_line (line, counters);
+
+    /* The cpu lines come first */
+    if (row < 0) {
+      break;
+    }
+
+    /* Not a CPU that was there when the graph started */
+    if ((guint) row <= n_cpus) {
+      memcpy (times + (gsize) row * GSM_CPU_N_STATES, counters, sizeof counters);
+    }
+
+    line = eol ? eol + 1 : NULL;
+  }
+}
+
+
+/* Whether the last @count bytes read, out of @size, end the cpu lines */
+static gboolean
+past_cpu_lines (const char *buffer, gsize size, gsize count)
+{
+  /* Again from the end of the previous read, a line could start there */
+  const gsize from = size - count >= 3 ? size - count - 3 : 0;
+
+  for (const char *eol = memchr (buffer + from, '\n', size - from); eol != NULL;
+       eol = memchr (eol + 1, '\n', buffer + size - eol - 1)) {
+    const gsize left = buffer + size - eol - 1;
+
+    if (left >= 3 && memcmp (eol + 1, "cpu", 3) != 0) {
+      return TRUE;
+    }
+  }
+
+  return FALSE;
+}
+
+
+/* Reads the file into the buffer, kept from one update to the next,
+ * until the end of the cpu lines as the interrupts come next and are
+ * much longer with many CPUs */
+static gssize
+read_stat (GsmProcStat *self, GError **error)
+{
+  gsize size = 0;
+
+  if (self->fd < 0) {
+    self->fd = g_open (PROC_STAT, O_RDONLY | O_CLOEXEC, 0);
+    if (self->fd < 0) {
+      set_proc_stat_error (error, errno);
+      return -1;
+    }
+  }
+
+  for (;;) {
+    gssize count;
+
+    /* With room for a nul byte */
+    if (size + 1 >= self->buffer_size) {
+      self->buffer_size *= 2;
+      self->buffer = g_realloc (self->buffer, self->buffer_size);
+    }
+
+    count = pread (self->fd, self->buffer + size, self->buffer_size - size - 1, size);
+
+    if (count < 0 && errno == EINTR) {
+      continue;
+    }
+
+    if (count < 0) {
+      set_proc_stat_error (error, errno);
+      return -1;
+    }
+
+    size += count;
+
+    if (count == 0 || past_cpu_lines (self->buffer, size, count)) {
+      self->buffer[size] = '\0';
+      return size;
+    }
+  }
+}
+
+
+gboolean
+gsm_proc_stat_read (GsmProcStat  *self,
+                    guint         n_cpus,
+                    GArray       *times,
+                    GError      **error)
+{
+  g_return_val_if_fail (self != NULL, FALSE);
+
+  g_array_set_size (times, (gsize) (n_cpus + 1) * GSM_CPU_N_STATES);
+  memset (times->data, 0, (gsize) times->len * sizeof (guint64));
+
+  if (read_stat (self, error) < 0) {
+    return FALSE;
+  }
+
+  parse_stat (self->buffer, n_cpus, (guint64 *) times->data);
+
+  return TRUE;
+}
+
+
+/*
+ * Each row is a fixed number of contiguous counters, so that the deltas
+ * of a row are computed without branches, which the compiler turns into
+ * vector instructions even at -O2.  The deltas between two reads are
+ * less than 2^31 ticks, and some counters, iowait in particular, can go
+ * back a little: the sign bit of their delta clears it.  A CPU brought
+ * online has only zeros in @old, and no deltas then.
+ */
+void
+gsm_cpu_times_shares (const guint64 *restrict old,
+                      const guint64 *restrict now,
+                      guint                   n_rows,
+                      float         *restrict shares)
+{
+  for (guint row = 0; row < n_rows; row++) {
+    const gsize first = (gsize) row * GSM_CPU_N_STATES;
+    guint64 counted = 0;
+    float total = 0.0f;
+
+    for (guint state = 0; state < GSM_CPU_N_STATES; state++) {
+      gint32 delta = (gint32) (now[first + state] - old[first + state]);
+
+      delta &= ~(delta >> 31);
+      shares[first + state] = delta;
+      counted |= old[first + state];
+    }
+
+    for (guint state = 0; state < GSM_CPU_N_STATES; state++) {
+      total += shares[first + state];
+    }
+
+    const float scale = total > 0.0f && counted ? 1.0f / total : 0.0f;
+
+    for (guint state = 0; state < GSM_CPU_N_STATES; state++) {
+      shares[first + state] *= scale;
+    }
+  }
+}
@@ -0,0 +1,57 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#pragma once
+
+#include <glib.h>
+#include <gmodule.h>
+
+G_BEGIN_DECLS
+
+/*
+ * Times of the CPUs by state, read from the cpu lines of /proc/stat: a
+ * row of GSM_CPU_N_STATES counters for the total, then one per CPU.
+ */
+typedef struct _GsmProcStat GsmProcStat;
+
+/* The busy states first, so that they are the first ones of a row */
+typedef enum {
+  GSM_CPU_USER,
+  GSM_CPU_NICE,
+  GSM_CPU_SYSTEM,
+  GSM_CPU_IOWAIT,
+  GSM_CPU_IRQ,
+  GSM_CPU_SOFTIRQ,
+  /* Taken by the hypervisor for other guests */
+  GSM_CPU_STEAL,
+  GSM_CPU_IDLE,
+  GSM_CPU_N_STATES
+} GsmCpuState;
+
+G_MODULE_EXPORT
+GsmProcStat *gsm_proc_stat_new      (void);
+G_MODULE_EXPORT
+void         gsm_proc_stat_free     (GsmProcStat    *self);
+
+/* Replaces the content of @times, an array of guint64, with a row for
+ * the total and one for each of @n_cpus CPUs, in USER_HZ ticks; the
+ * rows of the CPUs that are offline are zeros */
+G_MODULE_EXPORT
+gboolean     gsm_proc_stat_read     (GsmProcStat    *self,
+                                     guint           n_cpus,
+                                     GArray         *times,
+                                     GError        **error);
+
+/* Part of the time of each state between @old and @now, from 0 to 1,
+ * for @n_rows rows, all zeros for a row that did not change or that is
+ * all zeros in @old */
+G_MODULE_EXPORT
+void         gsm_cpu_times_shares   (const guint64  *old,
+                                     const guint64  *now,
+                                     guint           n_rows,
+                                     float          *shares);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (GsmProcStat, gsm_proc_stat_free)
+
+G_END_DECLS
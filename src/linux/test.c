@@ -0,0 +1,589 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <glib.h>
+
+#include "gsm-diskstats.c"
+#include "gsm-netlink.c"
+#include "gsm-pressure.c"
+#include "gsm-procstat.c"
+
+
+/* With the discard and flush fields of recent kernels, or without */
+static const char diskstats[] =
+  "   8       0 sda 1000 50 80000 400 2000 100 160000 1600 0 1500 2000 0 0 0 0 10 5\n"
+  "   8       1 sda1 900 50 70000 380 1900 100 150000 1500 0 1400 1880\n"
+  " 253       0 dm-0 800 0 60000 500 1800 0 140000 2000 0 1300 2500\n"
+  "   7       0 loop0 10 0 20 1 0 0 0 0 0 1 1\n"
+  " 259       0 nvme0n1 5 0 8 0 0 0 0 0 0\n"
+  "bogus line\n";
+
+
+static void
+make_sysfs_entry (const char *sysfs, const char *name, const char *entry)
+{
+  g_autofree char *path = g_build_filename (sysfs, name, entry, NULL);
+
+  g_assert_cmpint (g_mkdir_with_parents (path, 0755), ==, 0);
+}
+
+
+static void
+remove_sysfs (const char *path)
+{
+  g_autoptr (GDir) dir = g_dir_open (path, 0, NULL);
+  const char *name;
+
+  while (dir && (name = g_dir_read_name (dir)) != NULL) {
+    g_autofree char *child = g_build_filename (path, name, NULL);
+
+    remove_sysfs (child);
+  }
+
+  g_remove (path);
+}
+
+
+static void
+test_diskstats_parse (void)
+{
+  g_autoptr (GArray) disks = g_array_new (FALSE, FALSE, sizeof (GsmDiskStat));
+  const GsmDiskStat *stat;
+
+  parse_diskstats (diskstats, sizeof diskstats - 1, disks);
+  g_assert_cmpuint (disks->len, ==, 4);
+
+  stat = &g_array_index (disks, GsmDiskStat, 0);
+  g_assert_cmpstr (stat->name, ==, "sda");
+  g_assert_cmpuint (stat->major, ==, 8);
+  g_assert_cmpuint (stat->minor, ==, 0);
+  g_assert_cmpuint (stat->reads, ==, 1000);
+  g_assert_cmpuint (stat->read_sectors, ==, 80000);
+  g_assert_cmpuint (stat->read_ticks, ==, 400);
+  g_assert_cmpuint (stat->writes, ==, 2000);
+  g_assert_cmpuint (stat->write_sectors, ==, 160000);
+  g_assert_cmpuint (stat->write_ticks, ==, 1600);
+  g_assert_cmpuint (stat->io_ticks, ==, 1500);
+
+  stat = &g_array_index (disks, GsmDiskStat, 1);
+  g_assert_cmpstr (stat->name, ==, "sda1");
+  g_assert_cmpuint (stat->io_ticks, ==, 1400);
+
+  /* Not enough fields for the nvme0n1 line */
+  stat = &g_array_index (disks, GsmDiskStat, 3);
+  g_assert_cmpstr (stat->name, ==, "loop0");
+}
+
+
+static void
+test_diskstats_classify (void)
+{
+  g_autoptr (GsmDiskstats) self = gsm_diskstats_new ();
+  g_autofree char *sysfs = g_dir_make_tmp ("gsm-diskstats-XXXXXX", NULL);
+  g_autoptr (GArray) disks = g_array_new (FALSE, FALSE, sizeof (GsmDiskStat));
+  GsmDiskStat sda = { .major = 8, .name = "sda" };
+  GsmDiskStat sda1 = { .major = 8, .name = "sda1" };
+
+  make_sysfs_entry (sysfs, "sda", "queue");
+  make_sysfs_entry (sysfs, "sda1", "partition");
+  make_sysfs_entry (sysfs, "dm-0", "slaves/sda1");
+  make_sysfs_entry (sysfs, "md0", "slaves");
+  make_sysfs_entry (sysfs, "loop0", "loop");
+  self->sysfs = sysfs;
+
+  g_assert_cmpint (classify (self, "sda", 8), ==, 0);
+  g_assert_cmpint (classify (self, "sda1", 8), ==, GSM_DISK_PARTITION);
+  g_assert_cmpint (classify (self, "dm-0", 253), ==, GSM_DISK_STACKED);
+  g_assert_cmpint (classify (self, "loop0", 7), ==, GSM_DISK_STACKED);
+  /* An md array not assembled yet has no slaves, an unbound loop device
+   * no backing file */
+  g_assert_cmpint (classify (self, "md0", 9), ==, 0);
+  g_assert_cmpint (classify (self, "loop1", 7), ==, 0);
+
+  /* Looked at again once assembled or bound */
+  make_sysfs_entry (sysfs, "md0", "slaves/sda");
+  make_sysfs_entry (sysfs, "loop1", "loop");
+  g_assert_cmpint (classify (self, "md0", 9), ==, GSM_DISK_STACKED);
+  g_assert_cmpint (classify (self, "loop1", 7), ==, GSM_DISK_STACKED);
+
+  /* Forgotten once gone, the name of dm-0 is then given to a device
+   * without slaves */
+  g_array_append_val (disks, sda);
+  g_array_append_val (disks, sda1);
+  classify_disks (self, disks);
+  g_assert_cmpuint (g_hash_table_size (self->flags), ==, 2);
+  remove_sysfs (sysfs);
+  make_sysfs_entry (sysfs, "dm-0", "queue");
+  g_assert_cmpint (classify (self, "dm-0", 253), ==, 0);
+
+  /* The others are kept from the first time */
+  self->sysfs = "/nonexistent";
+  g_assert_cmpint (classify (self, "sda1", 8), ==, GSM_DISK_PARTITION);
+
+  remove_sysfs (sysfs);
+}
+
+
+static void
+test_diskstats_rates (void)
+{
+  GsmDiskStat old = {
+    .reads = 100, .read_sectors = 1000, .read_ticks = 50,
+    .writes = 200, .write_sectors = 4000, .write_ticks = 100, .io_ticks = 1000,
+  };
+  GsmDiskStat now = {
+    .reads = 150, .read_sectors = 3000, .read_ticks = 150,
+    .writes = 250, .write_sectors = 6000, .write_ticks = 200, .io_ticks = 1500,
+  };
+  GsmDiskRates rates;
+
+  g_assert_true (gsm_disk_stat_rates (&old, &now, 2.0, &rates));
+  g_assert_cmpfloat_with_epsilon (rates.read_bytes, 2000 * 512 / 2.0, 1e-6);
+  g_assert_cmpfloat_with_epsilon (rates.write_bytes, 2000 * 512 / 2.0, 1e-6);
+  g_assert_cmpfloat_with_epsilon (rates.iops, 50.0, 1e-6);
+  g_assert_cmpfloat_with_epsilon (rates.latency, 2.0, 1e-6);
+  g_assert_cmpfloat_with_epsilon (rates.utilization, 0.25, 1e-6);
+
+  /* Idle */
+  g_assert_true (gsm_disk_stat_rates (&now, &now, 1.0, &rates));
+  g_assert_cmpfloat (rates.iops, ==, 0.0);
+  g_assert_cmpfloat (rates.latency, ==, 0.0);
+
+  /* Replaced device */
+  g_assert_false (gsm_disk_stat_rates (&now, &old, 1.0, &rates));
+}
+
+
+static void
+test_diskstats_read (void)
+{
+  g_autoptr (GArray) disks = g_array_new (FALSE, FALSE, sizeof (GsmDiskStat));
+  g_autoptr (GError) error = NULL;
+  g_autoptr (GsmDiskstats) self = gsm_diskstats_new ();
+
+  if (g_access (DISKSTATS, R_OK) != 0) {
+    g_test_skip ("no " DISKSTATS);
+    return;
+  }
+
+  /* Twice, the file is read again from its start */
+  for (int i = 0; i < 2; i++) {
+    g_assert_true (gsm_diskstats_read (self, disks, &error));
+    g_assert_no_error (error);
+  }
+}
+
+
+/* Builds netlink messages like the kernel does */
+typedef struct {
+  guint8 data[4096];
+  gsize size;
+  struct nlmsghdr *message;
+} Buffer;
+
+
+static void *
+buffer_append (Buffer *buffer, const void *data, gsize size)
+{
+  void *start = buffer->data + buffer->size;
+
+  g_assert_cmpuint (buffer->size + NLMSG_ALIGN (size), <=, sizeof buffer->data);
+  memset (start, 0, NLMSG_ALIGN (size));
+  if (data) {
+    memcpy (start, data, size);
+  }
+  buffer->size += NLMSG_ALIGN (size);
+  if (buffer->message) {
+    buffer->message->nlmsg_len = buffer->data + buffer->size - (guint8 *) buffer->message;
+  }
+
+  return start;
+}
+
+
+static void
+begin_message (Buffer *buffer, guint16 type, guint32 seq)
+{
+  struct nlmsghdr header = { .nlmsg_type = type, .nlmsg_flags = NLM_F_MULTI, .nlmsg_seq = seq };
+
+  buffer->message = NULL;
+  buffer->message = buffer_append (buffer, &header, sizeof header);
+  buffer->message->nlmsg_len = sizeof header;
+}
+
+
+static struct rtattr *
+append_attr (Buffer *buffer, guint16 type, const void *data, gsize size)
+{
+  struct rtattr header = { .rta_len = RTA_LENGTH (size), .rta_type = type };
+  struct rtattr *attr = buffer_append (buffer, &header, sizeof header);
+
+  buffer_append (buffer, data, size);
+
+  return attr;
+}
+
+
+static void
+append_link (Buffer *buffer, guint32 seq, int index, unsigned flags, const char *name,
+             guint64 rx_bytes, guint64 tx_bytes, const char *kind)
+{
+  struct ifinfomsg info = { .ifi_family = AF_UNSPEC, .ifi_index = index, .ifi_flags = flags };
+  struct rtnl_link_stats64 stats = { .rx_bytes = rx_bytes, .tx_bytes = tx_bytes };
+
+  begin_message (buffer, RTM_NEWLINK, seq);
+  buffer_append (buffer, &info, sizeof info);
+  append_attr (buffer, IFLA_IFNAME, name, strlen (name) + 1);
+  /* 4 bytes aligned only, like in the kernel messages */
+  append_attr (buffer, IFLA_STATS64, &stats, sizeof stats);
+
+  if (kind) {
+    struct rtattr *linkinfo = append_attr (buffer, IFLA_LINKINFO, NULL, 0);
+
+    append_attr (buffer, IFLA_INFO_KIND, kind, strlen (kind) + 1);
+    linkinfo->rta_len = buffer->data + buffer->size - (guint8 *) linkinfo;
+  }
+}
+
+
+static void
+test_netlink_parse_links (void)
+{
+  g_autoptr (GArray) links = g_array_new (FALSE, FALSE, sizeof (GsmNetLink));
+  g_autoptr (GError) error = NULL;
+  Buffer buffer = { 0 };
+  gboolean done = FALSE;
+  const GsmNetLink *link;
+
+  append_link (&buffer, 7, 1, IFF_UP | IFF_LOOPBACK, "lo", 10, 10, NULL);
+  append_link (&buffer, 7, 2, IFF_UP, "enp3s0", G_GUINT64_CONSTANT (5000000000), 42, NULL);
+  append_link (&buffer, 6, 3, IFF_UP, "stale", 1, 1, NULL);
+  append_link (&buffer, 7, 4, 0, "veth1234", 3, 4, "veth");
+
+  g_assert_true (parse_links (buffer.data, buffer.size, 7, links, &done, &error));
+  g_assert_no_error (error);
+  g_assert_false (done);
+  g_assert_cmpuint (links->len, ==, 3);
+
+  link = &g_array_index (links, GsmNetLink, 0);
+  g_assert_cmpstr (link->name, ==, "lo");
+  g_assert_cmpint (link->flags, ==, GSM_NET_LINK_UP | GSM_NET_LINK_LOOPBACK);
+
+  link = &g_array_index (links, GsmNetLink, 1);
+  g_assert_cmpint (link->index, ==, 2);
+  g_assert_cmpstr (link->name, ==, "enp3s0");
+  g_assert_cmpint (link->flags, ==, GSM_NET_LINK_UP);
+  g_assert_cmpuint (link->rx_bytes, ==, G_GUINT64_CONSTANT (5000000000));
+  g_assert_cmpuint (link->tx_bytes, ==, 42);
+
+  link = &g_array_index (links, GsmNetLink, 2);
+  g_assert_cmpstr (link->name, ==, "veth1234");
+  g_assert_cmpint (link->flags, ==, GSM_NET_LINK_VIRTUAL);
+  g_assert_cmpuint (link->rx_bytes, ==, 3);
+  g_assert_cmpuint (link->tx_bytes, ==, 4);
+
+  buffer.size = 0;
+  begin_message (&buffer, NLMSG_DONE, 7);
+  buffer_append (&buffer, NULL, sizeof (int));
+
+  g_assert_true (parse_links (buffer.data, buffer.size, 7, links, &done, &error));
+  g_assert_true (done);
+}
+
+
+static void
+test_netlink_parse_error (void)
+{
+  g_autoptr (GArray) links = g_array_new (FALSE, FALSE, sizeof (GsmNetLink));
+  g_autoptr (GError) error = NULL;
+  struct nlmsgerr err = { .error = -EPERM };
+  Buffer buffer = { 0 };
+  gboolean done = FALSE;
+
+  begin_message (&buffer, NLMSG_ERROR, 1);
+  buffer_append (&buffer, &err, sizeof err);
+
+  g_assert_false (parse_links (buffer.data, buffer.size, 1, links, &done, &error));
+  g_assert_error (error, G_IO_ERROR, G_IO_ERROR_PERMISSION_DENIED);
+}
+
+
+static void
+test_netlink_get_links (void)
+{
+  g_autoptr (GArray) links = g_array_new (FALSE, FALSE, sizeof (GsmNetLink));
+  g_autoptr (GError) error = NULL;
+  g_autoptr (GsmNetlink) netlink = gsm_netlink_new (&error);
+  gboolean has_loopback = FALSE;
+
+  if (netlink == NULL) {
+    g_test_skip (error->message);
+    return;
+  }
+
+  /* Twice, the second dump must not see the end of the first one */
+  for (int i = 0; i < 2; i++) {
+    g_assert_true (gsm_netlink_get_links (netlink, links, &error));
+    g_assert_no_error (error);
+  }
+
+  for (guint i = 0; i < links->len; i++) {
+    has_loopback |= !!(g_array_index (links, GsmNetLink, i).flags & GSM_NET_LINK_LOOPBACK);
+  }
+  g_assert_true (has_loopback);
+}
+
+
+static void
+test_pressure_parse (void)
+{
+  GsmPressureStat stat;
+
+  parse_pressure ("some avg10=1.50 avg60=0.75 avg300=0.10 total=123456789\n"
+                  "full avg10=0.25 avg60=0.00 avg300=12.00 total=42\n", &stat);
+
+  g_assert_cmpfloat_with_epsilon (stat.some.avg10, 1.5, 1e-9);
+  g_assert_cmpfloat_with_epsilon (stat.some.avg60, 0.75, 1e-9);
+  g_assert_cmpfloat_with_epsilon (stat.some.avg300, 0.1, 1e-9);
+  g_assert_cmpuint (stat.some.total, ==, 123456789);
+  g_assert_true (stat.has_full);
+  g_assert_cmpfloat_with_epsilon (stat.full.avg10, 0.25, 1e-9);
+  g_assert_cmpfloat_with_epsilon (stat.full.avg300, 12.0, 1e-9);
+  g_assert_cmpuint (stat.full.total, ==, 42);
+
+  /* The CPU of the system before Linux 5.13, and fields to come */
+  parse_pressure ("some avg10=0.00 avg60=0.00 avg300=0.00 total=7 peak=3\n", &stat);
+  g_assert_cmpuint (stat.some.total, ==, 7);
+  g_assert_false (stat.has_full);
+  g_assert_cmpuint (stat.full.total, ==, 0);
+
+  parse_pressure ("", &stat);
+  g_assert_cmpuint (stat.some.total, ==, 0);
+}
+
+
+static void
+test_pressure_stall (void)
+{
+  GsmPressureLine old = { .total = 1000 };
+  GsmPressureLine now = { .total = 251000 };
+
+  g_assert_cmpfloat_with_epsilon (gsm_pressure_stall (&old, &now, G_USEC_PER_SEC), 0.25, 1e-9);
+  /* Stalled the whole time, with the counter a bit ahead */
+  g_assert_cmpfloat (gsm_pressure_stall (&old, &now, 200000), ==, 1.0);
+  g_assert_cmpfloat (gsm_pressure_stall (&now, &old, G_USEC_PER_SEC), ==, 0.0);
+  g_assert_cmpfloat (gsm_pressure_stall (&old, &now, 0), ==, 0.0);
+}
+
+
+static void
+test_pressure_read (void)
+{
+  GsmPressureStat stats[GSM_PRESSURE_N_RESOURCES];
+  g_autoptr (GError) error = NULL;
+  g_autoptr (GsmPressure) pressure = gsm_pressure_new (NULL, &error);
+
+  if (pressure == NULL) {
+    g_test_skip (error->message);
+    return;
+  }
+
+  if (!gsm_pressure_read (pressure, stats, &error)) {
+    /* Built with CONFIG_PSI but booted without psi=1 */
+    g_assert_error (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED);
+    g_test_skip (error->message);
+    return;
+  }
+
+  g_assert_true (stats[GSM_PRESSURE_MEMORY].has_full);
+  g_assert_true (stats[GSM_PRESSURE_IO].has_full);
+}
+
+
+static void
+test_pressure_list_cgroups (void)
+{
+  g_autofree char *root = g_dir_make_tmp ("gsm-pressure-XXXXXX", NULL);
+  g_auto (GStrv) cgroups = NULL;
+  const char *const expected[] = {
+    "system.slice",
+    "user.slice",
+    "user.slice/user-1000.slice",
+    "user.slice/user-1000.slice/user@1000.service",
+    "user.slice/user-1000.slice/user@1000.service/app.slice",
+    NULL
+  };
+
+  make_sysfs_entry (root, "system.slice", "dbus.service");
+  make_sysfs_entry (root, "user.slice/user-1000.slice", "session-2.scope");
+  make_sysfs_entry (root, "user.slice/user-1000.slice/user@1000.service", "app.slice");
+  make_sysfs_entry (root, "init.scope", "");
+
+  cgroups = list_cgroups_below (root);
+  g_assert_cmpstrv (cgroups, expected);
+
+  remove_sysfs (root);
+}
+
+
+static void
+on_stall (G_GNUC_UNUSED GsmPressureResource resource, G_GNUC_UNUSED gpointer data)
+{
+}
+
+
+static void
+test_pressure_trigger (void)
+{
+  g_autoptr (GError) error = NULL;
+  g_autoptr (GsmPressureTrigger) trigger = NULL;
+
+  /* A 1 s window, taken as a 2 s one without privileges */
+  trigger = gsm_pressure_trigger_new (NULL, GSM_PRESSURE_MEMORY, 150000, G_USEC_PER_SEC,
+                                      on_stall, NULL, &error);
+
+  if (trigger == NULL) {
+    /* Not allowed before Linux 6.5, or without pressure information */
+    g_test_skip (error->message);
+    return;
+  }
+
+  g_assert_no_error (error);
+  g_assert_cmpuint (trigger->source, !=, 0);
+}
+
+
+static void
+test_procstat_parse (void)
+{
+  guint64 times[3 * GSM_CPU_N_STATES] = { 0 };
+
+  /* cpu1 is offline, cpu2 came after the graph started */
+  parse_stat ("cpu  10 1 5 100 4 1 2 7 3 0\n"
+              "cpu0 10 1 5 100 4 1 2 7 3 0\n"
+              "cpu2 20 2 10 200 8 2 4 14 6 0\n"
+              "intr 42 1 0 0\n"
+              "cpu3 1 1 1 1 1 1 1 1 0 0\n", 1, times);
+
+  g_assert_cmpuint (times[GSM_CPU_USER], ==, 10);
+  g_assert_cmpuint (times[GSM_CPU_NICE], ==, 1);
+  g_assert_cmpuint (times[GSM_CPU_SYSTEM], ==, 5);
+  g_assert_cmpuint (times[GSM_CPU_IDLE], ==, 100);
+  g_assert_cmpuint (times[GSM_CPU_IOWAIT], ==, 4);
+  g_assert_cmpuint (times[GSM_CPU_IRQ], ==, 1);
+  g_assert_cmpuint (times[GSM_CPU_SOFTIRQ], ==, 2);
+  g_assert_cmpuint (times[GSM_CPU_STEAL], ==, 7);
+  g_assert_cmpuint (times[GSM_CPU_N_STATES + GSM_CPU_STEAL], ==, 7);
+  g_assert_cmpuint (times[2 * GSM_CPU_N_STATES + GSM_CPU_USER], ==, 0);
+
+  /* Before steal, Linux 2.6.11 */
+  memset (times, 0, sizeof times);
+  parse_stat ("cpu  10 1 5 100 4 1 2\ncpu0 10 1 5 100 4 1 2\n", 1, times);
+  g_assert_cmpuint (times[GSM_CPU_SOFTIRQ], ==, 2);
+  g_assert_cmpuint (times[GSM_CPU_STEAL], ==, 0);
+  g_assert_cmpuint (times[GSM_CPU_N_STATES + GSM_CPU_SOFTIRQ], ==, 2);
+
+  g_assert_cmpint (parse_cpu_line ("cpufreq 1 2\n", times), ==, -1);
+  g_assert_cmpint (parse_cpu_line ("ctxt 1\n", times), ==, -1);
+}
+
+
+static void
+test_procstat_past_cpu_lines (void)
+{
+  static const char contents[] = "cpu  1 2\ncpu0 1 2\nintr 1";
+
+  g_assert_false (past_cpu_lines (contents, 10, 10));
+  /* "int" is not split from its newline by the reads */
+  g_assert_false (past_cpu_lines (contents, 20, 10));
+  g_assert_true (past_cpu_lines (contents, 22, 2));
+  g_assert_true (past_cpu_lines (contents, sizeof contents - 1, sizeof contents - 1));
+}
+
+
+static void
+test_procstat_shares (void)
+{
+  guint64 old[2 * GSM_CPU_N_STATES] = { 0 };
+  guint64 now[2 * GSM_CPU_N_STATES] = { 0 };
+  float shares[2 * GSM_CPU_N_STATES];
+
+  old[GSM_CPU_USER] = 100;
+  old[GSM_CPU_IOWAIT] = 50;
+  now[GSM_CPU_USER] = 150;
+  now[GSM_CPU_STEAL] = 25;
+  now[GSM_CPU_IDLE] = 25;
+  /* Gone back */
+  now[GSM_CPU_IOWAIT] = 40;
+  /* The second row was offline */
+  now[GSM_CPU_N_STATES + GSM_CPU_USER] = 3000000000;
+  now[GSM_CPU_N_STATES + GSM_CPU_IDLE] = 100;
+
+  gsm_cpu_times_shares (old, now, 2, shares);
+
+  g_assert_cmpfloat_with_epsilon (shares[GSM_CPU_USER], 0.5, 1e-6);
+  g_assert_cmpfloat_with_epsilon (shares[GSM_CPU_STEAL], 0.25, 1e-6);
+  g_assert_cmpfloat_with_epsilon (shares[GSM_CPU_IDLE], 0.25, 1e-6);
+  g_assert_cmpfloat (shares[GSM_CPU_IOWAIT], ==, 0.0);
+  for (guint state = 0; state < GSM_CPU_N_STATES; state++) {
+    g_assert_cmpfloat (shares[GSM_CPU_N_STATES + state], ==, 0.0);
+  }
+
+  /* Nor did it change after */
+  gsm_cpu_times_shares (now, now, 2, shares);
+  for (guint state = 0; state < GSM_CPU_N_STATES; state++) {
+    g_assert_cmpfloat (shares[GSM_CPU_N_STATES + state], ==, 0.0);
+  }
+}
+
+
+static void
+test_procstat_read (void)
+{
+  g_autoptr (GError) error = NULL;
+  g_autoptr (GsmProcStat) stat = gsm_proc_stat_new ();
+  g_autoptr (GArray) times = g_array_new (FALSE, FALSE, sizeof (guint64));
+  const guint64 *row;
+
+  if (!gsm_proc_stat_read (stat, 1, times, &error)) {
+    g_test_skip (error->message);
+    return;
+  }
+
+  g_assert_cmpuint (times->len, ==, 2 * GSM_CPU_N_STATES);
+  row = &g_array_index (times, guint64, 0);
+  g_assert_cmpuint (row[GSM_CPU_IDLE] + row[GSM_CPU_USER] + row[GSM_CPU_SYSTEM], >, 0);
+
+  /* Again, from the kept file */
+  g_assert_true (gsm_proc_stat_read (stat, 1, times, &error));
+  g_assert_no_error (error);
+}
+
+
+int
+main (int argc, char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/gnome-system-monitor/diskstats/parse", test_diskstats_parse);
+  g_test_add_func ("/gnome-system-monitor/diskstats/classify", test_diskstats_classify);
+  g_test_add_func ("/gnome-system-monitor/diskstats/rates", test_diskstats_rates);
+  g_test_add_func ("/gnome-system-monitor/diskstats/read", test_diskstats_read);
+  g_test_add_func ("/gnome-system-monitor/netlink/parse-links", test_netlink_parse_links);
+  g_test_add_func ("/gnome-system-monitor/netlink/parse-error", test_netlink_parse_error);
+  g_test_add_func ("/gnome-system-monitor/netlink/get-links", test_netlink_get_links);
+  g_test_add_func ("/gnome-system-monitor/pressure/parse", test_pressure_parse);
+  g_test_add_func ("/gnome-system-monitor/pressure/stall", test_pressure_stall);
+  g_test_add_func ("/gnome-system-monitor/pressure/read", test_pressure_read);
+  g_test_add_func ("/gnome-system-monitor/pressure/list-cgroups", test_pressure_list_cgroups);
+  g_test_add_func ("/gnome-system-monitor/pressure/trigger", test_pressure_trigger);
+  g_test_add_func ("/gnome-system-monitor/procstat/parse", test_procstat_parse);
+  g_test_add_func ("/gnome-system-monitor/procstat/past-cpu-lines", test_procstat_past_cpu_lines);
+  g_test_add_func ("/gnome-system-monitor/procstat/shares", test_procstat_shares);
+  g_test_add_func ("/gnome-system-monitor/procstat/read", test_procstat_read);
+
+  return g_test_run ();
+}
@@ -1,7 +1,10 @@
 #include <config.h>
 
+#include <errno.h>
 #include <math.h>
 
+#include <numeric>
+
 #include <glib/gi18n.h>
 
 #include <glibtop.h>
@@ -13,6 +16,7 @@
 #include <glibtop/netlist.h>
 
 #include "application.h"
+#include "gsm-sampler.h"
 #include "load-graph.h"
 #include "util.h"
 #include "legacy/gsm_color_button.h"
@@ -21,11 +25,17 @@ constexpr double BORDER_ALPHA = 0.7;
 constexpr double GRID_ALPHA = BORDER_ALPHA / 2.0;
 constexpr int FRAME_WIDTH = 4;
 constexpr unsigned GRAPH_MIN_HEIGHT = 40;
+/* Past this many CPUs, only their mean is archived */
+constexpr guint ARCHIVE_MAX_CPUS = 8;
+/* An hour at the default update interval */
+constexpr guint HISTORY_RECORDS = 3600;
 
 void
 LoadGraph::clear_background ()
 {
   gsm_graph_clear_background (GSM_GRAPH (disp));
+  g_clear_pointer (&lines, cairo_surface_destroy);
+  g_clear_pointer (&zoomed, cairo_surface_destroy);
 }
 
 bool
@@ -45,7 +55,9 @@ LoadGraph::get_caption (guint index)
   char *caption;
   guint64 max_value;
 
-  if (this->type == LOAD_GRAPH_NET)
+  if ((this->type == LOAD_GRAPH_NET || this->type == LOAD_GRAPH_DISK) && this->zoom)
+    max_value = this->zoom_max;
+  else if (this->type == LOAD_GRAPH_NET)
     max_value = this->net.max;
   else if (this->type == LOAD_GRAPH_DISK)
     max_value = this->disk.max;
@@ -167,7 +179,10 @@ create_background (LoadGraph *graph,
   guint indent = gsm_graph_get_indent (graph->disp);
 
   /* Graph length */
-  const unsigned total_seconds = graph->speed * (graph->num_points - 2) / 1000;
+  unsigned total_seconds = graph->speed * (graph->num_points - 2) / 1000;
+
+  if (graph->zoom)
+    total_seconds = graph->archive.tier (graph->zoom - 1).seconds * graph->archive.tier (graph->zoom - 1).buckets;
   guint scale = gtk_widget_get_scale_factor (GTK_WIDGET (graph->disp));
 
   surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32,
@@ -334,620 +349,2301 @@ create_background (LoadGraph *graph,
   return surface;
 }
 
+/*
+  The lines are drawn once in graph->lines, a ring as wide as the whole
+  history, where a point always stays at the same x: the column between
+  the points index - 1 and index starts at lines_column_x (index).  Each
+  frame copies the ring twice, shifted so that the latest point lands on
+  the right, and only draws the columns of the points added since the
+  previous frame.  Everything is drawn again when the background is
+  cleared: on resize, theme, color, scale or style changes.
+
+  With less than a pixel per point, the points are summed up in buckets
+  of about a pixel, drawn as their min/max range, so that the cost of a
+  full repaint follows the width of the graph rather than the number of
+  points.  The buckets are updated as the points come in and a column
+  is then a bucket.
+*/
+constexpr double LINES_PAD = 2.0;
+
+static double
+lines_column_x (const LoadGraph *graph,
+                guint64          index)
+{
+  return LINES_PAD + ((index - 1) % graph->lines_points) * graph->lines_step;
+}
+
+static double
+lines_y (const LoadGraph *graph,
+         double           value)
+{
+  return FRAME_WIDTH + (1.0 - value) * graph->real_draw_height;
+}
+
 static void
-load_graph_draw (GtkDrawingArea* area,
-                 cairo_t *cr,
-                 int      width,
-                 int      height,
-                 gpointer data_ptr)
+draw_lines_column (LoadGraph *graph,
+                   cairo_t   *cr,
+                   guint64    index,
+                   bool       smooth,
+                   bool       stacked)
 {
-  LoadGraph * const graph = static_cast<LoadGraph*>(data_ptr);
-  cairo_surface_t * background;
-  guint frames_per_unit;
-  guint render_counter = gsm_graph_get_render_counter (GSM_GRAPH (area));
-  double rmargin = gsm_graph_get_right_margin (GSM_GRAPH (area));
-  guint num_points = gsm_graph_get_num_points (GSM_GRAPH (area));
-  guint indent = gsm_graph_get_indent (GSM_GRAPH (area));
-  graph->num_bars = gsm_graph_get_num_bars (GSM_GRAPH (area), height);
+  const guint64 latest = graph->data.latest_index ();
+  const double step = graph->lines_step;
+  const double x = lines_column_x (graph, index);
+  const double bottom = lines_y (graph, 0.0);
 
-  /* Initialize graph dimensions */
-  width -= 2 * FRAME_WIDTH;
-  height -= 2 * FRAME_WIDTH;
+  cairo_save (cr);
 
-  frames_per_unit = width / (num_points - 2);
-  if (frames_per_unit > 10) frames_per_unit = 10;
-  gsm_graph_set_frames_per_unit(GSM_GRAPH (area), frames_per_unit);
+  cairo_rectangle (cr, x, 0, step, graph->lines_height);
+  cairo_clip (cr);
 
-  graph->graph_dely = (height - 15) / graph->num_bars;   /* round to int to avoid AA blur */
-  graph->real_draw_height = graph->graph_dely * graph->num_bars;
+  cairo_set_operator (cr, CAIRO_OPERATOR_CLEAR);
+  cairo_paint (cr);
+  cairo_set_operator (cr, CAIRO_OPERATOR_OVER);
 
-  /* Number of pixels wide for one sample point */
-  const double x_step = double(width - rmargin - graph->indent) / (graph->num_points - 2);
+  for (gint j = graph->n - 1; j >= 0; j--)
+    {
+      /* Set the color of the currently drawn graph */
+      gdk_cairo_set_source_rgba (cr, &(graph->colors [j]));
 
-  /* Lines start at the right edge of the drawing,
-   * a bit outside the clip rectangle. */
-  /* Adjustment for smooth movement between samples */
-  double x_offset = width - rmargin + FRAME_WIDTH;
+      /* The segment ending at the column start overlaps it a bit */
+      for (guint64 end = MAX (index, 2) - 1; end <= index; end++)
+        {
+          const guint64 age = latest - end;
 
-  /* Shift the x position of the most recent (shown rightmost) value outside of the clip area in order
-     to be able to simulate continuous, smooth movement without the line being cut off at its ends */
-  x_offset += x_step * (1 - render_counter / double(frames_per_unit));
+          if (age + 1 >= graph->data.size ())
+            continue;
 
-  /* Draw background */
-  if (!gsm_graph_is_background_set (GSM_GRAPH (graph->disp))) {
-    background = create_background (graph, width, height);
-    gsm_graph_set_background (GSM_GRAPH (graph->disp), background);
-  } else {
-    background = gsm_graph_get_background (GSM_GRAPH (graph->disp));
-  }
+          const double from = graph->data.at (j, age + 1);
+          const double to = graph->data.at (j, age);
 
-  cairo_set_source_surface (cr, background, 0, 0);
-  cairo_paint (cr);
+          if (from == -1.0f || to == -1.0f)
+            continue;
 
-  /* Set the drawing style */
-  cairo_set_line_width (cr, 1);
-  cairo_set_line_cap (cr, CAIRO_LINE_CAP_ROUND);
-  cairo_set_line_join (cr, CAIRO_LINE_JOIN_ROUND);
+          const double x_from = x - (index - end) * step;
+          const double x_to = x_from + step;
 
-  /* Clip the drawing area to the inside of the drawn background */
-  cairo_rectangle (cr,
-                   indent + FRAME_WIDTH,
-                   FRAME_WIDTH,
-                   width - rmargin - indent,
-                   graph->real_draw_height);
-  cairo_clip (cr);
+          cairo_move_to (cr, x_from, lines_y (graph, from));
 
-  bool drawStacked = graph->type == LOAD_GRAPH_CPU && GsmApplication::get ().config.draw_stacked;
-  bool drawSmooth = GsmApplication::get ().config.draw_smooth;
-  gsm_graph_set_smooth_chart (GSM_GRAPH (area), drawSmooth);
-  gsm_graph_set_stacked_chart (GSM_GRAPH (area), drawStacked);
-  
+          if (smooth)
+            cairo_curve_to (cr,
+                            x_from + 0.5 * step, lines_y (graph, from),
+                            x_from + 0.5 * step, lines_y (graph, to),
+                            x_to, lines_y (graph, to));
+          else
+            cairo_line_to (cr, x_to, lines_y (graph, to));
+
+          if (stacked)
+            {
+              /* Close the area under the segment */
+              cairo_line_to (cr, x_to, bottom);
+              cairo_line_to (cr, x_from, bottom);
+              cairo_close_path (cr);
+              cairo_fill (cr);
+            }
+          else
+            {
+              cairo_stroke (cr);
+            }
+        }
+    }
+
+  cairo_restore (cr);
+}
 
-  const double y_base = FRAME_WIDTH;
+static void
+draw_bucket_column (LoadGraph *graph,
+                    cairo_t   *cr,
+                    guint64    bucket,
+                    bool       stacked)
+{
+  const guint per_bucket = graph->buckets.points_per_bucket ();
+  const double width = per_bucket * graph->lines_step;
+  const double x = lines_column_x (graph, bucket * per_bucket + 1);
+  const double center = x + 0.5 * width;
+  const double bottom = lines_y (graph, 0.0);
+
+  cairo_save (cr);
+
+  cairo_rectangle (cr, x, 0, width, graph->lines_height);
+  cairo_clip (cr);
+
+  cairo_set_operator (cr, CAIRO_OPERATOR_CLEAR);
+  cairo_paint (cr);
+  cairo_set_operator (cr, CAIRO_OPERATOR_OVER);
 
-  /* Draw every graph */
   for (gint j = graph->n - 1; j >= 0; j--)
     {
-      /* Set the color of the currently drawn graph */
-      gdk_cairo_set_source_rgba (cr, &(graph->colors [j]));
+      const GraphBuckets::Bucket &b = graph->buckets.get (j, bucket);
 
-      /* Start drawing on the right at the correct height */
-      cairo_move_to (cr, x_offset, y_base + (1.0f - graph->data[0][j]) * graph->real_draw_height);
+      if (b.first == -1.0)
+        continue;
 
-      /* Draw the path of the line
-         Loop starts at 1 because the curve accesses the 0th data point */
-      for (guint i = 1; i < num_points; i++)
-        {
-          if (graph->data[i][j] == -1.0f)
-            continue;
+      /* Start where the previous bucket ended */
+      double start = b.first;
 
-          if (drawSmooth)
-            cairo_curve_to (cr,
-                            x_offset - ((i - 0.5f) * x_step),
-                            y_base + (1.0 - graph->data[i - 1][j]) * graph->real_draw_height,
-                            x_offset - ((i - 0.5f) * x_step),
-                            y_base + (1.0 - graph->data[i][j]) * graph->real_draw_height,
-                            x_offset - (i * x_step),
-                            y_base + (1.0 - graph->data[i][j]) * graph->real_draw_height);
-          else
-            cairo_line_to (cr,
-                           x_offset - (i * x_step),
-                           y_base + (1.0 - graph->data[i][j]) * graph->real_draw_height);
-        }
+      if (bucket > 0 && graph->buckets.get (j, bucket - 1).last != -1.0)
+        start = graph->buckets.get (j, bucket - 1).last;
 
-      if (drawStacked)
-        {
-          /* Draw the remaining outline of the area */
-          /* Left bottom corner */
-          cairo_rel_line_to (cr, 0, y_base + graph->real_draw_height);
-          /* Right bottom corner.
-             It's drawn far outside the visible area to avoid a weird bug
-             where it's not filling the area it should completely */
-          cairo_rel_line_to (cr, x_offset * 2, 0);
+      gdk_cairo_set_source_rgba (cr, &(graph->colors [j]));
 
+      if (stacked)
+        {
+          cairo_move_to (cr, x, lines_y (graph, start));
+          cairo_line_to (cr, center, lines_y (graph, b.max));
+          cairo_line_to (cr, x + width, lines_y (graph, b.last));
+          cairo_line_to (cr, x + width, bottom);
+          cairo_line_to (cr, x, bottom);
           cairo_close_path (cr);
           cairo_fill (cr);
         }
       else
         {
+          cairo_move_to (cr, x, lines_y (graph, start));
+          cairo_line_to (cr, center, lines_y (graph, b.first));
+          cairo_move_to (cr, center, lines_y (graph, b.min));
+          cairo_line_to (cr, center, lines_y (graph, b.max));
+          cairo_move_to (cr, center, lines_y (graph, b.last));
+          cairo_line_to (cr, x + width, lines_y (graph, b.last));
           cairo_stroke (cr);
         }
     }
-}
 
-void
-load_graph_reset (LoadGraph *graph)
-{
-  graph->iteration = 0;
-  std::fill (graph->data_block.begin (), graph->data_block.end (), -1.0);
+  cairo_restore (cr);
 }
 
 static void
-get_load (LoadGraph *graph)
+update_lines (LoadGraph *graph,
+              double     x_step,
+              int        height,
+              bool       smooth,
+              bool       stacked)
 {
-  guint i;
-  glibtop_cpu cpu;
+  const guint64 latest = graph->data.latest_index ();
+  guint64 first = graph->lines_latest + 1;
+  /* Points per bucket, for about a bucket per pixel */
+  const guint per_bucket = x_step < 1.0 ? MAX (1U, guint (1.0 / x_step)) : 1;
+
+  if (!graph->lines
+      || graph->lines_step != x_step
+      || graph->lines_height != height
+      || latest - graph->lines_latest >= graph->num_points)
+    {
+      const guint scale = gtk_widget_get_scale_factor (GTK_WIDGET (graph->disp));
 
-  glibtop_get_cpu (&cpu);
+      /* A whole number of buckets */
+      graph->lines_points = (graph->num_points + per_bucket - 1) / per_bucket * per_bucket;
 
-  auto NOW = [&]() -> guint64 (&)[GLIBTOP_NCPU][N_CPU_STATES] {
-               return graph->cpu.times[graph->cpu.now];
-             };
-  auto LAST = [&]() -> guint64 (&)[GLIBTOP_NCPU][N_CPU_STATES] {
-                return graph->cpu.times[graph->cpu.now ^ 1];
-              };
+      const int width = ceil (2 * LINES_PAD + graph->lines_points * x_step);
 
-  if (graph->n == 1)
-    {
-      NOW ()[0][CPU_TOTAL] = cpu.total;
-      NOW ()[0][CPU_USED] = cpu.user + cpu.nice + cpu.sys;
-    }
-  else
-    {
-      for (i = 0; i < graph->n; i++)
+      if (graph->lines)
+        cairo_surface_destroy (graph->lines);
+
+      graph->lines = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, width * scale, height * scale);
+      cairo_surface_set_device_scale (graph->lines, scale, scale);
+      graph->lines_step = x_step;
+      graph->lines_height = height;
+      graph->n_repaints++;
+
+      /* Every point having a previous one */
+      first = latest > graph->data.size () - 2 ? latest - (graph->data.size () - 2) : 1;
+
+      if (per_bucket > 1)
         {
-          NOW ()[i][CPU_TOTAL] = cpu.xcpu_total[i];
-          NOW ()[i][CPU_USED] = cpu.xcpu_user[i] + cpu.xcpu_nice[i]
-                                + cpu.xcpu_sys[i];
+          graph->buckets = GraphBuckets (graph->n, graph->lines_points / per_bucket + 1, per_bucket);
+          first = latest >= graph->data.size () ? latest - (graph->data.size () - 1) : 1;
         }
     }
 
-  // on the first call, LAST is 0
-  // which means data is set to the average load since boot
-  // that value has no meaning, we just want all the
-  // graphs to be aligned, so the CPU graph needs to start
-  // immediately
-  bool drawStacked = graph->type == LOAD_GRAPH_CPU && GsmApplication::get ().config.draw_stacked;
+  if (first > latest)
+    return;
 
-  if(graph->iteration != 1) {
-    for (i = 0; i < graph->n; i++)
-      {
-        float load;
-        float total, used;
-        gchar *text;
+  cairo_t *cr = cairo_create (graph->lines);
 
-        total = NOW ()[i][CPU_TOTAL] - LAST ()[i][CPU_TOTAL];
-        used = NOW ()[i][CPU_USED] - LAST ()[i][CPU_USED];
+  /* Set the drawing style */
+  cairo_set_line_width (cr, 1);
+  cairo_set_line_cap (cr, CAIRO_LINE_CAP_ROUND);
+  cairo_set_line_join (cr, CAIRO_LINE_JOIN_ROUND);
 
-        load = used / MAX (total, 1.0f);
+  if (per_bucket > 1)
+    {
+      for (guint64 index = first; index <= latest; index++)
+        graph->buckets.add (graph->data, index);
 
-        graph->data[0][i] = load;
-        if (drawStacked)
-          {
-            graph->data[0][i] /= graph->n;
-            if (i > 0)
-              graph->data[0][i] += graph->data[0][i - 1];
-          }
+      for (guint64 bucket = graph->buckets.bucket_of (first); bucket <= graph->buckets.bucket_of (latest); bucket++)
+        draw_bucket_column (graph, cr, bucket, stacked);
+    }
+  else
+    {
+      for (guint64 index = first; index <= latest; index++)
+        draw_lines_column (graph, cr, index, smooth, stacked);
+    }
 
-        /* Update label */
-        // Translators: CPU usage percentage label: 95.7%
-        text = g_strdup_printf (_("%.1f%%"), load * 100.0f);
-        gtk_label_set_text (GTK_LABEL (graph->labels.cpu[i]), text);
-        g_free (text);
-      }
-  }
+  cairo_destroy (cr);
 
-  graph->cpu.now ^= 1;
+  graph->lines_latest = latest;
 }
 
 static void
-set_memory_label_and_picker (GtkLabel       *label,
-                             GsmColorButton *picker,
-                             guint64         used,
-                             guint64         cached,
-                             guint64         total,
-                             double          percent)
+draw_lines (LoadGraph *graph,
+            cairo_t   *cr,
+            double     x_offset,
+            double     x_step,
+            int        height,
+            bool       smooth,
+            bool       stacked)
 {
-  char *used_text;
-  char *cached_text;
-  char *cached_label;
-  char *total_text;
-  char *text;
-  char *tmp_text;
+  /* Draw the new points, or every point */
+  update_lines (graph, x_step, height, smooth, stacked);
+
+  const guint64 latest = graph->data.latest_index ();
+
+  if (latest == 0)
+    return;
 
-  used_text = format_byte_size (used, GsmApplication::get ().config.resources_memory_in_iec);
-  cached_text = format_byte_size (cached, GsmApplication::get ().config.resources_memory_in_iec);
-  total_text = format_byte_size (total, GsmApplication::get ().config.resources_memory_in_iec);
-  if (total == 0)
+  /* Where the latest point is in the ring */
+  const double latest_x = lines_column_x (graph, latest) + x_step;
+  const double ring = graph->lines_points * x_step;
+
+  /* The ring from its start to the latest point, then the older
+     points wrapped around at its end */
+  for (int copy = 0; copy < 2; copy++)
     {
-      text = g_strdup (_("not available"));
+      const double dx = x_offset - latest_x - copy * ring;
+
+      cairo_save (cr);
+      cairo_rectangle (cr, LINES_PAD + dx, 0, ring, graph->lines_height);
+      cairo_clip (cr);
+      cairo_set_source_surface (cr, graph->lines, dx, 0);
+      cairo_paint (cr);
+      cairo_restore (cr);
     }
-  else
-    {
-      // xgettext: "540MiB (53 %) of 1.0 GiB" or "540MB (53 %) of 1.0 GB"
-      text = g_strdup_printf (_("%s (%.1f%%) of %s"), used_text, 100.0 * percent, total_text);
+}
+
+/*
+  The CPU heatmap is an image with a row per CPU and a column per point,
+  scaled by cairo to the graph.  It is a ring like graph->lines: the
+  column of a point stays the same and only the columns of the points
+  added since the previous frame are written, a pixel per CPU, so that
+  a frame stays cheap with a thousand CPUs.
+*/
+static guint32
+heat_pixel (double load)
+{
+  static guint32 pixels[256];
+  static bool filled = false;
 
-      if (cached != 0)
+  if (load < 0.0)
+    return 0;
+
+  if (G_UNLIKELY (!filled))
+    {
+      for (guint i = 0; i < G_N_ELEMENTS (pixels); i++)
         {
-          // xgettext: Used cache string, e.g.: "Cache 2.4GiB" or "Cache 2.4GB"
-          cached_label = g_strdup_printf (_("Cache %s"), cached_text);
-          tmp_text = g_strdup_printf ("%s\n%s", text, cached_label);
-          g_free (cached_label);
-          g_free (text);
-          text = tmp_text;
+          GdkRGBA color;
+
+          gsm_cpu_legend_heat_color (i / 255.0f, &color);
+
+          /* Premultiplied ARGB32 */
+          const guint32 a = lrint (255 * color.alpha);
+
+          pixels[i] = a << 24
+                      | guint32 (lrint (a * color.red)) << 16
+                      | guint32 (lrint (a * color.green)) << 8
+                      | guint32 (lrint (a * color.blue));
         }
+      filled = true;
     }
 
-  gtk_label_set_text (label, text);
-  g_free (used_text);
-  g_free (cached_text);
-  g_free (total_text);
-  g_free (text);
-
-  if (picker)
-    gsm_color_button_set_fraction (picker, percent);
+  return pixels[lrint (MIN (load, 1.0) * 255)];
 }
 
 static void
-get_memory (LoadGraph *graph)
+update_heatmap (LoadGraph *graph)
 {
-  float mempercent, swappercent;
+  const guint64 latest = graph->data.latest_index ();
+  const guint points = graph->data.size ();
+  guint64 first = graph->heatmap_latest + 1;
 
-  glibtop_mem mem;
-  glibtop_swap swap;
+  if (!graph->heatmap
+      || guint (cairo_image_surface_get_width (graph->heatmap)) != points
+      || latest - graph->heatmap_latest >= points)
+    {
+      if (graph->heatmap)
+        cairo_surface_destroy (graph->heatmap);
 
-  glibtop_get_mem (&mem);
-  glibtop_get_swap (&swap);
+      graph->heatmap = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, points, graph->n);
+      graph->n_repaints++;
+      first = latest >= points ? latest - (points - 1) : 1;
+    }
 
-  /* There's no swap on LiveCD : 0.0f is better than NaN :) */
-  swappercent = (swap.total ? (float)swap.used / (float)swap.total : 0.0f);
-  mempercent = (float)mem.user / (float)mem.total;
-  set_memory_label_and_picker (GTK_LABEL (graph->labels.memory),
-                               GSM_COLOR_BUTTON (graph->mem_color_picker),
-                               mem.user, mem.cached, mem.total, mempercent);
+  if (first > latest)
+    return;
 
-  set_memory_label_and_picker (GTK_LABEL (graph->labels.swap),
-                               GSM_COLOR_BUTTON (graph->swap_color_picker),
-                               swap.used, 0, swap.total, swappercent);
+  cairo_surface_flush (graph->heatmap);
 
-  gtk_widget_set_sensitive (GTK_WIDGET (graph->swap_color_picker), swap.total > 0);
+  guint32 *pixels = reinterpret_cast<guint32 *>(cairo_image_surface_get_data (graph->heatmap));
+  const int stride = cairo_image_surface_get_stride (graph->heatmap) / sizeof *pixels;
 
-  if(graph->iteration != 1) {
-    graph->data[0][0] = graph->translate_to_log_partial_if_needed (mempercent);
-    graph->data[0][1] = swap.total > 0 ? graph->translate_to_log_partial_if_needed (swappercent) : -1.0;
-  }
+  for (guint64 index = first; index <= latest; index++)
+    {
+      const guint x = (index - 1) % points;
+      const guint age = latest - index;
+
+      for (guint j = 0; j < graph->n; j++)
+        pixels[j * stride + x] = heat_pixel (graph->data.at (j, age));
+    }
+
+  cairo_surface_mark_dirty (graph->heatmap);
+
+  graph->heatmap_latest = latest;
 }
 
-/* Nice Numbers for Graph Labels after Paul Heckbert
-   nicenum: find a "nice" number approximately equal to x.
-   Round the number if round=1, take ceiling if round=0    */
+static void
+draw_heatmap (LoadGraph *graph,
+              cairo_t   *cr,
+              double     x_offset,
+              double     x_step)
+{
+  update_heatmap (graph);
+
+  const guint64 latest = graph->data.latest_index ();
+
+  if (latest == 0)
+    return;
 
+  const guint points = graph->data.size ();
+  const double latest_x = ((latest - 1) % points + 1) * x_step;
+  const double row_height = double (graph->real_draw_height) / graph->n;
+
+  for (int copy = 0; copy < 2; copy++)
+    {
+      cairo_save (cr);
+      cairo_translate (cr, x_offset - latest_x - copy * points * x_step, FRAME_WIDTH);
+      cairo_scale (cr, x_step, row_height);
+      cairo_set_source_surface (cr, graph->heatmap, 0, 0);
+      /* Sharp cells, unless there are more CPUs or points than pixels,
+         then the cells sharing a pixel are averaged rather than skipped */
+      cairo_pattern_set_filter (cairo_get_source (cr),
+                                row_height < 1.0 || x_step < 1.0 ? CAIRO_FILTER_GOOD : CAIRO_FILTER_NEAREST);
+      cairo_rectangle (cr, 0, 0, points, graph->n);
+      cairo_fill (cr);
+      cairo_restore (cr);
+    }
+}
+
+/*
+  Zoomed out, the graph shows a tier of graph->archive rather than the
+  points: every series as the line of its mean over the band between its
+  min and its max, merging the buckets that would share a pixel.  The
+  drawing is kept until the tier starts a new bucket, every second at
+  most.  Rates are scaled to the largest one of the tier.
+*/
 static double
 nicenum (double x,
-         int    round)
+         int    round);
+
+static double
+zoomed_value (LoadGraph *graph,
+              float      value)
 {
-  int expv;                  /* exponent of x */
-  double f;                  /* fractional part of x */
-  double nf;                  /* nice, rounded fraction */
+  if (graph->type == LOAD_GRAPH_NET || graph->type == LOAD_GRAPH_DISK)
+    return value / graph->zoom_max;
 
-  expv = floor (log10 (x));
-  f = x / pow (10.0, expv);       /* between 1 and 10 */
-  if (round)
-    {
-      if (f < 1.5)
-        nf = 1.0;
-      else if (f < 3.0)
-        nf = 2.0;
-      else if (f < 7.0)
-        nf = 5.0;
-      else
-        nf = 10.0;
-    }
-  else
-    {
-      if (f <= 1.0)
-        nf = 1.0;
-      else if (f <= 2.0)
-        nf = 2.0;
-      else if (f <= 5.0)
-        nf = 5.0;
-      else
-        nf = 10.0;
-    }
-  return nf * pow (10.0, expv);
+  return graph->translate_to_log_partial_if_needed (value);
 }
 
 static void
-dynamic_scale (LoadGraph             *graph,
-               std::vector<unsigned> *values,
-               guint64               *max,
-               guint64                din,
-               guint64                dout,
-               gboolean               in_bits)
+update_zoom_max (LoadGraph *graph)
 {
-  graph->data[0][0] = 1.0f * din / *max;
-  graph->data[0][1] = 1.0f * dout / *max;
+  const guint t = graph->zoom - 1;
 
-  guint64 dmax = std::max (din, dout);
+  if (graph->type != LOAD_GRAPH_NET && graph->type != LOAD_GRAPH_DISK)
+    return;
 
-  if (graph->latest == 0)
-    values->at (graph->num_points - 1) = dmax;
-  else
-    values->at (graph->latest - 1) = dmax;
+  if (graph->zoomed && graph->zoomed_bucket == graph->archive.latest_bucket (t))
+    return;
 
-  guint64 new_max;
-  // both way, new_max is the greatest value
-  if (dmax >= *max)
-    new_max = dmax;
-  else
-    new_max = *std::max_element (&values->at (0),
-                                 &values->at (graph->num_points - 1));
+  float max = 0.0f;
 
-  //
-  // Round maximum
-  //
+  for (guint j = 0; j < graph->archive.series (); j++)
+    for (guint age = 0; age < graph->archive.tier (t).buckets; age++)
+      if (graph->archive.get (t, j, age).count)
+        max = MAX (max, graph->archive.get (t, j, age).max);
 
-  const guint64 bak_max (new_max);
+  /* Round ticks, like the points would get */
+  const guint ticks = MAX (graph->num_bars, 1U);
+  const double zoom_max = ticks * nicenum (MAX (1.1 * max, 1024.0) / ticks, 0);
 
-  if (in_bits)
+  if (zoom_max != graph->zoom_max)
+    {
+      graph->zoom_max = zoom_max;
+      graph->clear_background ();
+    }
+}
+
+static void
+draw_zoomed (LoadGraph *graph,
+             cairo_t   *cr,
+             double     left,
+             double     plot_width)
+{
+  const guint t = graph->zoom - 1;
+  const GraphArchiveTier &tier = graph->archive.tier (t);
+  const gint64 bucket = graph->archive.latest_bucket (t);
+
+  if (!graph->zoomed || graph->zoomed_bucket != bucket)
+    {
+      const guint scale = gtk_widget_get_scale_factor (GTK_WIDGET (graph->disp));
+      const guint per_column = MAX (1U, guint (ceil (tier.buckets / MAX (plot_width, 1.0))));
+      const guint columns = tier.buckets / per_column;
+      const double column_width = plot_width * per_column / tier.buckets;
+      const double right = left + plot_width;
+      std::vector<GraphArchive::Bucket> merged (columns);
+
+      if (graph->zoomed)
+        cairo_surface_destroy (graph->zoomed);
+
+      graph->zoomed = cairo_image_surface_create (CAIRO_FORMAT_ARGB32,
+                                                  gtk_widget_get_width (GTK_WIDGET (graph->disp)) * scale,
+                                                  gtk_widget_get_height (GTK_WIDGET (graph->disp)) * scale);
+      cairo_surface_set_device_scale (graph->zoomed, scale, scale);
+      graph->zoomed_bucket = bucket;
+      graph->n_repaints++;
+
+      cairo_t *zcr = cairo_create (graph->zoomed);
+
+      cairo_set_line_width (zcr, 1);
+      cairo_set_line_join (zcr, CAIRO_LINE_JOIN_ROUND);
+
+      for (gint j = graph->archive.series () - 1; j >= 0; j--)
+        {
+          GdkRGBA band = graph->colors[j];
+
+          /* Column 0 is the latest one, on the right */
+          for (guint c = 0; c < columns; c++)
+            {
+              GraphArchive::Bucket &m = merged[c];
+
+              m = { 0.0f, 0.0f, 0.0f, 0 };
+              for (guint age = c * per_column; age < (c + 1) * per_column; age++)
+                {
+                  const GraphArchive::Bucket &b = graph->archive.get (t, j, age);
+
+                  if (!b.count)
+                    continue;
+
+                  m.min = m.count ? MIN (m.min, b.min) : b.min;
+                  m.max = m.count ? MAX (m.max, b.max) : b.max;
+                  m.sum += b.sum;
+                  m.count += b.count;
+                }
+            }
+
+          band.alpha *= 0.3;
+          gdk_cairo_set_source_rgba (zcr, &band);
+          for (guint c = 0; c < columns; c++)
+            if (merged[c].count)
+              {
+                const double top = lines_y (graph, zoomed_value (graph, merged[c].max));
+                const double bottom = lines_y (graph, zoomed_value (graph, merged[c].min));
+
+                cairo_rectangle (zcr, right - (c + 1) * column_width, top, column_width, MAX (bottom - top, 1.0));
+              }
+          cairo_fill (zcr);
+
+          gdk_cairo_set_source_rgba (zcr, &graph->colors[j]);
+          for (guint c = 0; c < columns; c++)
+            {
+              const double x = right - (c + 0.5) * column_width;
+
+              if (!merged[c].count)
+                continue;
+
+              /* Gaps without values break the line */
+              if (c > 0 && merged[c - 1].count)
+                cairo_line_to (zcr, x, lines_y (graph, zoomed_value (graph, merged[c].mean ())));
+              else
+                cairo_move_to (zcr, x, lines_y (graph, zoomed_value (graph, merged[c].mean ())));
+            }
+          cairo_stroke (zcr);
+        }
+
+      cairo_destroy (zcr);
+    }
+
+  cairo_set_source_surface (cr, graph->zoomed, 0, 0);
+  cairo_paint (cr);
+}
+
+#ifdef __linux__
+/*
+  The stalls reported by the pressure triggers, as dashed lines in the
+  colors of their resources at the points sampled after them.  Markers
+  out of the points are dropped, see load_graph_add_marker () too.
+*/
+static void
+draw_markers (LoadGraph *graph,
+              cairo_t   *cr,
+              double     x_offset,
+              double     x_step)
+{
+  const guint64 latest = graph->data.latest_index ();
+  const ProcConfig &config = GsmApplication::get ().config;
+  const GdkRGBA *colors[] = { &config.pressure_cpu_color, &config.pressure_memory_color, &config.pressure_io_color };
+  const double dash = 3.0;
+
+  while (!graph->markers.empty () && graph->markers.front ().index + graph->num_points <= latest)
+    graph->markers.pop_front ();
+
+  if (graph->markers.empty ())
+    return;
+
+  cairo_save (cr);
+  cairo_set_line_width (cr, 1.0);
+  cairo_set_dash (cr, &dash, 1, 0.0);
+
+  for (const auto &marker : graph->markers)
+    {
+      /* Not sampled yet */
+      if (marker.index > latest)
+        break;
+
+      const double x = std::floor (x_offset - (latest - marker.index) * x_step) + 0.5;
+
+      gdk_cairo_set_source_rgba (cr, colors[marker.resource]);
+      cairo_move_to (cr, x, FRAME_WIDTH);
+      cairo_line_to (cr, x, FRAME_WIDTH + graph->real_draw_height);
+      cairo_stroke (cr);
+    }
+
+  cairo_restore (cr);
+}
+#endif
+
+static void
+load_graph_draw (GtkDrawingArea* area,
+                 cairo_t *cr,
+                 int      width,
+                 int      height,
+                 gpointer data_ptr)
+{
+  LoadGraph * const graph = static_cast<LoadGraph*>(data_ptr);
+  const gint64 frame_start = g_get_monotonic_time ();
+  cairo_surface_t * background;
+  guint frames_per_unit;
+  guint render_counter = gsm_graph_get_render_counter (GSM_GRAPH (area));
+  double rmargin = gsm_graph_get_right_margin (GSM_GRAPH (area));
+  guint num_points = gsm_graph_get_num_points (GSM_GRAPH (area));
+  guint indent = gsm_graph_get_indent (GSM_GRAPH (area));
+  graph->num_bars = gsm_graph_get_num_bars (GSM_GRAPH (area), height);
+
+  /* Initialize graph dimensions */
+  width -= 2 * FRAME_WIDTH;
+  height -= 2 * FRAME_WIDTH;
+
+  frames_per_unit = width / (num_points - 2);
+  if (frames_per_unit > 10) frames_per_unit = 10;
+  /* more points than pixels */
+  if (frames_per_unit < 1) frames_per_unit = 1;
+  gsm_graph_set_frames_per_unit(GSM_GRAPH (area), frames_per_unit);
+
+  graph->graph_dely = (height - 15) / graph->num_bars;   /* round to int to avoid AA blur */
+  graph->real_draw_height = graph->graph_dely * graph->num_bars;
+
+  /* Number of pixels wide for one sample point */
+  const double x_step = double(width - rmargin - graph->indent) / (graph->num_points - 2);
+
+  /* Lines start at the right edge of the drawing,
+   * a bit outside the clip rectangle. */
+  /* Adjustment for smooth movement between samples */
+  double x_offset = width - rmargin + FRAME_WIDTH;
+
+  /* Shift the x position of the most recent (shown rightmost) value outside of the clip area in order
+     to be able to simulate continuous, smooth movement without the line being cut off at its ends */
+  x_offset += x_step * (1 - render_counter / double(frames_per_unit));
+
+  if (graph->zoom)
+    update_zoom_max (graph);
+
+  /* Draw background */
+  if (!gsm_graph_is_background_set (GSM_GRAPH (graph->disp))) {
+    background = create_background (graph, width, height);
+    gsm_graph_set_background (GSM_GRAPH (graph->disp), background);
+
+    /* Whatever cleared the background changed the lines too */
+    g_clear_pointer (&graph->lines, cairo_surface_destroy);
+    g_clear_pointer (&graph->zoomed, cairo_surface_destroy);
+  } else {
+    background = gsm_graph_get_background (GSM_GRAPH (graph->disp));
+  }
+
+  cairo_set_source_surface (cr, background, 0, 0);
+  cairo_paint (cr);
+
+  /* Clip the drawing area to the inside of the drawn background */
+  cairo_rectangle (cr,
+                   indent + FRAME_WIDTH,
+                   FRAME_WIDTH,
+                   width - rmargin - indent,
+                   graph->real_draw_height);
+  cairo_clip (cr);
+
+  bool drawHeatmap = graph->type == LOAD_GRAPH_CPU && GsmApplication::get ().config.draw_heatmap;
+  bool drawStacked = (graph->type == LOAD_GRAPH_CPU && GsmApplication::get ().config.draw_stacked && !drawHeatmap)
+                     || graph->type == LOAD_GRAPH_CPU_TIMES;
+  bool drawSmooth = GsmApplication::get ().config.draw_smooth;
+  gsm_graph_set_smooth_chart (GSM_GRAPH (area), drawSmooth);
+  gsm_graph_set_stacked_chart (GSM_GRAPH (area), drawStacked);
+
+  if (graph->zoom)
+    draw_zoomed (graph, cr, indent + FRAME_WIDTH, width - rmargin - indent);
+  else if (drawHeatmap)
+    draw_heatmap (graph, cr, x_offset, x_step);
+  else
+    draw_lines (graph, cr, x_offset, x_step, height + 2 * FRAME_WIDTH, drawSmooth, drawStacked);
+
+#ifdef __linux__
+  if (!graph->zoom)
+    draw_markers (graph, cr, x_offset, x_step);
+#endif
+
+  graph->frame_time += g_get_monotonic_time () - frame_start;
+
+  if (++graph->n_frames == 100)
+    {
+      procman_debug ("graph %d: %.3f ms per frame, %u full repaints",
+                     graph->type, graph->frame_time / 1000.0 / graph->n_frames, graph->n_repaints);
+      graph->frame_time = 0;
+      graph->n_frames = 0;
+      graph->n_repaints = 0;
+    }
+}
+
+void
+load_graph_reset (LoadGraph *graph)
+{
+  graph->iteration = 0;
+  graph->data.reset ();
+#ifdef __linux__
+  graph->markers.clear ();
+#endif
+  g_clear_pointer (&graph->lines, cairo_surface_destroy);
+  g_clear_pointer (&graph->heatmap, cairo_surface_destroy);
+}
+
+static void
+archive_values (LoadGraph   *graph,
+                gint64       time,
+                const float *values)
+{
+  if (graph->archive.series () == graph->n)
+    {
+      graph->archive.add (time + graph->archive_offset, values);
+    }
+  else
+    {
+      const float mean = std::accumulate (values, values + graph->n, 0.0f) / graph->n;
+
+      graph->archive.add (time + graph->archive_offset, &mean);
+    }
+}
+
+/* Keeps the raw values of a new point, taken at @time of the monotonic
+   clock, in the archive and in the history file */
+static void
+load_graph_record (LoadGraph   *graph,
+                   gint64       time,
+                   const float *values)
+{
+  archive_values (graph, time, values);
+
+  if (graph->history)
+    gsm_history_file_append (graph->history, g_get_real_time () - (g_get_monotonic_time () - time), values);
+}
+
+static inline float
+cpu_load (guint64 total_now,
+          guint64 total_last,
+          guint64 used_now,
+          guint64 used_last)
+{
+  /* A few seconds of ticks fit in 32 bits, and convert faster */
+  const gint32 total = total_now - total_last;
+  const gint32 used = used_now - used_last;
+
+  return float (used) / MAX (total, 1);
+}
+
+/* Loads of the @n CPUs, from their counters kept side by side */
+static void
+cpu_loads (const guint64 *total_now,
+           const guint64 *total_last,
+           const guint64 *used_now,
+           const guint64 *used_last,
+           float         *loads,
+           guint          n)
+{
+  for (guint i = 0; i < n; i++)
+    loads[i] = cpu_load (total_now[i], total_last[i], used_now[i], used_last[i]);
+}
+
+/* Key of @fraction shown as a percentage with a decimal */
+static inline guint64
+percent_key (double fraction)
+{
+  return llround (MAX (fraction, 0.0) * 1000.0);
+}
+
+/* Key of what g_format_size_full () shows of @size with @flags: the
+   bytes below the first unit, else the unit and the tenths of it */
+static guint64
+size_key (guint64          size,
+          GFormatSizeFlags flags)
+{
+  const double base = (flags & G_FORMAT_SIZE_IEC_UNITS) ? 1024.0 : 1000.0;
+  double value = size;
+  guint64 unit = 0;
+
+  while (value >= base && unit < 6)
+    {
+      value /= base;
+      unit++;
+    }
+
+  if (unit == 0)
+    return (guint64 (flags) << 60) | size;
+
+  return (guint64 (flags) << 60) | (unit << 56) | guint64 (llround (value * 10.0));
+}
+
+/* Whether @label has to be set to show the values of @keys, rounded
+   like it shows them: not if it already does, nor while it is hidden
+   in a collapsed section or another tab, as a text set again is laid
+   out again.  A label shown again keeps the values of its text. */
+static bool
+label_needs_update (LoadGraph                    *graph,
+                    GtkLabel                     *label,
+                    const std::array<guint64, 4> &keys)
+{
+  if (!label || !gtk_widget_get_mapped (GTK_WIDGET (label)))
+    return false;
+
+  const auto [it, inserted] = graph->labels.shown.try_emplace (label, keys);
+
+  if (!inserted && it->second == keys)
+    return false;
+
+  it->second = keys;
+  return true;
+}
+
+/* Sets @label to @size, as a rate or as a volume, like procman::format_size () */
+static void
+set_size_label (LoadGraph *graph,
+                GtkLabel  *label,
+                guint64    size,
+                bool       want_bits,
+                bool       rate)
+{
+  const GFormatSizeFlags flags = want_bits ? G_FORMAT_SIZE_BITS : G_FORMAT_SIZE_IEC_UNITS;
+
+  if (!label_needs_update (graph, label, { size_key (want_bits ? size * 8 : size, flags) }))
+    return;
+
+  if (rate)
+    gtk_label_set_text (label, procman::format_rate (size, want_bits).c_str ());
+  else
+    gtk_label_set_text (label, procman::format_volume (size, want_bits).c_str ());
+}
+
+static void
+set_rate_labels (LoadGraph *graph,
+                 GtkLabel  *label_in,
+                 GtkLabel  *label_in_total,
+                 GtkLabel  *label_out,
+                 GtkLabel  *label_out_total,
+                 guint64    din,
+                 guint64    in,
+                 guint64    dout,
+                 guint64    out,
+                 bool       in_bits,
+                 bool       totals_in_bits)
+{
+  set_size_label (graph, label_in, din, in_bits, true);
+  set_size_label (graph, label_in_total, in, totals_in_bits, false);
+  set_size_label (graph, label_out, dout, in_bits, true);
+  set_size_label (graph, label_out_total, out, totals_in_bits, false);
+}
+
+static void
+get_load (LoadGraph *graph)
+{
+  guint i;
+  const glibtop_cpu &cpu = *gsm_sampler_get_cpu (NULL);
+
+  std::vector<guint64> (&now)[N_CPU_STATES] = graph->cpu.times[graph->cpu.now];
+  std::vector<guint64> (&last)[N_CPU_STATES] = graph->cpu.times[graph->cpu.now ^ 1];
+
+  if (graph->n == 1)
+    {
+      now[CPU_TOTAL][0] = cpu.total;
+      now[CPU_USED][0] = cpu.user + cpu.nice + cpu.sys;
+    }
+  else
+    {
+      for (i = 0; i < graph->n; i++)
+        {
+          now[CPU_TOTAL][i] = cpu.xcpu_total[i];
+          now[CPU_USED][i] = cpu.xcpu_user[i] + cpu.xcpu_nice[i] + cpu.xcpu_sys[i];
+        }
+    }
+
+  // on the first call, LAST is 0
+  // which means data is set to the average load since boot
+  // that value has no meaning, we just want all the
+  // graphs to be aligned, so the CPU graph needs to start
+  // immediately
+  bool drawStacked = GsmApplication::get ().config.draw_stacked && !GsmApplication::get ().config.draw_heatmap;
+
+  if(graph->iteration != 1) {
+    cpu_loads (&now[CPU_TOTAL][0], &last[CPU_TOTAL][0],
+               &now[CPU_USED][0], &last[CPU_USED][0],
+               &graph->cpu.loads[0], graph->n);
+
+    for (i = 0; i < graph->n; i++)
+      {
+        graph->data.at (i, 0) = graph->cpu.loads[i];
+        if (drawStacked)
+          {
+            graph->data.at (i, 0) /= graph->n;
+            if (i > 0)
+              graph->data.at (i, 0) += graph->data.at (i - 1, 0);
+          }
+      }
+
+    load_graph_record (graph, g_get_monotonic_time (), &graph->cpu.loads[0]);
+
+    if (graph->labels.cpu_legend)
+      gsm_cpu_legend_set_loads (graph->labels.cpu_legend, &graph->cpu.loads[0]);
+
+    for (i = 0; i < graph->labels.cpu.size (); i++)
+      {
+        char text[32];
+
+        if (!label_needs_update (graph, graph->labels.cpu[i], { percent_key (graph->cpu.loads[i]) }))
+          continue;
+
+        /* Update label */
+        // Translators: CPU usage percentage label: 95.7%
+        g_snprintf (text, sizeof text, _("%.1f%%"), graph->cpu.loads[i] * 100.0f);
+        gtk_label_set_text (GTK_LABEL (graph->labels.cpu[i]), text);
+      }
+  }
+
+  graph->cpu.now ^= 1;
+}
+
+static void
+set_memory_label_and_picker (LoadGraph      *graph,
+                             GtkLabel       *label,
+                             GsmColorButton *picker,
+                             guint64         used,
+                             guint64         cached,
+                             guint64         total,
+                             double          percent)
+{
+  const bool iec = GsmApplication::get ().config.resources_memory_in_iec;
+  const GFormatSizeFlags flags = iec ? G_FORMAT_SIZE_IEC_UNITS : G_FORMAT_SIZE_DEFAULT;
+
+  if (label_needs_update (graph, label, { size_key (used, flags), size_key (cached, flags),
+                                          size_key (total, flags), percent_key (percent) }))
+    {
+      if (total == 0)
+        {
+          gtk_label_set_text (label, _("not available"));
+        }
+      else
+        {
+          g_autofree char *used_text = format_byte_size (used, iec);
+          g_autofree char *total_text = format_byte_size (total, iec);
+          char text[256];
+          int length;
+
+          // xgettext: "540MiB (53 %) of 1.0 GiB" or "540MB (53 %) of 1.0 GB"
+          length = g_snprintf (text, sizeof text, _("%s (%.1f%%) of %s"), used_text, 100.0 * percent, total_text);
+
+          if (cached != 0 && length < int (sizeof text) - 1)
+            {
+              g_autofree char *cached_text = format_byte_size (cached, iec);
+
+              text[length] = '\n';
+              // xgettext: Used cache string, e.g.: "Cache 2.4GiB" or "Cache 2.4GB"
+              g_snprintf (text + length + 1, sizeof text - length - 1, _("Cache %s"), cached_text);
+            }
+
+          gtk_label_set_text (label, text);
+        }
+    }
+
+  if (picker)
+    gsm_color_button_set_fraction (picker, percent);
+}
+
+static void
+get_memory (LoadGraph *graph)
+{
+  float mempercent, swappercent;
+
+  glibtop_mem mem;
+  glibtop_swap swap;
+
+  glibtop_get_mem (&mem);
+  glibtop_get_swap (&swap);
+
+  /* There's no swap on LiveCD : 0.0f is better than NaN :) */
+  swappercent = (swap.total ? (float)swap.used / (float)swap.total : 0.0f);
+  mempercent = (float)mem.user / (float)mem.total;
+  set_memory_label_and_picker (graph, GTK_LABEL (graph->labels.memory),
+                               GSM_COLOR_BUTTON (graph->mem_color_picker),
+                               mem.user, mem.cached, mem.total, mempercent);
+
+  set_memory_label_and_picker (graph, GTK_LABEL (graph->labels.swap),
+                               GSM_COLOR_BUTTON (graph->swap_color_picker),
+                               swap.used, 0, swap.total, swappercent);
+
+  gtk_widget_set_sensitive (GTK_WIDGET (graph->swap_color_picker), swap.total > 0);
+
+  if(graph->iteration != 1) {
+    const float values[] = { mempercent, swap.total > 0 ? swappercent : -1.0f };
+
+    load_graph_record (graph, g_get_monotonic_time (), values);
+    graph->data.at (0, 0) = graph->translate_to_log_partial_if_needed (mempercent);
+    graph->data.at (1, 0) = swap.total > 0 ? graph->translate_to_log_partial_if_needed (swappercent) : -1.0;
+  }
+}
+
+/* Nice Numbers for Graph Labels after Paul Heckbert
+   nicenum: find a "nice" number approximately equal to x.
+   Round the number if round=1, take ceiling if round=0    */
+
+static double
+nicenum (double x,
+         int    round)
+{
+  int expv;                  /* exponent of x */
+  double f;                  /* fractional part of x */
+  double nf;                  /* nice, rounded fraction */
+
+  expv = floor (log10 (x));
+  f = x / pow (10.0, expv);       /* between 1 and 10 */
+  if (round)
+    {
+      if (f < 1.5)
+        nf = 1.0;
+      else if (f < 3.0)
+        nf = 2.0;
+      else if (f < 7.0)
+        nf = 5.0;
+      else
+        nf = 10.0;
+    }
+  else
+    {
+      if (f <= 1.0)
+        nf = 1.0;
+      else if (f <= 2.0)
+        nf = 2.0;
+      else if (f <= 5.0)
+        nf = 5.0;
+      else
+        nf = 10.0;
+    }
+  return nf * pow (10.0, expv);
+}
+
+static void
+dynamic_scale (LoadGraph    *graph,
+               SlidingMax   *values,
+               guint64      *max,
+               RoundedScale *rounded,
+               guint64       din,
+               guint64       dout,
+               gboolean      in_bits)
+{
+  graph->data.at (0, 0) = 1.0f * din / *max;
+  graph->data.at (1, 0) = 1.0f * dout / *max;
+
+  guint64 dmax = std::max (din, dout);
+
+  values->push (dmax);
+
+  guint64 new_max = values->max ();
+
+  // the rounding only depends on the greatest value and on the ticks,
+  // *max is left as it was rounded from them
+  const RoundedScale key = { new_max, in_bits ? graph->num_bars : 0 };
+
+  if (key.max == rounded->max && key.bars == rounded->bars)
+    return;
+
+  //
+  // Round maximum
+  //
+
+  const guint64 bak_max (new_max);
+
+  if (in_bits)
     {
       // nice number is for the ticks
       unsigned ticks = graph->num_bars;
 
-      if (graph->num_bars == 0)
-        return;
+      if (graph->num_bars == 0)
+        return;
+
+      *rounded = key;
+
+      // gets messy at low values due to division by 8
+      guint64 bit_max = std::max (new_max * 8, G_GUINT64_CONSTANT (10000));
+
+      // our tick size leads to max
+      double d = nicenum (bit_max / ticks, 0);
+      bit_max = ticks * d;
+      new_max = bit_max / 8;
+
+      procman_debug ("bak*8 %" G_GUINT64_FORMAT ", ticks %d, d %f"
+                     ", bit_max %" G_GUINT64_FORMAT ", new_max %" G_GUINT64_FORMAT,
+                     bak_max * 8, ticks, d, bit_max, new_max);
+    }
+  else
+    {
+      *rounded = key;
+
+      // round up to get some extra space
+      // yes, it can overflow
+      new_max = 1.1 * new_max;
+      // make sure max is not 0 to avoid / 0
+      // default to 1 KiB
+      new_max = std::max (new_max, G_GUINT64_CONSTANT (1024));
+
+      // decompose new_max = coef10 * 2**(base10 * 10)
+      // where coef10 and base10 are integers and coef10 < 2**10
+      //
+      // e.g: ceil(100.5 KiB) = 101 KiB = 101 * 2**(1 * 10)
+      //      where base10 = 1, coef10 = 101, pow2 = 16
+
+      guint64 pow2 = std::floor (log2 (new_max));
+      guint64 base10 = pow2 / 10.0;
+      guint64 coef10 = std::ceil (new_max / double (G_GUINT64_CONSTANT (1) << (base10 * 10)));
+      g_assert (new_max <= (coef10 * (G_GUINT64_CONSTANT (1) << (base10 * 10))));
+
+      // then decompose coef10 = x * 10**factor10
+      // where factor10 is integer and x < 10
+      // so we new_max has only 1 significant digit
+
+      guint64 factor10 = std::pow (10.0, std::floor (std::log10 (coef10)));
+      coef10 = std::ceil (coef10 / double (factor10)) * factor10;
+
+      new_max = coef10 * (G_GUINT64_CONSTANT (1) << guint64 (base10 * 10));
+      procman_debug ("bak %" G_GUINT64_FORMAT " new_max %" G_GUINT64_FORMAT
+                     "pow2 %" G_GUINT64_FORMAT " coef10 %" G_GUINT64_FORMAT,
+                     bak_max, new_max, pow2, coef10);
+    }
+
+  // if max is the same or has decreased but not so much, don't
+  // do anything to avoid rescaling
+  if ((0.8 * *max) < new_max && new_max <= *max)
+    return;
+
+  const double scale = 1.0f * *max / new_max;
+
+  for (guint i = 0; i < graph->num_points; i++)
+    if (graph->data.at (0, i) >= 0.0f)
+      {
+        graph->data.at (0, i) *= scale;
+        graph->data.at (1, i) *= scale;
+      }
+
+  procman_debug ("rescale dmax = %" G_GUINT64_FORMAT
+                 " max = %" G_GUINT64_FORMAT
+                 " new_max = %" G_GUINT64_FORMAT,
+                 dmax, *max, new_max);
+
+  *max = new_max;
+
+  // force the graph background to be redrawn now that scale has changed
+  graph->clear_background ();
+}
+
+static guint64
+get_hash64 (const gchar*c_str)
+{
+  // Fowler–Noll–Vo FNV-1 64-bit hash:
+
+  guint64 hash = 0xcbf29ce484222325L;
+
+  while (gchar c = *c_str++)
+    {
+      hash = (hash * 0x00000100000001B3L) ^ c;
+    }
+
+  return hash;
+}
+
+static void
+handle_dynamic_max_value (LoadGraph             *graph,
+                          SlidingMax            *values,
+                          guint64               *max,
+                          RoundedScale          *rounded,
+                          guint64               *last_in,
+                          guint64               *last_out,
+                          guint64                in,
+                          guint64                out,
+                          guint64               *graph_time,
+                          guint64                hash,
+                          guint64               *graph_hash,
+                          gboolean               in_bits,
+                          gboolean               totals_in_bits,
+                          GtkLabel              *label_in,
+                          GtkLabel              *label_out,
+                          GtkLabel              *label_in_total,
+                          GtkLabel              *label_out_total)
+{
+  guint64 time = g_get_monotonic_time ();
+  guint64 din, dout;
+
+  if (in >= *last_in && out >= *last_out &&
+      (graph_hash == NULL || hash == *graph_hash) &&
+      *graph_time != 0)
+    {
+      float dtime = ((double) (time - *graph_time)) / G_USEC_PER_SEC;
+      din = static_cast<guint64>((in - *last_in) / dtime);
+      dout = static_cast<guint64>((out - *last_out) / dtime);
+
+      const float rates[] = { float (din), float (dout) };
+
+      load_graph_record (graph, time, rates);
+    }
+  else
+    {
+      /* Don't calc anything if new data is less than old (interface
+         removed, counters reset, ...) or if it is the first time */
+      din = 0;
+      dout = 0;
+    }
+
+  *last_in = in;
+  *last_out = out;
+  *graph_time = time;
+  if (graph_hash != NULL)
+    *graph_hash = hash;
+
+  dynamic_scale (graph, values, max, rounded, din, dout, in_bits);
+
+  set_rate_labels (graph, label_in, label_in_total, label_out, label_out_total,
+                   din, in, dout, out, in_bits, totals_in_bits);
+}
+
+#ifdef __linux__
+/* The traffic of the loopback and of the software devices (bridges,
+   veth of the containers, tunnels) is counted on a physical interface
+   too, the total only sums up the physical ones */
+static inline bool
+is_physical_interface (GsmNetLinkFlags flags)
+{
+  return !(flags & (GSM_NET_LINK_LOOPBACK | GSM_NET_LINK_VIRTUAL));
+}
+
+/* Puts @names after the total in @drop_down, with @selected even
+   once gone, and keeps it selected */
+static void
+update_drop_down (GtkDropDown              *drop_down,
+                  GtkStringList            *list,
+                  std::vector<std::string> &shown,
+                  std::vector<std::string>  names,
+                  const std::string        &selected,
+                  bool                     &updating)
+{
+  if (!selected.empty () && !std::binary_search (names.begin (), names.end (), selected))
+    names.insert (std::lower_bound (names.begin (), names.end (), selected), selected);
+
+  if (names == shown)
+    return;
+
+  std::vector<const char *> strings;
+
+  for (const auto &name : names)
+    strings.push_back (name.c_str ());
+  strings.push_back (NULL);
+
+  updating = true;
+  gtk_string_list_splice (list, 1, shown.size (), strings.data ());
+  shown.swap (names);
+
+  const auto it = std::find (shown.begin (), shown.end (), selected);
+
+  gtk_drop_down_set_selected (drop_down, selected.empty () ? 0 : 1 + it - shown.begin ());
+  updating = false;
+}
+
+/* Lists the interfaces but the loopback in the drop down */
+static void
+update_interface_names (LoadGraph *graph)
+{
+  std::vector<std::string> names;
+
+  for (const auto &[name, iface] : graph->net.interfaces)
+    if (!(iface.flags & GSM_NET_LINK_LOOPBACK))
+      names.push_back (name);
+
+  update_drop_down (graph->labels.net_interface, graph->labels.net_interfaces, graph->net.names,
+                    std::move (names), graph->net.selected, graph->net.updating_names);
+}
+
+/*
+  Reads the counters of every interface from a single netlink dump and
+  keeps the rates of each one, so that any of them can be shown.  The
+  archive and the history file get the total.  Returns false if the dump
+  failed, libgtop is read then.
+*/
+static bool
+get_net_links (LoadGraph *graph)
+{
+  g_autoptr (GError) error = NULL;
+
+  if (!gsm_netlink_get_links (graph->net.netlink, graph->net.links, &error))
+    {
+      procman_debug ("netlink: %s", error->message);
+      return false;
+    }
+
+  const guint64 time = g_get_monotonic_time ();
+  const double dtime = double (time - graph->net.time) / G_USEC_PER_SEC;
+  guint64 in = 0, out = 0;
+  float total[] = { 0.0f, 0.0f };
+  bool has_total = false;
+
+  graph->net.dumps++;
+  graph->net.total.push ();
+
+  for (guint i = 0; i < graph->net.links->len; i++)
+    {
+      const GsmNetLink &link = g_array_index (graph->net.links, GsmNetLink, i);
+      auto [it, added] = graph->net.interfaces.try_emplace (link.name);
+      NetInterface &iface = it->second;
+
+      if (added)
+        iface.rates = GraphHistory (2, graph->num_points);
+
+      iface.rates.push ();
+
+      /* Nothing to compare new interfaces and reset counters with */
+      const bool has_rate = !added && iface.seen + 1 == graph->net.dumps && dtime > 0.0
+                            && link.rx_bytes >= iface.last_in && link.tx_bytes >= iface.last_out;
+
+      if (has_rate)
+        {
+          iface.rates.at (0, 0) = (link.rx_bytes - iface.last_in) / dtime;
+          iface.rates.at (1, 0) = (link.tx_bytes - iface.last_out) / dtime;
+        }
+
+      iface.flags = link.flags;
+      iface.last_in = link.rx_bytes;
+      iface.last_out = link.tx_bytes;
+      iface.seen = graph->net.dumps;
+
+      if (is_physical_interface (link.flags))
+        {
+          in += link.rx_bytes;
+          out += link.tx_bytes;
+
+          if (has_rate)
+            {
+              total[0] += iface.rates.at (0, 0);
+              total[1] += iface.rates.at (1, 0);
+              has_total = true;
+            }
+        }
+    }
+
+  std::erase_if (graph->net.interfaces, [graph](const auto &entry) {
+    return entry.second.seen != graph->net.dumps;
+  });
+
+  if (has_total)
+    {
+      graph->net.total.at (0, 0) = total[0];
+      graph->net.total.at (1, 0) = total[1];
+      load_graph_record (graph, time, total);
+    }
+
+  graph->net.time = time;
+
+  update_interface_names (graph);
+
+  if (graph->iteration == 1)
+    return true;
+
+  /* The shown interface, all the physical ones by default */
+  guint64 din = has_total ? total[0] : 0, dout = has_total ? total[1] : 0;
+
+  if (!graph->net.selected.empty ())
+    {
+      const auto it = graph->net.interfaces.find (graph->net.selected);
+
+      in = out = din = dout = 0;
+      if (it != graph->net.interfaces.end ())
+        {
+          in = it->second.last_in;
+          out = it->second.last_out;
+          din = MAX (it->second.rates.at (0, 0), 0.0);
+          dout = MAX (it->second.rates.at (1, 0), 0.0);
+        }
+    }
+
+  const bool in_bits = GsmApplication::get ().config.network_in_bits;
+  const bool totals_in_bits = GsmApplication::get ().config.network_total_in_bits;
+
+  dynamic_scale (graph, &graph->net.values, &graph->net.max, &graph->net.rounded, din, dout, in_bits);
+
+  set_rate_labels (graph, graph->labels.net_in, graph->labels.net_in_total,
+                   graph->labels.net_out, graph->labels.net_out_total,
+                   din, in, dout, out, in_bits, totals_in_bits);
+
+  return true;
+}
+#endif
+
+static void
+get_net (LoadGraph *graph)
+{
+  glibtop_netlist netlist;
+  guint32 i;
+  guint64 in = 0, out = 0;
+  guint64 hash = 1;
+  char **ifnames;
+
+#ifdef __linux__
+  if (graph->net.netlink && get_net_links (graph))
+    return;
+#endif
+
+  ifnames = glibtop_get_netlist (&netlist);
+
+  for (i = 0; i < netlist.number; ++i)
+    {
+      glibtop_netload netload;
+      glibtop_get_netload (&netload, ifnames[i]);
+
+      if (netload.if_flags & (1 << GLIBTOP_IF_FLAGS_LOOPBACK))
+        continue;
+
+      /* Skip interfaces without any IPv4/IPv6 address (or
+         those with only a LINK ipv6 addr) However we need to
+         be able to exclude these while still keeping the
+         value so when they get online (with NetworkManager
+         for example) we don't get a sudden peak.  Once we're
+         able to get this, ignoring down interfaces will be
+         possible too.  */
+      if (not ((netload.flags & (1 << GLIBTOP_NETLOAD_ADDRESS6))
+               and netload.scope6 != GLIBTOP_IF_IN6_SCOPE_LINK)
+          and not (netload.flags & (1 << GLIBTOP_NETLOAD_ADDRESS)))
+        continue; 
+
+      /* Don't skip interfaces that are down (GLIBTOP_IF_FLAGS_UP)
+         to avoid spikes when they are brought up */
+
+      in += netload.bytes_in;
+      out += netload.bytes_out;
+      hash += get_hash64 (ifnames[i]);
+    }
+
+  g_strfreev (ifnames);
+
+  if(graph->iteration != 1) {
+    handle_dynamic_max_value (graph, &graph->net.values, &graph->net.max, &graph->net.rounded, &graph->net.last_in,
+                            &graph->net.last_out, in, out, &graph->net.time,
+                            hash, &graph->net.last_hash,
+                            GsmApplication::get ().config.network_in_bits,
+                            GsmApplication::get ().config.network_total_in_bits,
+                            graph->labels.net_in, graph->labels.net_out,
+                            graph->labels.net_in_total, graph->labels.net_out_total);
+  }
+}
+
+#ifdef __linux__
+/* Lists the devices that had requests in the drop down, which leaves
+   out the loop and ram devices nobody uses */
+static void
+update_device_names (LoadGraph *graph)
+{
+  std::vector<std::string> names;
+
+  for (const auto &[name, device] : graph->disk.devices)
+    if (device.last.reads || device.last.writes)
+      names.push_back (name);
+
+  update_drop_down (graph->labels.disk_device, graph->labels.disk_devices, graph->disk.names,
+                    std::move (names), graph->disk.selected, graph->disk.updating_names);
+}
+
+/*
+  Reads the counters of every block device from a single parse of
+  /proc/diskstats and keeps the rates of each one, so that any of them
+  can be shown.  The total only sums the whole disks, the partitions and
+  the dm, md and loop devices have their requests counted on them too.
+  Returns false if the file can't be read, libgtop is read then.
+*/
+static bool
+get_disk_stats (LoadGraph *graph)
+{
+  g_autoptr (GError) error = NULL;
+
+  if (!gsm_diskstats_read (graph->disk.diskstats, graph->disk.stats, &error))
+    {
+      procman_debug ("diskstats: %s", error->message);
+      return false;
+    }
+
+  const guint64 time = g_get_monotonic_time ();
+  const double dtime = double (time - graph->disk.time) / G_USEC_PER_SEC;
+  guint64 read = 0, write = 0;
+  float total[] = { 0.0f, 0.0f };
+  GsmDiskRates total_rates = {};
+  bool has_total = false;
+
+  graph->disk.reads++;
+  graph->disk.total.push ();
+
+  for (guint i = 0; i < graph->disk.stats->len; i++)
+    {
+      const GsmDiskStat &stat = g_array_index (graph->disk.stats, GsmDiskStat, i);
+      auto [it, added] = graph->disk.devices.try_emplace (stat.name);
+      DiskDevice &device = it->second;
+
+      if (added)
+        device.rates = GraphHistory (2, graph->num_points);
+
+      device.rates.push ();
+      device.latest = GsmDiskRates {};
+
+      /* Nothing to compare new devices with */
+      const bool has_rates = !added && device.seen + 1 == graph->disk.reads
+                             && gsm_disk_stat_rates (&device.last, &stat, dtime, &device.latest);
+
+      if (has_rates)
+        {
+          device.rates.at (0, 0) = device.latest.read_bytes;
+          device.rates.at (1, 0) = device.latest.write_bytes;
+        }
+
+      device.last = stat;
+      device.seen = graph->disk.reads;
+
+      if (gsm_disk_stat_is_whole_disk (&stat))
+        {
+          read += stat.read_sectors * 512;
+          write += stat.write_sectors * 512;
+
+          if (has_rates)
+            {
+              total[0] += device.latest.read_bytes;
+              total[1] += device.latest.write_bytes;
+              /* The latency of all the requests, and the busiest disk */
+              total_rates.iops += device.latest.iops;
+              total_rates.latency += device.latest.latency * device.latest.iops;
+              total_rates.utilization = MAX (total_rates.utilization, device.latest.utilization);
+              has_total = true;
+            }
+        }
+    }
+
+  if (total_rates.iops > 0.0)
+    total_rates.latency /= total_rates.iops;
+
+  std::erase_if (graph->disk.devices, [graph](const auto &entry) {
+    return entry.second.seen != graph->disk.reads;
+  });
+
+  if (has_total)
+    {
+      graph->disk.total.at (0, 0) = total[0];
+      graph->disk.total.at (1, 0) = total[1];
+      load_graph_record (graph, time, total);
+    }
+
+  graph->disk.time = time;
+
+  update_device_names (graph);
+
+  if (graph->iteration == 1)
+    return true;
+
+  /* The shown device, all the whole disks by default */
+  guint64 dread = has_total ? total[0] : 0, dwrite = has_total ? total[1] : 0;
+  const GsmDiskRates *rates = has_total ? &total_rates : NULL;
+
+  if (!graph->disk.selected.empty ())
+    {
+      const auto it = graph->disk.devices.find (graph->disk.selected);
+
+      read = write = dread = dwrite = 0;
+      rates = NULL;
+      if (it != graph->disk.devices.end ())
+        {
+          read = it->second.last.read_sectors * 512;
+          write = it->second.last.write_sectors * 512;
+          dread = MAX (it->second.rates.at (0, 0), 0.0);
+          dwrite = MAX (it->second.rates.at (1, 0), 0.0);
+          rates = &it->second.latest;
+        }
+    }
+
+  dynamic_scale (graph, &graph->disk.values, &graph->disk.max, &graph->disk.rounded, dread, dwrite, FALSE);
+
+  set_rate_labels (graph, graph->labels.disk_read, graph->labels.disk_read_total,
+                   graph->labels.disk_write, graph->labels.disk_write_total,
+                   dread, read, dwrite, write, false, false);
+
+  if (!rates)
+    {
+      if (label_needs_update (graph, graph->labels.disk_details, { 0 }))
+        gtk_label_set_text (graph->labels.disk_details, "");
+    }
+  else if (label_needs_update (graph, graph->labels.disk_details,
+                               { 1, guint64 (llround (rates->iops)), guint64 (llround (rates->latency * 10.0)),
+                                 guint64 (llround (rates->utilization * 100.0)) }))
+    {
+      char details[128];
+
+      /* Translators: requests per second, average time of a request and
+         part of the time the disk had requests in flight */
+      g_snprintf (details, sizeof details, _("%.0f IOPS, %.1f ms, %.0f %% busy"),
+                  rates->iops, rates->latency, 100.0 * rates->utilization);
+      gtk_label_set_text (graph->labels.disk_details, details);
+    }
+
+  return true;
+}
+#endif
+
+static void
+get_disk (LoadGraph *graph)
+{
+  glibtop_disk disk;
+  gint32 i;
+  guint64 read = 0, write = 0;
+
+#ifdef __linux__
+  if (graph->disk.diskstats && get_disk_stats (graph))
+    return;
+#endif
+
+  glibtop_get_disk (&disk);
+
+  for (i = 0; i < glibtop_global_server->ndisk; i++)
+    {
+      read += disk.xdisk_sectors_read[i];
+      write += disk.xdisk_sectors_write[i];
+    }
+
+  // These sectors are standard unix 512 byte sectors, not the actual disk sectors.
+  read *= 512;
+  write *= 512;
+
+  if(graph->iteration != 1) {
+    handle_dynamic_max_value (graph, &graph->disk.values, &graph->disk.max, &graph->disk.rounded, &graph->disk.last_read,
+                            &graph->disk.last_write, read, write, &graph->disk.time, 0, NULL,
+                            FALSE, FALSE, graph->labels.disk_read, graph->labels.disk_write,
+                            graph->labels.disk_read_total, graph->labels.disk_write_total);
+  }
+}
+
+#ifdef __linux__
+/*
+  Stall rates from the stalled time the kernel counts, rather than its
+  averages, which lag behind.  The graph has the share of the time at
+  least a task was stalled on each resource, the labels have the share
+  all of them were as well.
+*/
+static void
+get_pressure (LoadGraph *graph)
+{
+  GsmPressureStat stats[GSM_PRESSURE_N_RESOURCES];
+  g_autoptr (GError) error = NULL;
+
+  if (!graph->pressure.reader)
+    return;
+
+  if (!gsm_pressure_read (graph->pressure.reader, stats, &error))
+    {
+      procman_debug ("pressure: %s", error->message);
+      return;
+    }
+
+  const gint64 time = g_get_monotonic_time ();
+  const gint64 usec = graph->pressure.time ? time - graph->pressure.time : 0;
+  float values[GSM_PRESSURE_N_RESOURCES];
+
+  for (guint i = 0; i < GSM_PRESSURE_N_RESOURCES; i++)
+    {
+      const GsmPressureStat &last = graph->pressure.last[i];
+      const double some = gsm_pressure_stall (&last.some, &stats[i].some, usec);
+      const double full = gsm_pressure_stall (&last.full, &stats[i].full, usec);
+      char text[64];
+
+      values[i] = some;
+
+      if (label_needs_update (graph, graph->labels.pressure[i],
+                              { guint64 (stats[i].has_full), percent_key (some), percent_key (full) }))
+        {
+          if (stats[i].has_full)
+            // Translators: pressure stall label, share of the time some and all the tasks waited: 2.5%, 0.4%
+            g_snprintf (text, sizeof text, _("%.1f%%, %.1f%%"), some * 100.0, full * 100.0);
+          else
+            g_snprintf (text, sizeof text, _("%.1f%%"), some * 100.0);
+          gtk_label_set_text (graph->labels.pressure[i], text);
+        }
+
+      /* The averages are percentages already */
+      if (label_needs_update (graph, graph->labels.pressure_avg[i],
+                              { percent_key (stats[i].some.avg10 / 10.0), percent_key (stats[i].some.avg60 / 10.0),
+                                percent_key (stats[i].some.avg300 / 10.0) }))
+        {
+          // Translators: averages of the pressure stall over 10 s, 1 and 5 minutes: 2.50, 1.20, 0.40
+          g_snprintf (text, sizeof text, _("%.2f, %.2f, %.2f"),
+                      stats[i].some.avg10, stats[i].some.avg60, stats[i].some.avg300);
+          gtk_label_set_text (graph->labels.pressure_avg[i], text);
+        }
+    }
+
+  std::copy_n (stats, GSM_PRESSURE_N_RESOURCES, graph->pressure.last);
+  graph->pressure.time = time;
+
+  if (usec > 0 && graph->iteration != 1)
+    {
+      load_graph_record (graph, time, values);
+      for (guint i = 0; i < GSM_PRESSURE_N_RESOURCES; i++)
+        graph->data.at (i, 0) = values[i];
+    }
+}
+
+/* Reads the pressure of the system or of the cgroup at @path from then on */
+static void
+open_pressure (LoadGraph  *graph,
+               const char *path)
+{
+  g_autoptr (GError) error = NULL;
+
+  g_clear_pointer (&graph->pressure.reader, gsm_pressure_free);
+  graph->pressure.time = 0;
+  graph->pressure.cgroup = path;
+
+  graph->pressure.reader = gsm_pressure_new (path[0] ? path : NULL, &error);
+  if (!graph->pressure.reader)
+    procman_debug ("no pressure: %s", error->message);
+}
+
+/* Lists the cgroups in the drop down, with the one shown */
+static void
+update_cgroup_names (LoadGraph *graph)
+{
+  g_auto (GStrv) cgroups = gsm_pressure_list_cgroups ();
+
+  update_drop_down (graph->labels.pressure_cgroup, graph->labels.pressure_cgroups, graph->pressure.names,
+                    std::vector<std::string> (cgroups, cgroups + g_strv_length (cgroups)),
+                    graph->pressure.cgroup, graph->pressure.updating_names);
+}
+
+void
+load_graph_set_pressure_cgroup (LoadGraph  *graph,
+                                const char *path)
+{
+  if (graph->type != LOAD_GRAPH_PRESSURE || graph->pressure.cgroup == path)
+    return;
+
+  open_pressure (graph, path);
+  update_cgroup_names (graph);
+
+  /* The values of the former group are not those of the new one, nor
+     are the archived and recorded ones */
+  for (guint j = 0; j < graph->n; j++)
+    for (guint age = 0; age < graph->data.size (); age++)
+      graph->data.at (j, age) = -1.0;
+  graph->archive.clear ();
+  g_clear_pointer (&graph->zoomed, cairo_surface_destroy);
+  if (graph->history)
+    gsm_history_file_clear (graph->history);
+  graph->clear_background ();
+}
+
+/*
+  The times of every CPU by state, from a single read of /proc/stat.  The
+  shares of all the rows are computed at once, see gsm_cpu_times_shares ();
+  only the row shown is graphed, its busy states stacked, idle being what
+  is left above them.  The archive and the history file get the total, as
+  for the network and the disks, so that they do not mix CPUs.
+*/
+static void
+get_cpu_times (LoadGraph *graph)
+{
+  LoadGraph::CPU_TIMES &cpu_times = graph->cpu_times;
+  GArray *now = cpu_times.times[cpu_times.now];
+  GArray *last = cpu_times.times[cpu_times.now ^ 1];
+  g_autoptr (GError) error = NULL;
+
+  if (!cpu_times.reader)
+    return;
+
+  /* Not read while hidden, nor compared to the read before that */
+  if (!GsmApplication::get ().config.show_cpu_times)
+    {
+      g_array_set_size (now, 0);
+      g_array_set_size (last, 0);
+      return;
+    }
+
+  if (!gsm_proc_stat_read (cpu_times.reader, GsmApplication::get ().config.num_cpus, now, &error))
+    {
+      procman_debug ("cpu times: %s", error->message);
+      g_array_set_size (now, 0);
+      return;
+    }
+
+  cpu_times.now ^= 1;
+
+  if (last->len != now->len)
+    return;
+
+  const guint n_rows = now->len / GSM_CPU_N_STATES;
+
+  gsm_cpu_times_shares (&g_array_index (last, guint64, 0), &g_array_index (now, guint64, 0),
+                        n_rows, cpu_times.shares.data ());
+
+  const float *shares = &cpu_times.shares[gsize (MIN (cpu_times.selected, n_rows - 1)) * GSM_CPU_N_STATES];
+  float sum = 0.0f;
+
+  load_graph_record (graph, g_get_monotonic_time (), &cpu_times.shares[0]);
+
+  for (guint i = 0; i < graph->n; i++)
+    {
+      char text[32];
+
+      sum += shares[i];
+      graph->data.at (i, 0) = sum;
+
+      if (!label_needs_update (graph, graph->labels.cpu_times[i], { percent_key (shares[i]) }))
+        continue;
+
+      // Translators: CPU usage percentage label: 95.7%
+      g_snprintf (text, sizeof text, _("%.1f%%"), shares[i] * 100.0f);
+      gtk_label_set_text (graph->labels.cpu_times[i], text);
+    }
+}
+
+void
+load_graph_select_cpu (LoadGraph *graph,
+                       guint      cpu)
+{
+  if (graph->type != LOAD_GRAPH_CPU_TIMES)
+    return;
+
+  cpu = MIN (cpu, GsmApplication::get ().config.num_cpus);
+
+  if (graph->labels.cpu_times_cpu && gtk_drop_down_get_selected (graph->labels.cpu_times_cpu) != cpu)
+    {
+      graph->cpu_times.updating = true;
+      gtk_drop_down_set_selected (graph->labels.cpu_times_cpu, cpu);
+      graph->cpu_times.updating = false;
+    }
+
+  if (graph->cpu_times.selected == cpu)
+    return;
+
+  graph->cpu_times.selected = cpu;
+
+  /* The points of the former CPU are not those of the new one */
+  for (guint j = 0; j < graph->n; j++)
+    for (guint age = 0; age < graph->data.size (); age++)
+      graph->data.at (j, age) = -1.0;
+  graph->clear_background ();
+}
+
+void
+load_graph_add_marker (LoadGraph           *graph,
+                       GsmPressureResource  resource)
+{
+  const guint64 latest = graph->data.latest_index ();
+
+  /* Dropped here too, a graph that is not drawn would keep them all */
+  while (!graph->markers.empty () && graph->markers.front ().index + graph->num_points <= latest)
+    graph->markers.pop_front ();
+
+  /* Stalls of a resource until the next point are a single marker */
+  for (auto it = graph->markers.rbegin (); it != graph->markers.rend () && it->index == latest + 1; ++it)
+    if (it->resource == resource)
+      return;
+
+  graph->markers.push_back ({ latest + 1, resource });
+}
+#endif
+
+int
+load_graph_update_data (LoadGraph *graph)
+{
+  // Make room for the latest point, dropping the oldest one.
+  graph->data.push ();
+
+  graph->iteration++;
+
+  // Replace the 0th element
+  switch (graph->type)
+    {
+      case LOAD_GRAPH_CPU:
+        get_load (graph);
+        break;
+
+      case LOAD_GRAPH_MEM:
+        get_memory (graph);
+        break;
+
+      case LOAD_GRAPH_NET:
+        get_net (graph);
+        break;
+
+      case LOAD_GRAPH_DISK:
+        get_disk (graph);
+        break;
+
+#ifdef __linux__
+      case LOAD_GRAPH_PRESSURE:
+        get_pressure (graph);
+        break;
+
+      case LOAD_GRAPH_CPU_TIMES:
+        get_cpu_times (graph);
+        break;
+#endif
+
+      default:
+        g_assert_not_reached ();
+    }
+  return 0;
+}
+
+static void
+load_graph_destroy (GtkWidget*,
+                    gpointer data_ptr)
+{
+  LoadGraph * const graph = static_cast<LoadGraph*>(data_ptr);
+
+  delete graph;
+}
+
+static GsmHistoryFile *
+open_history (guint type,
+              guint n_values)
+{
+  static const char *const names[] = { "cpu", "memory", "network", "disk", "pressure", "cpu-times" };
+  g_autofree gchar *dir = g_build_filename (g_get_user_cache_dir (), "gnome-system-monitor", NULL);
+  g_autofree gchar *name = g_strconcat (names[type], ".history", NULL);
+  g_autofree gchar *path = g_build_filename (dir, name, NULL);
+  g_autoptr (GError) error = NULL;
+
+  if (g_mkdir_with_parents (dir, 0700) < 0)
+    {
+      procman_debug ("cannot create %s: %s", dir, g_strerror (errno));
+      return NULL;
+    }
+
+  GsmHistoryFile *history = gsm_history_file_open (path, n_values, HISTORY_RECORDS, &error);
+
+  if (!history)
+    procman_debug ("no history: %s", error->message);
+
+  return history;
+}
+
+/* Turns the rates in the points of a network or disk graph, up to
+   @max_rate, into points of its scale */
+static void
+load_graph_scale_rates (LoadGraph *graph,
+                        float      max_rate)
+{
+  guint64 &max = graph->type == LOAD_GRAPH_NET ? graph->net.max : graph->disk.max;
+  SlidingMax &rates = graph->type == LOAD_GRAPH_NET ? graph->net.values : graph->disk.values;
+  RoundedScale &rounded = graph->type == LOAD_GRAPH_NET ? graph->net.rounded : graph->disk.rounded;
+
+  max = nicenum (MAX (1.1 * max_rate, 1024.0), 0);
+  rates.fill (guint64 (max_rate));
+  rounded = { G_MAXUINT64, 0 };
+
+  for (guint j = 0; j < graph->n; j++)
+    for (guint age = 0; age < graph->data.size (); age++)
+      if (graph->data.at (j, age) >= 0.0)
+        graph->data.at (j, age) /= max;
 
-      // gets messy at low values due to division by 8
-      guint64 bit_max = std::max (new_max * 8, G_GUINT64_CONSTANT (10000));
+  gsm_graph_set_max_value (graph->disp, max);
+}
 
-      // our tick size leads to max
-      double d = nicenum (bit_max / ticks, 0);
-      bit_max = ticks * d;
-      new_max = bit_max / 8;
+/*
+  The history file gives the graph its points back after a restart.  The
+  records are read in place from the mapping, each one is put at the
+  point of its age and added to the archive.  The records may predate the
+  start of the monotonic clock, after a reboot, so the archive is moved
+  forward for the oldest one to fit.
+*/
+static void
+load_graph_replay_history (LoadGraph *graph)
+{
+  const gint64 real_now = g_get_real_time ();
+  const gint64 monotonic_now = g_get_monotonic_time ();
+  const gint64 interval = gint64 (graph->speed) * 1000;
+  const bool stacked = graph->type == LOAD_GRAPH_CPU && GsmApplication::get ().config.draw_stacked
+                       && !GsmApplication::get ().config.draw_heatmap;
+  const guint length = gsm_history_file_get_length (graph->history);
+#ifdef __linux__
+  /* The CPU times recorded are those of the total */
+  const bool points = graph->type != LOAD_GRAPH_CPU_TIMES || graph->cpu_times.selected == 0;
+#else
+  const bool points = true;
+#endif
+  float max_rate = 0.0f;
+  guint replayed = 0;
+
+  for (guint age = 0; age < length; age++)
+    {
+      const float *values;
+      gint64 time;
 
-      procman_debug ("bak*8 %" G_GUINT64_FORMAT ", ticks %d, d %f"
-                     ", bit_max %" G_GUINT64_FORMAT ", new_max %" G_GUINT64_FORMAT,
-                     bak_max * 8, ticks, d, bit_max, new_max);
+      if (gsm_history_file_get (graph->history, age, &time, &values) && time <= real_now)
+        graph->archive_offset = MAX (graph->archive_offset, real_now - time - monotonic_now);
     }
-  else
+
+  /* The oldest first, in the order of the archive */
+  for (guint age = length; age-- > 0;)
     {
-      // round up to get some extra space
-      // yes, it can overflow
-      new_max = 1.1 * new_max;
-      // make sure max is not 0 to avoid / 0
-      // default to 1 KiB
-      new_max = std::max (new_max, G_GUINT64_CONSTANT (1024));
+      const float *values;
+      gint64 time;
 
-      // decompose new_max = coef10 * 2**(base10 * 10)
-      // where coef10 and base10 are integers and coef10 < 2**10
-      //
-      // e.g: ceil(100.5 KiB) = 101 KiB = 101 * 2**(1 * 10)
-      //      where base10 = 1, coef10 = 101, pow2 = 16
+      if (!gsm_history_file_get (graph->history, age, &time, &values) || time > real_now)
+        continue;
 
-      guint64 pow2 = std::floor (log2 (new_max));
-      guint64 base10 = pow2 / 10.0;
-      guint64 coef10 = std::ceil (new_max / double (G_GUINT64_CONSTANT (1) << (base10 * 10)));
-      g_assert (new_max <= (coef10 * (G_GUINT64_CONSTANT (1) << (base10 * 10))));
+      archive_values (graph, monotonic_now - (real_now - time), values);
+      replayed++;
 
-      // then decompose coef10 = x * 10**factor10
-      // where factor10 is integer and x < 10
-      // so we new_max has only 1 significant digit
+      const guint64 point = (real_now - time) / interval;
 
-      guint64 factor10 = std::pow (10.0, std::floor (std::log10 (coef10)));
-      coef10 = std::ceil (coef10 / double (factor10)) * factor10;
+      if (!points || point >= graph->data.size ())
+        continue;
 
-      new_max = coef10 * (G_GUINT64_CONSTANT (1) << guint64 (base10 * 10));
-      procman_debug ("bak %" G_GUINT64_FORMAT " new_max %" G_GUINT64_FORMAT
-                     "pow2 %" G_GUINT64_FORMAT " coef10 %" G_GUINT64_FORMAT,
-                     bak_max, new_max, pow2, coef10);
+      for (guint j = 0; j < graph->n; j++)
+        {
+          double value = values[j];
+
+          if (value >= 0.0)
+            switch (graph->type)
+              {
+                case LOAD_GRAPH_CPU:
+                  if (stacked)
+                    value = value / graph->n + (j > 0 ? graph->data.at (j - 1, point) : 0.0);
+                  break;
+
+                case LOAD_GRAPH_MEM:
+                  value = graph->translate_to_log_partial_if_needed (value);
+                  break;
+
+                case LOAD_GRAPH_NET:
+                  graph->net.total.at (j, point) = value;
+                  max_rate = MAX (max_rate, value);
+                  break;
+
+                case LOAD_GRAPH_DISK:
+                  graph->disk.total.at (j, point) = value;
+                  max_rate = MAX (max_rate, value);
+                  break;
+
+                case LOAD_GRAPH_PRESSURE:
+                  break;
+
+                case LOAD_GRAPH_CPU_TIMES:
+                  value += j > 0 ? graph->data.at (j - 1, point) : 0.0;
+                  break;
+
+                default:
+                  max_rate = MAX (max_rate, value);
+                  break;
+              }
+
+          graph->data.at (j, point) = value;
+        }
     }
 
-  // if max is the same or has decreased but not so much, don't
-  // do anything to avoid rescaling
-  if ((0.8 * graph->net.max) < new_max && new_max <= graph->net.max)
-    return;
+  if (max_rate > 0.0f)
+    load_graph_scale_rates (graph, max_rate);
 
-  const double scale = 1.0f * *max / new_max;
+  procman_debug ("graph %d: %u points from the history", graph->type, replayed);
+}
 
-  for (size_t i = 0; i < graph->num_points; i++)
-    if (graph->data[i][0] >= 0.0f)
+#ifdef __linux__
+/* Shows the @rates kept so far for a network interface or a disk, no
+   points at all if NULL */
+static void
+load_graph_show_rates (LoadGraph          *graph,
+                       const GraphHistory *rates)
+{
+  float max_rate = 0.0f;
+
+  for (guint j = 0; j < graph->n; j++)
+    for (guint age = 0; age < graph->data.size (); age++)
       {
-        graph->data[i][0] *= scale;
-        graph->data[i][1] *= scale;
+        const double value = rates ? rates->at (j, age) : -1.0;
+
+        graph->data.at (j, age) = value;
+        max_rate = MAX (max_rate, value);
       }
 
-  procman_debug ("rescale dmax = %" G_GUINT64_FORMAT
-                 " max = %" G_GUINT64_FORMAT
-                 " new_max = %" G_GUINT64_FORMAT,
-                 dmax, *max, new_max);
+  load_graph_scale_rates (graph, max_rate);
+  graph->clear_background ();
+}
 
-  *max = new_max;
+void
+load_graph_select_interface (LoadGraph  *graph,
+                             const char *name)
+{
+  if (graph->type != LOAD_GRAPH_NET || !graph->net.netlink || graph->net.selected == name)
+    return;
 
-  // force the graph background to be redrawn now that scale has changed
-  graph->clear_background ();
+  graph->net.selected = name;
+
+  const auto it = graph->net.interfaces.find (graph->net.selected);
+
+  load_graph_show_rates (graph, graph->net.selected.empty () ? &graph->net.total
+                         : it != graph->net.interfaces.end () ? &it->second.rates : NULL);
+  update_interface_names (graph);
 }
 
-static guint64
-get_hash64 (const gchar*c_str)
+void
+load_graph_select_device (LoadGraph  *graph,
+                          const char *name)
 {
-  // Fowler–Noll–Vo FNV-1 64-bit hash:
+  if (graph->type != LOAD_GRAPH_DISK || !graph->disk.diskstats || graph->disk.selected == name)
+    return;
 
-  guint64 hash = 0xcbf29ce484222325L;
+  graph->disk.selected = name;
 
-  while (gchar c = *c_str++)
-    {
-      hash = (hash * 0x00000100000001B3L) ^ c;
-    }
+  const auto it = graph->disk.devices.find (graph->disk.selected);
 
-  return hash;
+  load_graph_show_rates (graph, graph->disk.selected.empty () ? &graph->disk.total
+                         : it != graph->disk.devices.end () ? &it->second.rates : NULL);
+  update_device_names (graph);
 }
+#endif
 
 static void
-handle_dynamic_max_value (LoadGraph             *graph,
-                          std::vector<unsigned> *values,
-                          guint64               *max,
-                          guint64               *last_in,
-                          guint64               *last_out,
-                          guint64                in,
-                          guint64                out,
-                          guint64               *graph_time,
-                          guint64                hash,
-                          guint64               *graph_hash,
-                          gboolean               in_bits,
-                          gboolean               totals_in_bits,
-                          GtkLabel              *label_in,
-                          GtkLabel              *label_out,
-                          GtkLabel              *label_in_total,
-                          GtkLabel              *label_out_total)
+load_graph_set_zoom (LoadGraph *graph,
+                     guint      zoom)
 {
-  guint64 time = g_get_monotonic_time ();
-  guint64 din, dout;
+  if (zoom == graph->zoom)
+    return;
 
-  if (in >= *last_in && out >= *last_out &&
-      (graph_hash == NULL || hash == *graph_hash) &&
-      *graph_time != 0)
-    {
-      float dtime = ((double) (time - *graph_time)) / G_USEC_PER_SEC;
-      din = static_cast<guint64>((in - *last_in) / dtime);
-      dout = static_cast<guint64>((out - *last_out) / dtime);
-    }
-  else
-    {
-      /* Don't calc anything if new data is less than old (interface
-         removed, counters reset, ...) or if it is the first time */
-      din = 0;
-      dout = 0;
-    }
+  graph->zoom = zoom;
+  graph->clear_background ();
+  gtk_widget_queue_draw (GTK_WIDGET (graph->disp));
 
-  *last_in = in;
-  *last_out = out;
-  *graph_time = time;
-  if (graph_hash != NULL)
-    *graph_hash = hash;
+  procman_debug ("graph %d: zoom %u", graph->type, zoom);
+}
+
+static gboolean
+load_graph_scroll (GtkEventControllerScroll *controller,
+                   double,
+                   double                    dy,
+                   gpointer                  data_ptr)
+{
+  LoadGraph * const graph = static_cast<LoadGraph*>(data_ptr);
+  GdkModifierType state = gtk_event_controller_get_current_event_state (GTK_EVENT_CONTROLLER (controller));
 
-  dynamic_scale (graph, values, max, din, dout, in_bits);
+  /* Plain scrolling scrolls the resources page */
+  if (!(state & GDK_CONTROL_MASK))
+    return FALSE;
 
-  gtk_label_set_text (GTK_LABEL (label_in), procman::format_rate (din, in_bits).c_str ());
-  gtk_label_set_text (GTK_LABEL (label_in_total), procman::format_volume (in, totals_in_bits).c_str ());
+  if (dy > 0 && graph->zoom < graph->archive.n_tiers ())
+    load_graph_set_zoom (graph, graph->zoom + 1);
+  else if (dy < 0 && graph->zoom > 0)
+    load_graph_set_zoom (graph, graph->zoom - 1);
 
-  gtk_label_set_text (GTK_LABEL (label_out), procman::format_rate (dout, in_bits).c_str ());
-  gtk_label_set_text (GTK_LABEL (label_out_total), procman::format_volume (out, totals_in_bits).c_str ());
+  return TRUE;
 }
 
+#ifdef __linux__
 static void
-get_net (LoadGraph *graph)
+cb_net_interface_selected (GtkDropDown *drop_down,
+                           GParamSpec  *,
+                           LoadGraph   *graph)
 {
-  glibtop_netlist netlist;
-  guint32 i;
-  guint64 in = 0, out = 0;
-  guint64 hash = 1;
-  char **ifnames;
+  const guint selected = gtk_drop_down_get_selected (drop_down);
 
-  ifnames = glibtop_get_netlist (&netlist);
+  if (graph->net.updating_names)
+    return;
 
-  for (i = 0; i < netlist.number; ++i)
-    {
-      glibtop_netload netload;
-      glibtop_get_netload (&netload, ifnames[i]);
+  /* Applied by the change of the setting */
+  g_settings_set_string (GsmApplication::get ().settings->gobj (), GSM_SETTING_NETWORK_INTERFACE,
+                         selected == 0 || selected > graph->net.names.size ()
+                         ? "" : graph->net.names[selected - 1].c_str ());
+}
 
-      if (netload.if_flags & (1 << GLIBTOP_IF_FLAGS_LOOPBACK))
-        continue;
+static void
+init_net_interfaces (LoadGraph *graph)
+{
+  g_autoptr (GError) error = NULL;
+  const char *const total[] = { _("All Interfaces"), NULL };
 
-      /* Skip interfaces without any IPv4/IPv6 address (or
-         those with only a LINK ipv6 addr) However we need to
-         be able to exclude these while still keeping the
-         value so when they get online (with NetworkManager
-         for example) we don't get a sudden peak.  Once we're
-         able to get this, ignoring down interfaces will be
-         possible too.  */
-      if (not ((netload.flags & (1 << GLIBTOP_NETLOAD_ADDRESS6))
-               and netload.scope6 != GLIBTOP_IF_IN6_SCOPE_LINK)
-          and not (netload.flags & (1 << GLIBTOP_NETLOAD_ADDRESS)))
-        continue; 
+  graph->net.netlink = gsm_netlink_new (&error);
+  if (!graph->net.netlink)
+    {
+      procman_debug ("no netlink, reading libgtop: %s", error->message);
+      return;
+    }
 
-      /* Don't skip interfaces that are down (GLIBTOP_IF_FLAGS_UP)
-         to avoid spikes when they are brought up */
+  graph->net.links = g_array_new (FALSE, FALSE, sizeof (GsmNetLink));
+
+  graph->labels.net_interfaces = gtk_string_list_new (total);
+  graph->labels.net_interface = GTK_DROP_DOWN (gtk_drop_down_new (G_LIST_MODEL (graph->labels.net_interfaces),
+                                                                  gtk_property_expression_new (GTK_TYPE_STRING_OBJECT,
+                                                                                               NULL, "string")));
+  gtk_drop_down_set_enable_search (graph->labels.net_interface, TRUE);
+  gtk_widget_set_valign (GTK_WIDGET (graph->labels.net_interface), GTK_ALIGN_CENTER);
+  gtk_widget_set_tooltip_text (GTK_WIDGET (graph->labels.net_interface), _("Network interface"));
+  g_signal_connect (graph->labels.net_interface, "notify::selected",
+                    G_CALLBACK (cb_net_interface_selected), graph);
+}
 
-      in += netload.bytes_in;
-      out += netload.bytes_out;
-      hash += get_hash64 (ifnames[i]);
-    }
+static void
+cb_disk_device_selected (GtkDropDown *drop_down,
+                         GParamSpec  *,
+                         LoadGraph   *graph)
+{
+  const guint selected = gtk_drop_down_get_selected (drop_down);
 
-  g_strfreev (ifnames);
+  if (graph->disk.updating_names)
+    return;
 
-  if(graph->iteration != 1) {
-    handle_dynamic_max_value (graph, &graph->net.values, &graph->net.max, &graph->net.last_in,
-                            &graph->net.last_out, in, out, &graph->net.time,
-                            hash, &graph->net.last_hash,
-                            GsmApplication::get ().config.network_in_bits,
-                            GsmApplication::get ().config.network_total_in_bits,
-                            graph->labels.net_in, graph->labels.net_out,
-                            graph->labels.net_in_total, graph->labels.net_out_total);
-  }
+  /* Applied by the change of the setting */
+  g_settings_set_string (GsmApplication::get ().settings->gobj (), GSM_SETTING_DISK_DEVICE,
+                         selected == 0 || selected > graph->disk.names.size ()
+                         ? "" : graph->disk.names[selected - 1].c_str ());
 }
 
 static void
-get_disk (LoadGraph *graph)
+cb_pressure_cgroup_selected (GtkDropDown *drop_down,
+                             GParamSpec  *,
+                             LoadGraph   *graph)
 {
-  glibtop_disk disk;
-  gint32 i;
-  guint64 read = 0, write = 0;
-
-  glibtop_get_disk (&disk);
+  const guint selected = gtk_drop_down_get_selected (drop_down);
 
-  for (i = 0; i < glibtop_global_server->ndisk; i++)
-    {
-      read += disk.xdisk_sectors_read[i];
-      write += disk.xdisk_sectors_write[i];
-    }
+  if (graph->pressure.updating_names)
+    return;
 
-  // These sectors are standard unix 512 byte sectors, not the actual disk sectors.
-  read *= 512;
-  write *= 512;
+  /* Applied by the change of the setting */
+  g_settings_set_string (GsmApplication::get ().settings->gobj (), GSM_SETTING_PRESSURE_CGROUP,
+                         selected == 0 || selected > graph->pressure.names.size ()
+                         ? "" : graph->pressure.names[selected - 1].c_str ());
+}
 
-  if(graph->iteration != 1) {
-    handle_dynamic_max_value (graph, &graph->disk.values, &graph->disk.max, &graph->disk.last_read,
-                            &graph->disk.last_write, read, write, &graph->disk.time, 0, NULL,
-                            FALSE, FALSE, graph->labels.disk_read, graph->labels.disk_write,
-                            graph->labels.disk_read_total, graph->labels.disk_write_total);
-  }
+static void
+init_pressure_cgroups (LoadGraph *graph)
+{
+  const char *const total[] = { _("Whole System"), NULL };
+
+  graph->labels.pressure_cgroups = gtk_string_list_new (total);
+  graph->labels.pressure_cgroup = GTK_DROP_DOWN (gtk_drop_down_new (G_LIST_MODEL (graph->labels.pressure_cgroups),
+                                                                    gtk_property_expression_new (GTK_TYPE_STRING_OBJECT,
+                                                                                                 NULL, "string")));
+  gtk_drop_down_set_enable_search (graph->labels.pressure_cgroup, TRUE);
+  gtk_widget_set_valign (GTK_WIDGET (graph->labels.pressure_cgroup), GTK_ALIGN_CENTER);
+  gtk_widget_set_tooltip_text (GTK_WIDGET (graph->labels.pressure_cgroup), _("Control group"));
+  g_signal_connect (graph->labels.pressure_cgroup, "notify::selected",
+                    G_CALLBACK (cb_pressure_cgroup_selected), graph);
+  update_cgroup_names (graph);
 }
 
-int
-load_graph_update_data (LoadGraph *graph)
+static void
+cb_cpu_times_cpu_selected (GtkDropDown *drop_down,
+                           GParamSpec  *,
+                           LoadGraph   *graph)
 {
-  // Rotate data one element down.
-  std::rotate (graph->data.begin (),
-               graph->data.end () - 1,
-               graph->data.end ());
+  if (graph->cpu_times.updating)
+    return;
 
-  // Update rotation counter.
-  graph->latest = (graph->latest + 1) % graph->num_points;
-  graph->iteration++;
+  /* Applied by the change of the setting */
+  g_settings_set_uint (GsmApplication::get ().settings->gobj (), GSM_SETTING_CPU_TIMES_CPU,
+                       gtk_drop_down_get_selected (drop_down));
+}
 
-  // Replace the 0th element
-  switch (graph->type)
-    {
-      case LOAD_GRAPH_CPU:
-        get_load (graph);
-        break;
+static void
+init_cpu_times (LoadGraph *graph)
+{
+  const guint num_cpus = GsmApplication::get ().config.num_cpus;
+  const char *const total[] = { _("All CPUs"), NULL };
 
-      case LOAD_GRAPH_MEM:
-        get_memory (graph);
-        break;
+  graph->cpu_times.reader = gsm_proc_stat_new ();
+  for (auto &times : graph->cpu_times.times)
+    times = g_array_new (FALSE, TRUE, sizeof (guint64));
+  graph->cpu_times.shares.resize (gsize (num_cpus + 1) * GSM_CPU_N_STATES);
+  /* Before the history, which only has the points of the total */
+  graph->cpu_times.selected = MIN (GsmApplication::get ().config.cpu_times_cpu, num_cpus);
 
-      case LOAD_GRAPH_NET:
-        get_net (graph);
-        break;
+  for (guint i = 0; i < GSM_CPU_IDLE; i++)
+    graph->labels.cpu_times[i] = init_tnum_label (8, GTK_ALIGN_START);
 
-      case LOAD_GRAPH_DISK:
-        get_disk (graph);
-        break;
+  graph->labels.cpu_times_cpus = gtk_string_list_new (total);
+  for (guint i = 0; i < num_cpus; i++)
+    {
+      g_autofree gchar *name = g_strdup_printf (_("CPU%d"), i + 1);
 
-      default:
-        g_assert_not_reached ();
+      gtk_string_list_append (graph->labels.cpu_times_cpus, name);
     }
-  return 0;
+
+  graph->labels.cpu_times_cpu = GTK_DROP_DOWN (gtk_drop_down_new (G_LIST_MODEL (graph->labels.cpu_times_cpus),
+                                                                  gtk_property_expression_new (GTK_TYPE_STRING_OBJECT,
+                                                                                               NULL, "string")));
+  gtk_drop_down_set_enable_search (graph->labels.cpu_times_cpu, TRUE);
+  gtk_widget_set_valign (GTK_WIDGET (graph->labels.cpu_times_cpu), GTK_ALIGN_CENTER);
+  gtk_widget_set_tooltip_text (GTK_WIDGET (graph->labels.cpu_times_cpu), _("CPU"));
+  g_signal_connect (graph->labels.cpu_times_cpu, "notify::selected",
+                    G_CALLBACK (cb_cpu_times_cpu_selected), graph);
 }
 
 static void
-load_graph_destroy (GtkWidget*,
-                    gpointer data_ptr)
+init_disk_devices (LoadGraph *graph)
 {
-  LoadGraph * const graph = static_cast<LoadGraph*>(data_ptr);
+  g_autoptr (GError) error = NULL;
+  const char *const total[] = { _("All Disks"), NULL };
 
-  delete graph;
+  graph->disk.diskstats = gsm_diskstats_new ();
+  graph->disk.stats = g_array_new (FALSE, FALSE, sizeof (GsmDiskStat));
+
+  /* Tried once, and read every time from then on */
+  if (!gsm_diskstats_read (graph->disk.diskstats, graph->disk.stats, &error))
+    {
+      procman_debug ("no diskstats, reading libgtop: %s", error->message);
+      g_clear_pointer (&graph->disk.diskstats, gsm_diskstats_free);
+      g_clear_pointer (&graph->disk.stats, g_array_unref);
+      return;
+    }
+
+  graph->labels.disk_details = init_tnum_label (24, GTK_ALIGN_START);
+  graph->labels.disk_devices = gtk_string_list_new (total);
+  graph->labels.disk_device = GTK_DROP_DOWN (gtk_drop_down_new (G_LIST_MODEL (graph->labels.disk_devices),
+                                                                gtk_property_expression_new (GTK_TYPE_STRING_OBJECT,
+                                                                                             NULL, "string")));
+  gtk_drop_down_set_enable_search (graph->labels.disk_device, TRUE);
+  gtk_widget_set_valign (GTK_WIDGET (graph->labels.disk_device), GTK_ALIGN_CENTER);
+  gtk_widget_set_tooltip_text (GTK_WIDGET (graph->labels.disk_device), _("Disk"));
+  g_signal_connect (graph->labels.disk_device, "notify::selected",
+                    G_CALLBACK (cb_disk_device_selected), graph);
 }
+#endif
 
 LoadGraph::LoadGraph(guint type)
   :
@@ -956,13 +2652,32 @@ LoadGraph::LoadGraph(guint type)
   type (type),
   speed (GsmApplication::get ().config.graph_update_interval),
   num_points (GsmApplication::get ().config.graph_data_points + 2),
-  latest (0),
   graph_dely (0),
   num_bars (0),
   real_draw_height (0),
   colors (),
-  data_block (),
   data (),
+  lines (NULL),
+  lines_latest (0),
+  lines_points (0),
+  lines_step (0.0),
+  lines_height (0),
+  buckets (),
+  heatmap (NULL),
+  heatmap_latest (0),
+  archive (),
+  archive_offset (0),
+  zoom (0),
+  zoomed (NULL),
+  zoomed_bucket (GraphArchive::NO_BUCKET),
+  zoom_max (1.0),
+#ifdef __linux__
+  markers (),
+#endif
+  history (NULL),
+  frame_time (0),
+  n_frames (0),
+  n_repaints (0),
   main_widget (NULL),
   disp (NULL),
   labels (),
@@ -972,6 +2687,10 @@ LoadGraph::LoadGraph(guint type)
   cpu (),
   net (),
   disk ()
+#ifdef __linux__
+  , pressure (),
+  cpu_times ()
+#endif
 {
   font_settings->signal_changed (FONT_SETTING_SCALING).connect ([this](const Glib::ustring&) {
     load_graph_rescale (this);
@@ -983,8 +2702,11 @@ LoadGraph::LoadGraph(guint type)
         cpu = CPU {};
         n = GsmApplication::get ().config.num_cpus;
 
-        for (guint i = 0; i < G_N_ELEMENTS (labels.cpu); ++i)
-          labels.cpu[i] = make_tnum_label ();
+        for (auto &times : cpu.times)
+          for (auto &state : times)
+            state.resize (n);
+        cpu.loads.resize (n);
+        labels.cpu.resize (n);
 
         break;
 
@@ -998,21 +2720,50 @@ LoadGraph::LoadGraph(guint type)
         net = NET {};
         n = 2;
         net.max = 1;
+        net.rounded = { G_MAXUINT64, 0 };
         labels.net_in = init_tnum_label (10, GTK_ALIGN_END);
         labels.net_in_total = init_tnum_label (10, GTK_ALIGN_END);
         labels.net_out = init_tnum_label (10, GTK_ALIGN_END);
         labels.net_out_total = init_tnum_label (10, GTK_ALIGN_END);
+        net.total = GraphHistory (n, num_points);
+#ifdef __linux__
+        init_net_interfaces (this);
+#endif
         break;
 
       case LOAD_GRAPH_DISK:
         disk = DISK {};
         n = 2;
         disk.max = 1;
+        disk.rounded = { G_MAXUINT64, 0 };
         labels.disk_read = init_tnum_label (16, GTK_ALIGN_END);
         labels.disk_read_total = init_tnum_label (16, GTK_ALIGN_END);
         labels.disk_write = init_tnum_label (10, GTK_ALIGN_END);
         labels.disk_write_total = init_tnum_label (10, GTK_ALIGN_END);
+        disk.total = GraphHistory (n, num_points);
+#ifdef __linux__
+        init_disk_devices (this);
+#endif
         break;
+
+#ifdef __linux__
+      case LOAD_GRAPH_PRESSURE:
+        n = GSM_PRESSURE_N_RESOURCES;
+        for (guint i = 0; i < GSM_PRESSURE_N_RESOURCES; i++)
+          {
+            labels.pressure[i] = init_tnum_label (12, GTK_ALIGN_START);
+            labels.pressure_avg[i] = init_tnum_label (16, GTK_ALIGN_START);
+          }
+        open_pressure (this, GsmApplication::get ().config.pressure_cgroup.c_str ());
+        init_pressure_cgroups (this);
+        break;
+
+      case LOAD_GRAPH_CPU_TIMES:
+        cpu_times = CPU_TIMES {};
+        n = GSM_CPU_IDLE;
+        init_cpu_times (this);
+        break;
+#endif
     }
 
   colors.resize (n);
@@ -1025,8 +2776,7 @@ LoadGraph::LoadGraph(guint type)
   switch (type)
     {
       case LOAD_GRAPH_CPU:
-        memcpy (&colors[0], GsmApplication::get ().config.cpu_color,
-                n * sizeof colors[0]);
+        std::copy_n (GsmApplication::get ().config.cpu_color.begin (), n, colors.begin ());
         gsm_graph_set_max_value (disp, 100);
         break;
 
@@ -1041,18 +2791,32 @@ LoadGraph::LoadGraph(guint type)
         break;
 
       case LOAD_GRAPH_NET:
-        net.values = std::vector<unsigned>(num_points);
+        net.values = SlidingMax (num_points);
         colors[0] = GsmApplication::get ().config.net_in_color;
         colors[1] = GsmApplication::get ().config.net_out_color;
         gsm_graph_set_max_value (disp, this->net.max);
         break;
 
       case LOAD_GRAPH_DISK:
-        disk.values = std::vector<unsigned>(num_points);
+        disk.values = SlidingMax (num_points);
         colors[0] = GsmApplication::get ().config.disk_read_color;
         colors[1] = GsmApplication::get ().config.disk_write_color;
         gsm_graph_set_max_value (disp, this->disk.max);
         break;
+
+#ifdef __linux__
+      case LOAD_GRAPH_PRESSURE:
+        colors[GSM_PRESSURE_CPU] = GsmApplication::get ().config.pressure_cpu_color;
+        colors[GSM_PRESSURE_MEMORY] = GsmApplication::get ().config.pressure_memory_color;
+        colors[GSM_PRESSURE_IO] = GsmApplication::get ().config.pressure_io_color;
+        gsm_graph_set_max_value (disp, 100);
+        break;
+
+      case LOAD_GRAPH_CPU_TIMES:
+        std::copy_n (GsmApplication::get ().config.cpu_times_color, n, colors.begin ());
+        gsm_graph_set_max_value (disp, 100);
+        break;
+#endif
     }
 
   main_widget = GTK_BOX (gtk_box_new (GTK_ORIENTATION_VERTICAL, 6));
@@ -1068,18 +2832,59 @@ LoadGraph::LoadGraph(guint type)
                     G_CALLBACK (load_graph_destroy), this);
   gtk_box_prepend (main_widget, GTK_WIDGET (disp));
 
-  data = std::vector<double*>(num_points);
-  /* Allocate data in a contiguous block */
-  data_block = std::vector<double>(n * num_points, -1.0);
+  data = GraphHistory (n, num_points);
+
+  /* 1 s for 10 minutes, 10 s for 6 hours and 1 minute for a week,
+     about 200 kB per series */
+  archive = GraphArchive (type == LOAD_GRAPH_CPU && n > ARCHIVE_MAX_CPUS ? 1 : n,
+                          { { 1, 600 }, { 10, 2160 }, { 60, 10080 } });
+
+  GtkEventController *scroll = gtk_event_controller_scroll_new (GTK_EVENT_CONTROLLER_SCROLL_VERTICAL
+                                                                | GTK_EVENT_CONTROLLER_SCROLL_DISCRETE);
+
+  g_signal_connect (scroll, "scroll", G_CALLBACK (load_graph_scroll), this);
+  gtk_widget_add_controller (GTK_WIDGET (disp), scroll);
+
+  history = open_history (type, n);
+  if (history)
+    load_graph_replay_history (this);
 
-  for (guint i = 0; i < num_points; ++i)
-    data[i] = &data_block[0] + i * n;
+#ifdef __linux__
+  if (type == LOAD_GRAPH_NET)
+    load_graph_select_interface (this, GsmApplication::get ().config.network_interface.c_str ());
+  else if (type == LOAD_GRAPH_DISK)
+    load_graph_select_device (this, GsmApplication::get ().config.disk_device.c_str ());
+  else if (type == LOAD_GRAPH_CPU_TIMES)
+    load_graph_select_cpu (this, GsmApplication::get ().config.cpu_times_cpu);
+#endif
 
 }
 
 LoadGraph::~LoadGraph()
 {
   load_graph_stop (this);
+
+  if (lines)
+    cairo_surface_destroy (lines);
+  if (heatmap)
+    cairo_surface_destroy (heatmap);
+  if (zoomed)
+    cairo_surface_destroy (zoomed);
+
+  gsm_history_file_close (history);
+#ifdef __linux__
+  gsm_netlink_free (net.netlink);
+  if (net.links)
+    g_array_unref (net.links);
+  gsm_diskstats_free (disk.diskstats);
+  gsm_pressure_free (pressure.reader);
+  if (disk.stats)
+    g_array_unref (disk.stats);
+  gsm_proc_stat_free (cpu_times.reader);
+  for (GArray *times : cpu_times.times)
+    if (times)
+      g_array_unref (times);
+#endif
 }
 
 void
@@ -1113,26 +2918,26 @@ load_graph_change_num_points (LoadGraph *graph,
   if (graph->num_points == new_num_points)
     return;
 
-  // Sort the values in the data_block vector in the order they were accessed in by the pointers in data.
-  std::rotate (graph->data_block.begin (),
-               graph->data_block.begin () + (graph->num_points - graph->latest) * graph->n,
-               graph->data_block.end ());
-
-  // Reset rotation counter.
-  graph->latest = 0;
-
-  // Resize the vectors to the new amount of data points.
-  // Fill the new values with -1.
+  // Keep the latest values, the new points are empty.
   graph->data.resize (new_num_points);
-  graph->data_block.resize (graph->n * new_num_points, -1.0);
   if (graph->type == LOAD_GRAPH_NET)
-    graph->net.values.resize (new_num_points);
+    {
+      graph->net.values.resize (new_num_points);
+      graph->net.total.resize (new_num_points);
+#ifdef __linux__
+      for (auto &entry : graph->net.interfaces)
+        entry.second.rates.resize (new_num_points);
+#endif
+    }
   else if (graph->type == LOAD_GRAPH_DISK)
-    graph->disk.values.resize (new_num_points);
-
-  // Replace the pointers in data, to match the new data_block values.
-  for (guint i = 0; i < new_num_points; ++i)
-    graph->data[i] = &graph->data_block[0] + i * graph->n;
+    {
+      graph->disk.values.resize (new_num_points);
+      graph->disk.total.resize (new_num_points);
+#ifdef __linux__
+      for (auto &entry : graph->disk.devices)
+        entry.second.rates.resize (new_num_points);
+#endif
+    }
 
   // Set the actual number of data points to be used by the graph.
   graph->num_points = new_num_points;
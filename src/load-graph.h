@@ -4,17 +4,37 @@
 #include <glib.h>
 #include <glibtop/cpu.h>
 
+#include <array>
+#include <deque>
+#include <map>
+#include <string>
+#include <unordered_map>
+
+#include "graph-archive.h"
+#include "graph-history.h"
+#include "gsm-cpu-legend.h"
 #include "gsm-graph.h"
+#include "gsm-history-file.h"
 #include "legacy/gsm_color_button.h"
+#include "sliding-max.h"
 #include "util.h"
 #include "settings-keys.h"
 
+#ifdef __linux__
+#include "gsm-diskstats.h"
+#include "gsm-netlink.h"
+#include "gsm-pressure.h"
+#include "gsm-procstat.h"
+#endif
+
 enum
 {
   LOAD_GRAPH_CPU,
   LOAD_GRAPH_MEM,
   LOAD_GRAPH_NET,
-  LOAD_GRAPH_DISK
+  LOAD_GRAPH_DISK,
+  LOAD_GRAPH_PRESSURE,
+  LOAD_GRAPH_CPU_TIMES
 };
 
 enum
@@ -26,18 +46,84 @@ enum
 
 struct LoadGraphLabels
 {
-  GtkLabel *cpu[GLIBTOP_NCPU];
+  /* Either a label per CPU or the legend of all of them */
+  std::vector<GtkLabel *> cpu;
+  GsmCpuLegend *cpu_legend;
   GtkLabel *memory;
   GtkLabel *swap;
   GtkLabel *net_in;
   GtkLabel *net_in_total;
   GtkLabel *net_out;
   GtkLabel *net_out_total;
+  /* Interface shown by the network graph, with netlink only */
+  GtkDropDown *net_interface;
+  GtkStringList *net_interfaces;
   GtkLabel *disk_read;
   GtkLabel *disk_read_total;
   GtkLabel *disk_write;
   GtkLabel *disk_write_total;
+  /* Device shown by the disk graph and its requests, with diskstats only */
+  GtkDropDown *disk_device;
+  GtkStringList *disk_devices;
+  GtkLabel *disk_details;
+#ifdef __linux__
+  /* Stall rates, and their averages over 10 s, 1 and 5 minutes */
+  GtkLabel *pressure[GSM_PRESSURE_N_RESOURCES];
+  GtkLabel *pressure_avg[GSM_PRESSURE_N_RESOURCES];
+  /* Cgroup shown by the pressure graph */
+  GtkDropDown *pressure_cgroup;
+  GtkStringList *pressure_cgroups;
+  /* Share of each busy state of the CPU shown by the CPU times graph */
+  GtkLabel *cpu_times[GSM_CPU_IDLE];
+  GtkDropDown *cpu_times_cpu;
+  GtkStringList *cpu_times_cpus;
+#endif
+  /* Keys of the values the labels show, see label_needs_update () */
+  std::unordered_map<GtkLabel *, std::array<guint64, 4>> shown;
+};
+
+#ifdef __linux__
+/* A stall reported by a pressure trigger, drawn over the graph at the
+   point sampled after it */
+struct StallMarker
+{
+  guint64 index;
+  GsmPressureResource resource;
+};
+#endif
+
+/* What the scale of a network or disk graph was last rounded from, to
+   round it again only when it changes, see dynamic_scale () */
+struct RoundedScale
+{
+  guint64 max;
+  guint bars;
+};
+
+#ifdef __linux__
+/* Counters and rates of a network interface of the netlink dumps */
+struct NetInterface
+{
+  GsmNetLinkFlags flags;
+  guint64 last_in, last_out;
+  /* Number of the latest dump having the interface */
+  guint64 seen;
+  /* Bytes per second received and sent, point by point like the graph */
+  GraphHistory rates;
+};
+
+/* Counters and rates of a block device of /proc/diskstats */
+struct DiskDevice
+{
+  GsmDiskStat last;
+  /* Number of the latest read having the device */
+  guint64 seen;
+  /* Bytes per second read and written, point by point like the graph */
+  GraphHistory rates;
+  /* Of the latest read, for the labels */
+  GsmDiskRates latest;
 };
+#endif
 
 struct LoadGraph
   : private procman::NonCopyable
@@ -57,7 +143,6 @@ struct LoadGraph
   gint type;
   guint speed;
   guint num_points;
-  guint latest;
   gulong iteration;
   guint graph_dely;
   guint num_bars;
@@ -65,8 +150,40 @@ struct LoadGraph
 
   std::vector<GdkRGBA> colors;
 
-  std::vector<double> data_block;
-  std::vector<double*> data;
+  GraphHistory data;
+
+  /* Lines already drawn, kept from frame to frame, see load_graph_draw () */
+  cairo_surface_t *lines;
+  guint64 lines_latest;
+  guint lines_points;
+  double lines_step;
+  int lines_height;
+  GraphBuckets buckets;
+
+  /* CPU heatmap, a pixel per CPU and point, kept like the lines */
+  cairo_surface_t *heatmap;
+  guint64 heatmap_latest;
+
+  /* Coarser history of the raw values, shown zoomed out, see
+     draw_zoomed () */
+  GraphArchive archive;
+  gint64 archive_offset;   /* added to the monotonic times of the archive */
+  guint zoom;              /* 0 for the points, else the archive tier + 1 */
+  cairo_surface_t *zoomed;
+  gint64 zoomed_bucket;
+  double zoom_max;
+
+#ifdef __linux__
+  /* Oldest first, dropped once out of the points */
+  std::deque<StallMarker> markers;
+#endif
+
+  /* Raw values of the points, kept across restarts */
+  GsmHistoryFile *history;
+
+  gint64 frame_time;
+  guint n_frames;
+  guint n_repaints;
 
   GtkBox *main_widget;
   GsmGraph *disp;
@@ -82,8 +199,9 @@ struct LoadGraph
   {
     guint now;     /* 0 -> current, 1 -> last
                       now ^ 1 each time */
-    /* times[now], times[now ^ 1] is last */
-    guint64 times[2][GLIBTOP_NCPU][N_CPU_STATES];
+    /* times[now], times[now ^ 1] is last, an array of n CPUs per state */
+    std::vector<guint64> times[2][N_CPU_STATES];
+    std::vector<float> loads;
   } cpu;
 
   struct NET
@@ -92,7 +210,24 @@ struct LoadGraph
     guint64 last_hash;
     guint64 time;
     guint64 max;
-    std::vector<unsigned> values;
+    /* Greatest of the rates in and out of the points */
+    SlidingMax values;
+    RoundedScale rounded;
+
+#ifdef __linux__
+    /* NULL without netlink, libgtop is read instead */
+    GsmNetlink *netlink;
+    GArray *links;
+    guint64 dumps;
+    std::map<std::string, NetInterface> interfaces;
+#endif
+    /* Rates summed over the physical interfaces */
+    GraphHistory total;
+    /* Empty for the total */
+    std::string selected;
+    /* Listed after the total in labels.net_interfaces */
+    std::vector<std::string> names;
+    bool updating_names;
   } net;
 
   struct DISK
@@ -100,8 +235,54 @@ struct LoadGraph
     guint64 last_read, last_write;
     guint64 time;
     guint64 max;
-    std::vector<unsigned> values;
+    /* Greatest of the rates in and out of the points */
+    SlidingMax values;
+    RoundedScale rounded;
+
+#ifdef __linux__
+    /* NULL without /proc/diskstats, libgtop is read instead */
+    GsmDiskstats *diskstats;
+    GArray *stats;
+    guint64 reads;
+    std::map<std::string, DiskDevice> devices;
+#endif
+    /* Rates summed over the whole disks */
+    GraphHistory total;
+    /* Empty for the total */
+    std::string selected;
+    /* Listed after the total in labels.disk_devices */
+    std::vector<std::string> names;
+    bool updating_names;
   } disk;
+
+#ifdef __linux__
+  struct PRESSURE
+  {
+    /* NULL without pressure stall information */
+    GsmPressure *reader;
+    GsmPressureStat last[GSM_PRESSURE_N_RESOURCES];
+    gint64 time;
+    /* Empty for the whole system */
+    std::string cgroup;
+    /* Listed after the whole system in labels.pressure_cgroups */
+    std::vector<std::string> names;
+    bool updating_names;
+  } pressure;
+
+  struct CPU_TIMES
+  {
+    /* NULL without /proc/stat */
+    GsmProcStat *reader;
+    /* times[now], times[now ^ 1] is last, rows of guint64 as read */
+    GArray *times[2];
+    guint now;
+    /* Shares of the rows of times, for all of them at once */
+    std::vector<float> shares;
+    /* Row shown, 0 for the total */
+    guint selected;
+    bool updating;
+  } cpu_times;
+#endif
   /* }; */
 };
 
@@ -130,6 +311,37 @@ void
 load_graph_change_num_points (LoadGraph *g,
                               guint      new_num_points);
 
+#ifdef __linux__
+/* Show the traffic of the interface @name, or of all the physical
+   interfaces if empty */
+void
+load_graph_select_interface (LoadGraph  *g,
+                             const char *name);
+
+/* Show the throughput of the block device @name, or of all the whole
+   disks if empty */
+void
+load_graph_select_device (LoadGraph  *g,
+                          const char *name);
+
+/* Show the pressure of the cgroup at @path below /sys/fs/cgroup, or of
+   the system if empty */
+void
+load_graph_set_pressure_cgroup (LoadGraph  *g,
+                                const char *path);
+
+/* Show the CPU times of CPU @cpu, counted from 1, or of all of them
+   if 0 */
+void
+load_graph_select_cpu (LoadGraph *g,
+                       guint      cpu);
+
+/* Mark a stall of @resource at the next point */
+void
+load_graph_add_marker (LoadGraph           *g,
+                       GsmPressureResource  resource);
+#endif
+
 /* Clear the history data. */
 void
 load_graph_reset (LoadGraph *g);
@@ -18,6 +18,7 @@
 
 #include <map>
 
+#include "gsm-sampler.h"
 #include "mem-map.h"
 #include "procinfo.h"
 
@@ -56,7 +57,7 @@ gsm_memmaps_view_dispose (GObject *object)
 {
   GsmMemMapsView *self = GSM_MEMMAPS_VIEW (object);
 
-  g_clear_handle_id (&self->timer, g_source_remove);
+  g_clear_handle_id (&self->timer, gsm_sampler_remove);
   g_clear_pointer (&self->devices, g_hash_table_unref);
 
   G_OBJECT_CLASS (gsm_memmaps_view_parent_class)->dispose (object);
@@ -350,8 +351,7 @@ gsm_memmaps_view_constructed (GObject *object)
   adw_window_title_set_subtitle (self->window_title, subtitle);
   g_free (subtitle);
 
-  self->timer = g_timeout_add_seconds (5, memmaps_timer, self);
-  g_source_set_name_by_id (self->timer, "refresh memmaps");
+  self->timer = gsm_sampler_add (5000, memmaps_timer, self);
   update_memmaps_dialog (self);
 
   G_OBJECT_CLASS (gsm_memmaps_view_parent_class)->constructed (object);
@@ -8,6 +8,7 @@
 
 #include <glibtop/procopenfiles.h>
 
+#include "gsm-sampler.h"
 #include "open-file.h"
 #include "procinfo.h"
 
@@ -45,7 +46,7 @@ gsm_open_files_dispose (GObject *object)
   GsmOpenFiles *self = GSM_OPEN_FILES (object);
 
   g_clear_pointer (&self->known_files, g_hash_table_unref);
-  g_clear_handle_id (&self->timer, g_source_remove);
+  g_clear_handle_id (&self->timer, gsm_sampler_remove);
 
   G_OBJECT_CLASS (gsm_open_files_parent_class)->dispose (object);
 }
@@ -237,8 +238,7 @@ gsm_open_files_init (GsmOpenFiles *self)
 
   gtk_widget_init_template (GTK_WIDGET (self));
 
-  self->timer = g_timeout_add_seconds (5, openfiles_timer, self);
-  g_source_set_name_by_id (self->timer, "refresh openfiles");
+  self->timer = gsm_sampler_add (5000, openfiles_timer, self);
 }
 
 
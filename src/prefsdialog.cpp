@@ -246,6 +246,21 @@ create_preferences_dialog (GsmApplication *app)
                    draw_stacked_switch, "active",
                    G_SETTINGS_BIND_DEFAULT);
 
+  AdwSwitchRow *draw_heatmap_switch = ADW_SWITCH_ROW (gtk_builder_get_object (builder, "draw_heatmap_switch"));
+
+  g_settings_bind (app->settings->gobj (), GSM_SETTING_DRAW_HEATMAP,
+                   draw_heatmap_switch, "active",
+                   G_SETTINGS_BIND_DEFAULT);
+
+  AdwSwitchRow *cpu_times_switch = ADW_SWITCH_ROW (gtk_builder_get_object (builder, "cpu_times_switch"));
+
+  g_settings_bind (app->settings->gobj (), GSM_SETTING_SHOW_CPU_TIMES,
+                   cpu_times_switch, "active",
+                   G_SETTINGS_BIND_DEFAULT);
+#ifndef __linux__
+  gtk_widget_set_visible (GTK_WIDGET (cpu_times_switch), FALSE);
+#endif
+
   AdwSwitchRow *draw_smooth_switch = ADW_SWITCH_ROW (gtk_builder_get_object (builder, "draw_smooth_switch"));
 
   g_settings_bind (app->settings->gobj (), GSM_SETTING_DRAW_SMOOTH,
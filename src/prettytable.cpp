@@ -8,24 +8,106 @@
 #include <gdkmm/pixbuf.h>
 #include <giomm/error.h>
 #include <giomm/file.h>
+#include <gio/gdesktopappinfo.h>
 #include <glibmm/miscutils.h>
 
+#include <algorithm>
 #include <iostream>
 #include <vector>
 
 #include "prettytable.h"
+#include "application.h"
 #include "defaulttable.h"
 #include "procinfo.h"
 #include "proctable.h"
 #include "util.h"
 
 const unsigned APP_ICON_SIZE = 16;
+// GtkCellRendererPixbuf draws textures at their own size
+const unsigned APP_ICON_SCALE = 1;
+
+namespace
+{
+// "app/org.gnome.Foo-1234.scope" -> "org.gnome.Foo"
+string
+flatpak_id_from_cgroup (const string &cgroup_name)
+{
+  string flatpak;
+  size_t last_dash, second_last_dash;
+
+  flatpak = cgroup_name.substr (cgroup_name.find_last_of ('/') + 1);
+  last_dash = flatpak.find_last_of ('-');
+  second_last_dash = flatpak.find_last_of ('-', flatpak.find_last_of ('-') - 1);
+
+  return flatpak.substr (second_last_dash + 1, last_dash - second_last_dash - 1);
+}
+
+// the index keys an icon lookup for @info may go through
+std::vector<string>
+app_keys_for (const ProcInfo &info)
+{
+  std::vector<string> keys;
+
+  keys.push_back ("exec:" + info.name.substr (0, info.name.find (' ')));
+  keys.push_back ("flatpak:" + flatpak_id_from_cgroup (info.cgroup_name));
+  keys.push_back ("wmclass:" + Glib::ustring (info.name).lowercase ());
+
+  return keys;
+}
+
+std::vector<string>
+index_keys_for (const Glib::RefPtr<Gio::AppInfo> &app)
+{
+  std::vector<string> keys;
+  Glib::RefPtr<Gio::DesktopAppInfo> desktop = std::dynamic_pointer_cast<Gio::DesktopAppInfo>(app);
+
+  if (!desktop)
+    return keys;
+
+  const string flatpak = desktop->get_string ("X-Flatpak");
+  const string exec = app->get_executable ();
+  const string executable = exec.empty () ? exec : Glib::path_get_basename (exec);
+  const string wmclass = desktop->get_startup_wm_class ();
+
+  if (!flatpak.empty ())
+    keys.push_back ("flatpak:" + flatpak);
+  else if (!executable.empty () &&
+           executable != "sh" &&
+           executable != "env" &&
+           app->should_show ())
+    keys.push_back ("exec:" + executable);
+
+  if (!wmclass.empty ())
+    keys.push_back ("wmclass:" + Glib::ustring (wmclass).lowercase ());
+
+  return keys;
+}
+
+void
+list_apps_thread (GTask *task,
+                  gpointer,
+                  gpointer,
+                  GCancellable *)
+{
+  // parses every .desktop file of the system
+  g_task_return_pointer (task, g_app_info_get_all (), [](gpointer apps) {
+    g_list_free_full (static_cast<GList *>(apps), g_object_unref);
+  });
+}
+}
+
 
 PrettyTable::PrettyTable()
+  : cancellable (g_cancellable_new ()),
+  hits (0),
+  misses (0),
+  app_index_cancellable (g_cancellable_new ()),
+  app_index_ready (false)
 {
-  // init GIO apps cache
   std::vector<std::string> dirs = Glib::get_system_data_dirs ();
 
+  dirs.insert (dirs.begin (), Glib::get_user_data_dir ());
+
   for (std::vector<std::string>::iterator it = dirs.begin (); it != dirs.end (); ++it)
     {
       std::string path = (*it).append ("/applications");
@@ -38,230 +120,300 @@ PrettyTable::PrettyTable()
       monitors[path] = monitor;
     }
 
-  this->init_gio_app_cache ();
+  this->build_app_index ();
 }
 
 
 PrettyTable::~PrettyTable()
 {
+  g_cancellable_cancel (this->cancellable);
+  g_object_unref (this->cancellable);
+  g_cancellable_cancel (this->app_index_cancellable);
+  g_object_unref (this->app_index_cancellable);
+}
+
+/*
+  The initial index is built from all the applications, which are read
+  in a worker thread.  Afterwards, only the desktop ids of the changed
+  .desktop files are looked up again, through the data dirs so that the
+  user's files keep shadowing the system ones.
+*/
+void
+PrettyTable::build_app_index ()
+{
+  GTask *task = g_task_new (NULL, this->app_index_cancellable, app_index_built_cb, this);
+
+  g_task_set_source_tag (task, (gpointer) app_index_built_cb);
+  g_task_run_in_thread (task, list_apps_thread);
+  g_object_unref (task);
 }
 
 void
-PrettyTable::init_gio_app_cache ()
+PrettyTable::app_index_built_cb (GObject      *,
+                                 GAsyncResult *result,
+                                 gpointer      data)
 {
-  this->gio_apps.clear ();
+  GError *error = NULL;
+  GList *apps = static_cast<GList *>(g_task_propagate_pointer (G_TASK (result), &error));
+
+  // the table is gone
+  if (error)
+    {
+      g_error_free (error);
+      return;
+    }
 
-  std::vector<Glib::RefPtr<Gio::AppInfo> > apps = Gio::AppInfo::get_all ();
+  PrettyTable *table = static_cast<PrettyTable *>(data);
+  AppKeys changed;
 
-  for (std::vector<Glib::RefPtr<Gio::AppInfo> >::const_iterator it = apps.begin ();
-       it != apps.end (); ++it)
+  for (GList *l = apps; l; l = l->next)
     {
-      Glib::RefPtr<Gio::AppInfo> app = *it;
-      Glib::RefPtr<Gio::DesktopAppInfo> desktop = std::dynamic_pointer_cast<Gio::DesktopAppInfo>(app);
-      std::string executable = app->get_executable ();
-      std::string flatpak = desktop->get_string ("X-Flatpak");
-      bool visible = app->should_show ();
-
-      if (!flatpak.empty ())
-        this->gio_apps[flatpak] = app;
-      else if (executable != "sh" &&
-               executable != "env" &&
-               visible)
-        this->gio_apps[executable] = app;
+      const char *id = g_app_info_get_id (G_APP_INFO (l->data));
+
+      if (id)
+        table->add_app (id, Glib::wrap (G_APP_INFO (l->data), true), changed);
     }
+
+  g_list_free_full (apps, g_object_unref);
+
+  table->app_index_ready = true;
+
+  // the list may predate these
+  for (const auto &id : table->app_index_dirty)
+    table->update_desktop_file (id, changed);
+  table->app_index_dirty.clear ();
+
+  procman_debug ("Indexed %zu applications under %zu keys",
+                 table->desktop_apps.size (), table->app_index.size ());
+
+  table->refresh_icons (changed);
 }
 
 void
-PrettyTable::file_monitor_event (Glib::RefPtr<Gio::File>,
-                                 Glib::RefPtr<Gio::File>,
-                                 Gio::FileMonitor::Event)
+PrettyTable::add_app (const string                     &id,
+                      const Glib::RefPtr<Gio::AppInfo> &app,
+                      AppKeys                          &changed)
 {
-  this->init_gio_app_cache ();
+  this->remove_app (id, changed);
+
+  DesktopApp &entry = this->desktop_apps[id];
+
+  entry.app = app;
+  entry.keys = index_keys_for (app);
+
+  for (const auto &key : entry.keys)
+    {
+      this->app_index[key].push_back (id);
+      changed.insert (key);
+    }
 }
 
-Glib::RefPtr<Gdk::Texture>
-PrettyTable::get_icon_from_theme (const ProcInfo &info)
+void
+PrettyTable::remove_app (const string &id,
+                         AppKeys      &changed)
 {
-  Glib::RefPtr<Gtk::IconTheme> icon_theme;
-  Glib::RefPtr<Gdk::Texture> icon;
+  auto it = this->desktop_apps.find (id);
 
-  icon_theme = Gtk::IconTheme::get_for_display (Gdk::Display::get_default ());
+  if (it == this->desktop_apps.end ())
+    return;
 
-  if (icon_theme->has_icon (info.name))
+  for (const auto &key : it->second.keys)
     {
-      Glib::RefPtr<Gtk::IconPaintable> icon_paintable;
+      auto ids = this->app_index.find (key);
 
-      // Because g-s-m still uses GtkCellView which does not support GdkPaintable
-      // the easiest way to get GdkPixbuf or GdkTexture is to get the icon, get
-      // the file behind it, make it into a sized GdkPixbuf and turn it into
-      // GdkTexture.
-      // Once g-s-m uses GtkColumnView, GdkPaintable could be used instead.
-      icon_paintable = icon_theme->lookup_icon (
-        info.name,
-        APP_ICON_SIZE,
-        1,
-        Gtk::TextDirection::NONE,
-        Gtk::IconLookupFlags::PRELOAD);
+      if (ids == this->app_index.end ())
+        continue;
+
+      auto &v = ids->second;
 
-      icon = Gdk::Texture::create_for_pixbuf (Gdk::Pixbuf::create_from_file (icon_paintable->get_file ()->get_path (), APP_ICON_SIZE, APP_ICON_SIZE));
+      v.erase (std::remove (v.begin (), v.end (), id), v.end ());
+      if (v.empty ())
+        this->app_index.erase (ids);
+
+      changed.insert (key);
     }
 
-  return icon;
+  this->desktop_apps.erase (it);
 }
 
-bool
-PrettyTable::get_default_icon_name (const string &cmd,
-                                    string &      name)
+void
+PrettyTable::update_desktop_file (const string &id,
+                                  AppKeys      &changed)
 {
-  for (size_t i = 0; i != G_N_ELEMENTS (default_table); ++i)
-    if (default_table[i].command->match (cmd.c_str ()))
-      {
-        name = default_table[i].icon;
-        return true;
-      }
+  // whichever file now has the id, NULL if none or if it is Hidden
+  GDesktopAppInfo *desktop = g_desktop_app_info_new (id.c_str ());
 
-  return false;
+  if (desktop)
+    this->add_app (id, Glib::wrap (G_APP_INFO (desktop)), changed);
+  else
+    this->remove_app (id, changed);
 }
 
-/*
-  Try to get an icon from the default_table
-  If it's not in defaults, try to load it.
-  If there is no default for a command, store NULL in defaults
-  so we don't have to lookup again.
-*/
-Glib::RefPtr<Gdk::Texture>
-PrettyTable::get_icon_from_default (const ProcInfo &info)
+Glib::RefPtr<Gio::AppInfo>
+PrettyTable::find_app (const string &key) const
 {
-  Glib::RefPtr<Gtk::IconTheme> icon_theme;
-  Glib::RefPtr<Gdk::Texture> icon;
-  string name;
-
-  if (!this->get_default_icon_name (info.name, name))
-    return icon;
+  auto ids = this->app_index.find (key);
 
-  IconCache::iterator it (this->defaults.find (name));
-  if (it == this->defaults.end ())
-    {
-      Glib::RefPtr<Gtk::IconPaintable> icon_paintable;
+  if (ids == this->app_index.end ())
+    return Glib::RefPtr<Gio::AppInfo>();
 
-      icon_theme = Gtk::IconTheme::get_for_display (Gdk::Display::get_default ());
+  return this->desktop_apps.at (ids->second.back ()).app;
+}
 
-      if (!icon_theme->has_icon (name))
-        return icon;
+// looks up again the icons that may come from one of the @changed keys
+void
+PrettyTable::refresh_icons (const AppKeys &changed)
+{
+  if (changed.empty ())
+    return;
 
-      // Because g-s-m still uses GtkCellView which does not support GdkPaintable
-      // the easiest way to get GdkPixbuf or GdkTexture is to get the icon, get
-      // the file behind it, make it into a sized GdkPixbuf and turn it into
-      // GdkTexture.
-      // Once g-s-m uses GtkColumnView, GdkPaintable could be used instead.
-      icon_paintable = icon_theme->lookup_icon (
-        name,
-        APP_ICON_SIZE,
-        1,
-        Gtk::TextDirection::NONE,
-        Gtk::IconLookupFlags::PRELOAD);
+  for (auto &v : GsmApplication::get ().processes)
+    for (const auto &key : app_keys_for (v.second))
+      if (changed.count (key))
+        {
+          this->set_icon (v.second);
+          break;
+        }
+}
 
-      icon = Gdk::Texture::create_for_pixbuf (Gdk::Pixbuf::create_from_file (icon_paintable->get_file ()->get_path (), APP_ICON_SIZE, APP_ICON_SIZE));
+void
+PrettyTable::file_monitor_event (Glib::RefPtr<Gio::File> file,
+                                 Glib::RefPtr<Gio::File> other_file,
+                                 Gio::FileMonitor::Event event)
+{
+  AppKeys changed;
+  std::vector<Glib::RefPtr<Gio::File> > files;
 
-      this->defaults[name] = icon;
+  switch (event)
+    {
+      case Gio::FileMonitor::Event::CREATED:
+      case Gio::FileMonitor::Event::CHANGES_DONE_HINT:
+      case Gio::FileMonitor::Event::DELETED:
+      case Gio::FileMonitor::Event::MOVED_IN:
+      case Gio::FileMonitor::Event::MOVED_OUT:
+        files.push_back (file);
+        break;
+
+      case Gio::FileMonitor::Event::RENAMED:
+      case Gio::FileMonitor::Event::MOVED:
+        files.push_back (file);
+        if (other_file)
+          files.push_back (other_file);
+        break;
+
+      default:
+        // CHANGED is followed by CHANGES_DONE_HINT
+        return;
     }
-  else
+
+  for (const auto &f : files)
     {
-      icon = it->second;
+      string id;
+
+      // "applications/kde/foo.desktop" has the id "kde-foo.desktop"
+      for (const auto &v : this->monitors)
+        {
+          id = Gio::File::create_for_path (v.first)->get_relative_path (f);
+          if (!id.empty ())
+            break;
+        }
+
+      if (!g_str_has_suffix (id.c_str (), ".desktop"))
+        continue;
+
+      std::replace (id.begin (), id.end (), '/', '-');
+
+      if (this->app_index_ready)
+        this->update_desktop_file (id, changed);
+      else
+        this->app_index_dirty.insert (id);
     }
 
-  return icon;
+  this->refresh_icons (changed);
 }
 
-Glib::RefPtr<Gdk::Texture>
-PrettyTable::get_icon_from_gio (const ProcInfo &info)
+Glib::RefPtr<Gio::Icon>
+PrettyTable::get_icon_from_theme (const ProcInfo &info)
 {
-  Glib::RefPtr<Gdk::Texture> icon;
-  Glib::RefPtr<Gio::Icon> gicon;
   Glib::RefPtr<Gtk::IconTheme> icon_theme;
-  Glib::RefPtr<Gtk::IconPaintable> icon_paintable;
-  const auto executable = info.name.substr (0, info.name.find (' '));
+  Glib::RefPtr<Gio::Icon> icon;
 
-  Glib::RefPtr<Gio::AppInfo> app = this->gio_apps[executable];
+  icon_theme = Gtk::IconTheme::get_for_display (Gdk::Display::get_default ());
 
-  if (!app)
-    {
-      std::string flatpak;
-      size_t last_dash, second_last_dash;
+  if (icon_theme->has_icon (info.name))
+    icon = Gio::ThemedIcon::create (info.name);
+
+  return icon;
+}
 
-      // Extract flatpak id from cgroup_name
-      flatpak = info.cgroup_name.c_str ();
-      flatpak = flatpak.substr (flatpak.find_last_of ('/') + 1);
-      last_dash = flatpak.find_last_of ('-');
-      second_last_dash = flatpak.find_last_of ('-', flatpak.find_last_of ('-') - 1);
-      flatpak = flatpak.substr (second_last_dash + 1, last_dash - second_last_dash - 1);
+bool
+PrettyTable::get_default_icon_name (const string &cmd,
+                                    string &      name)
+{
+  static DefaultTableMatcher matcher;
+  const PrettyTableItem *item = matcher.match (cmd);
 
-      app = this->gio_apps[flatpak];
+  if (item)
+    name = item->icon;
 
-      if (!app)
-        return icon;
-    }
+  return item != nullptr;
+}
 
-  gicon = app->get_icon ();
-  if (!gicon)
+Glib::RefPtr<Gio::Icon>
+PrettyTable::get_icon_from_default (const ProcInfo &info)
+{
+  Glib::RefPtr<Gtk::IconTheme> icon_theme;
+  Glib::RefPtr<Gio::Icon> icon;
+  string name;
+
+  if (!this->get_default_icon_name (info.name, name))
     return icon;
 
   icon_theme = Gtk::IconTheme::get_for_display (Gdk::Display::get_default ());
 
-  icon_paintable = icon_theme->lookup_icon (
-    gicon,
-    APP_ICON_SIZE,
-    1,
-    Gtk::TextDirection::NONE,
-    Gtk::IconLookupFlags::PRELOAD);
+  if (icon_theme->has_icon (name))
+    icon = Gio::ThemedIcon::create (name);
+
+  return icon;
+}
+
+Glib::RefPtr<Gio::Icon>
+PrettyTable::get_icon_from_gio (const ProcInfo &info)
+{
+  Glib::RefPtr<Gio::Icon> icon;
+  Glib::RefPtr<Gio::AppInfo> app;
 
-  std::string path = icon_paintable->get_file ()->get_path ();
-  icon = Gdk::Texture::create_for_pixbuf (Gdk::Pixbuf::create_from_file (path, APP_ICON_SIZE, APP_ICON_SIZE));
+  for (const auto &key : app_keys_for (info))
+    if ((app = this->find_app (key)))
+      break;
+
+  if (app)
+    icon = app->get_icon ();
 
   return icon;
 }
 
-Glib::RefPtr<Gdk::Texture>
+Glib::RefPtr<Gio::Icon>
 PrettyTable::get_icon_from_name (const ProcInfo &info)
 {
   Glib::RefPtr<Gtk::IconTheme> icon_theme;
-  Glib::RefPtr<Gtk::IconPaintable> icon_paintable;
-  Glib::RefPtr<Gdk::Texture> icon;
+  Glib::RefPtr<Gio::Icon> icon;
 
   icon_theme = Gtk::IconTheme::get_for_display (Gdk::Display::get_default ());
 
   if (!icon_theme->has_icon (info.name))
     return icon;
 
-  icon_paintable = icon_theme->lookup_icon (
-    info.name,
-    APP_ICON_SIZE,
-    1,
-    Gtk::TextDirection::NONE,
-    Gtk::IconLookupFlags::PRELOAD);
-  icon = Gdk::Texture::create_for_pixbuf (Gdk::Pixbuf::create_from_file (icon_paintable->get_file ()->get_path (), APP_ICON_SIZE, APP_ICON_SIZE));
+  icon = Gio::ThemedIcon::create (info.name);
 
   return icon;
 }
 
 
-Glib::RefPtr<Gdk::Texture>
+Glib::RefPtr<Gio::Icon>
 PrettyTable::get_icon_dummy (const ProcInfo &)
 {
-  Glib::RefPtr<Gtk::IconTheme> icon_theme;
-  Glib::RefPtr<Gtk::IconPaintable> icon_paintable;
-  Glib::RefPtr<Gdk::Texture> icon;
-
-  icon_theme = Gtk::IconTheme::get_for_display (Gdk::Display::get_default ());
-  icon_paintable = icon_theme->lookup_icon (
-    "application-x-executable",
-    APP_ICON_SIZE,
-    1,
-    Gtk::TextDirection::NONE,
-    Gtk::IconLookupFlags::PRELOAD);
-  icon = Gdk::Texture::create_for_pixbuf (Gdk::Pixbuf::create_from_file (icon_paintable->get_file ()->get_path (), APP_ICON_SIZE, APP_ICON_SIZE));
-
-  return icon;
+  return Gio::ThemedIcon::create ("application-x-executable");
 }
 
 namespace
@@ -284,32 +436,207 @@ is_kthread (const ProcInfo &info)
 }
 }
 
-Glib::RefPtr<Gdk::Texture>
+Glib::RefPtr<Gio::Icon>
 PrettyTable::get_icon_for_kernel (const ProcInfo &info)
 {
-  Glib::RefPtr<Gdk::Texture> icon;
-  Glib::RefPtr<Gtk::IconTheme> icon_theme;
-  Glib::RefPtr<Gtk::IconPaintable> icon_paintable;
+  Glib::RefPtr<Gio::Icon> icon;
 
   if (!is_kthread (info))
     return icon;
 
+  icon = Gio::ThemedIcon::create ("application-x-executable");
+
+  return icon;
+}
+
+/*
+  Decodes the icon file at its final size.  Runs in a worker thread:
+  only GIO and GdkPixbuf are used here, the icon theme lookup has been
+  done beforehand in the main thread.
+*/
+static void
+load_icon_thread (GTask        *task,
+                  gpointer,
+                  gpointer      task_data,
+                  GCancellable *cancellable)
+{
+  GFile *file = G_FILE (task_data);
+  GError *error = NULL;
+  GdkPixbuf *pixbuf = NULL;
+  GFileInputStream *stream = g_file_read (file, cancellable, &error);
+
+  if (stream)
+    {
+      pixbuf = gdk_pixbuf_new_from_stream_at_scale (G_INPUT_STREAM (stream),
+                                                    APP_ICON_SIZE * APP_ICON_SCALE,
+                                                    APP_ICON_SIZE * APP_ICON_SCALE,
+                                                    TRUE, cancellable, &error);
+      g_object_unref (stream);
+    }
+
+  if (pixbuf)
+    g_task_return_pointer (task, pixbuf, g_object_unref);
+  else
+    g_task_return_error (task, error);
+}
+
+struct IconLoad
+{
+  PrettyTable *table;
+  std::string key;
+};
+
+void
+PrettyTable::load_icon (const string                  &key,
+                        const Glib::RefPtr<Gio::Icon> &gicon)
+{
+  Glib::RefPtr<Gtk::IconTheme> icon_theme;
+  Glib::RefPtr<Gtk::IconPaintable> icon_paintable;
+  Glib::RefPtr<Gio::File> file;
+
+  // Because g-s-m still uses GtkCellView which does not support GdkPaintable
+  // the easiest way to get GdkPixbuf or GdkTexture is to get the icon, get
+  // the file behind it, make it into a sized GdkPixbuf and turn it into
+  // GdkTexture.
+  // Once g-s-m uses GtkColumnView, GdkPaintable could be used instead.
   icon_theme = Gtk::IconTheme::get_for_display (Gdk::Display::get_default ());
   icon_paintable = icon_theme->lookup_icon (
-    "application-x-executable",
+    gicon,
     APP_ICON_SIZE,
-    1,
+    APP_ICON_SCALE,
     Gtk::TextDirection::NONE,
-    Gtk::IconLookupFlags::PRELOAD);
-  icon = Gdk::Texture::create_for_pixbuf (Gdk::Pixbuf::create_from_file (icon_paintable->get_file ()->get_path (), APP_ICON_SIZE, APP_ICON_SIZE));
+    Gtk::IconLookupFlags (0));
 
-  return icon;
+  if (icon_paintable)
+    file = icon_paintable->get_file ();
+
+  if (!file)
+    {
+      this->icon_loaded (key, this->get_placeholder ());
+      return;
+    }
+
+  GTask *task = g_task_new (NULL, this->cancellable, icon_loaded_cb, new IconLoad { this, key });
+
+  g_task_set_source_tag (task, (gpointer) icon_loaded_cb);
+  g_task_set_task_data (task, g_object_ref (file->gobj ()), g_object_unref);
+  g_task_run_in_thread (task, load_icon_thread);
+  g_object_unref (task);
+}
+
+void
+PrettyTable::icon_loaded_cb (GObject      *,
+                             GAsyncResult *result,
+                             gpointer      data)
+{
+  IconLoad *load = static_cast<IconLoad *>(data);
+  GError *error = NULL;
+  GdkPixbuf *pixbuf = static_cast<GdkPixbuf *>(g_task_propagate_pointer (G_TASK (result), &error));
+
+  // the table is gone or the theme changed, nobody waits for this icon
+  if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+    {
+      g_error_free (error);
+      delete load;
+      return;
+    }
+
+  Glib::RefPtr<Gdk::Texture> texture;
+
+  if (pixbuf)
+    {
+      texture = Glib::wrap (gdk_texture_new_for_pixbuf (pixbuf));
+      g_object_unref (pixbuf);
+    }
+  else
+    {
+      g_warning ("Failed to load icon %s : %s", load->key.c_str (), error->message);
+      g_error_free (error);
+      texture = load->table->get_placeholder ();
+    }
+
+  load->table->icon_loaded (load->key, texture);
+  delete load;
+}
+
+void
+PrettyTable::icon_loaded (const string              &key,
+                          Glib::RefPtr<Gdk::Texture> texture)
+{
+  auto it = this->icons.find (key);
+
+  if (it == this->icons.end ())
+    return;
+
+  std::vector<pid_t> waiting;
+
+  it->second.texture = texture;
+  waiting.swap (it->second.waiting);
+
+  for (pid_t pid : waiting)
+    {
+      auto p = this->pending.find (pid);
+
+      // the process died or asked for another icon meanwhile
+      if (p == this->pending.end () || p->second != key)
+        continue;
+
+      this->pending.erase (p);
+
+      ProcInfo *info = GsmApplication::get ().processes.find (pid);
+
+      if (info)
+        info->set_icon (texture);
+    }
+
+  procman_debug ("Loaded icon %s, %zu icons cached, %u hits, %u misses",
+                 key.c_str (), this->icons.size (), this->hits, this->misses);
+}
+
+Glib::RefPtr<Gdk::Texture>
+PrettyTable::get_placeholder ()
+{
+  if (this->placeholder)
+    return this->placeholder;
+
+  // loaded once, synchronously, as it is needed right away
+  try {
+      Glib::RefPtr<Gtk::IconTheme> icon_theme;
+      Glib::RefPtr<Gtk::IconPaintable> icon_paintable;
+
+      icon_theme = Gtk::IconTheme::get_for_display (Gdk::Display::get_default ());
+      icon_paintable = icon_theme->lookup_icon (
+        "application-x-executable",
+        APP_ICON_SIZE,
+        APP_ICON_SCALE,
+        Gtk::TextDirection::NONE,
+        Gtk::IconLookupFlags (0));
+      this->placeholder = Gdk::Texture::create_for_pixbuf (Gdk::Pixbuf::create_from_file (icon_paintable->get_file ()->get_path (), APP_ICON_SIZE, APP_ICON_SIZE));
+    }
+  catch (std::exception&e) {
+      g_warning ("Failed to load the placeholder icon : %s", e.what ());
+    }
+
+  return this->placeholder;
+}
+
+void
+PrettyTable::clear_icon_cache ()
+{
+  // drop the loads in flight, their result would be stale
+  g_cancellable_cancel (this->cancellable);
+  g_object_unref (this->cancellable);
+  this->cancellable = g_cancellable_new ();
+
+  this->icons.clear ();
+  this->pending.clear ();
+  this->placeholder.reset ();
 }
 
 void
 PrettyTable::set_icon (ProcInfo &info)
 {
-  typedef Glib::RefPtr<Gdk::Texture> (PrettyTable::*Getter) (const ProcInfo &);
+  typedef Glib::RefPtr<Gio::Icon> (PrettyTable::*Getter) (const ProcInfo &);
 
   static std::vector<Getter> getters;
 
@@ -327,12 +654,12 @@ PrettyTable::set_icon (ProcInfo &info)
       getters.push_back (&PrettyTable::get_icon_dummy);
     }
 
-  Glib::RefPtr<Gdk::Texture> icon;
+  Glib::RefPtr<Gio::Icon> gicon;
 
-  for (size_t i = 0; not icon and i < getters.size (); ++i)
+  for (size_t i = 0; not gicon and i < getters.size (); ++i)
     {
       try {
-          icon = (this->*getters[i])(info);
+          gicon = (this->*getters[i])(info);
         }
       catch (std::exception&e) {
           g_warning ("Failed to load icon for %s(%u) : %s", info.name.c_str (), info.pid, e.what ());
@@ -340,5 +667,42 @@ PrettyTable::set_icon (ProcInfo &info)
         }
     }
 
-  info.set_icon (icon);
+  this->pending.erase (info.pid);
+
+  if (!gicon)
+    {
+      info.set_icon (Glib::RefPtr<Gdk::Texture>());
+      return;
+    }
+
+  const string key = gicon->to_string () + "@" + std::to_string (APP_ICON_SIZE) + "x" + std::to_string (APP_ICON_SCALE);
+  const auto [it, inserted] = this->icons.try_emplace (key);
+
+  if (it->second.texture)
+    {
+      this->hits++;
+      info.set_icon (it->second.texture);
+      return;
+    }
+
+  this->pending[info.pid] = key;
+  it->second.waiting.push_back (info.pid);
+  info.set_icon (this->get_placeholder ());
+
+  if (not inserted)
+    {
+      // already being loaded for another process
+      this->hits++;
+      return;
+    }
+
+  this->misses++;
+
+  try {
+      this->load_icon (key, gicon);
+    }
+  catch (std::exception&e) {
+      g_warning ("Failed to load icon for %s(%u) : %s", info.name.c_str (), info.pid, e.what ());
+      this->icon_loaded (key, this->get_placeholder ());
+    }
 }
@@ -10,11 +10,19 @@
 
 #include <map>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 class ProcInfo;
 
 using std::string;
 
+/*
+  Icons are shared between all the processes resolving to the same
+  GIcon: one texture per icon, size and scale.  The icon files are
+  decoded in a worker thread, a placeholder is shown in the meantime.
+*/
 class PrettyTable
 {
 public:
@@ -22,31 +30,82 @@ PrettyTable();
 ~PrettyTable();
 
 void                       set_icon (ProcInfo &);
+void                       clear_icon_cache ();
 
 private:
-Glib::RefPtr<Gdk::Texture> get_icon_from_theme (const ProcInfo &);
-Glib::RefPtr<Gdk::Texture> get_icon_from_default (const ProcInfo &);
-Glib::RefPtr<Gdk::Texture> get_icon_from_gio (const ProcInfo &);
-Glib::RefPtr<Gdk::Texture> get_icon_from_name (const ProcInfo &);
-Glib::RefPtr<Gdk::Texture> get_icon_for_kernel (const ProcInfo &);
-Glib::RefPtr<Gdk::Texture> get_icon_dummy (const ProcInfo &);
+Glib::RefPtr<Gio::Icon>    get_icon_from_theme (const ProcInfo &);
+Glib::RefPtr<Gio::Icon>    get_icon_from_default (const ProcInfo &);
+Glib::RefPtr<Gio::Icon>    get_icon_from_gio (const ProcInfo &);
+Glib::RefPtr<Gio::Icon>    get_icon_from_name (const ProcInfo &);
+Glib::RefPtr<Gio::Icon>    get_icon_for_kernel (const ProcInfo &);
+Glib::RefPtr<Gio::Icon>    get_icon_dummy (const ProcInfo &);
 
 bool                       get_default_icon_name (const string &cmd,
                                                   string &      name);
 void file_monitor_event (Glib::RefPtr<Gio::File>,
                          Glib::RefPtr<Gio::File>,
                          Gio::FileMonitor::Event);
-void init_gio_app_cache ();
 
-typedef std::map<string, Glib::RefPtr<Gdk::Texture> > IconCache;
-typedef std::map<pid_t, Glib::RefPtr<Gdk::Texture> > IconsForPID;
-typedef std::map<string, Glib::RefPtr<Gio::AppInfo> > AppCache;
+typedef std::unordered_set<string> AppKeys;
+
+void                       build_app_index ();
+static void                app_index_built_cb (GObject      *,
+                                               GAsyncResult *result,
+                                               gpointer      data);
+void                       add_app (const string                     &id,
+                                    const Glib::RefPtr<Gio::AppInfo> &app,
+                                    AppKeys                          &changed);
+void                       remove_app (const string &id,
+                                       AppKeys      &changed);
+void                       update_desktop_file (const string &id,
+                                                AppKeys      &changed);
+Glib::RefPtr<Gio::AppInfo> find_app (const string &key) const;
+void                       refresh_icons (const AppKeys &changed);
+
+Glib::RefPtr<Gdk::Texture> get_placeholder ();
+void                       load_icon (const string                  &key,
+                                      const Glib::RefPtr<Gio::Icon> &gicon);
+void                       icon_loaded (const string              &key,
+                                        Glib::RefPtr<Gdk::Texture> texture);
+static void                icon_loaded_cb (GObject      *,
+                                           GAsyncResult *result,
+                                           gpointer      data);
+
+struct CachedIcon
+{
+  Glib::RefPtr<Gdk::Texture> texture;   // NULL while loading
+  std::vector<pid_t> waiting;
+};
+
+typedef std::unordered_map<string, CachedIcon> IconCache;
+typedef std::unordered_map<pid_t, string> IconsForPID;
+/*
+  Desktop applications, indexed by "exec:<basename of Exec>",
+  "flatpak:<X-Flatpak>" and "wmclass:<lowercase StartupWMClass>".
+  Several applications can share a key, the last one added wins.
+*/
+struct DesktopApp
+{
+  Glib::RefPtr<Gio::AppInfo> app;
+  std::vector<string> keys;
+};
+
+typedef std::unordered_map<string, DesktopApp> DesktopApps;     // by desktop id
+typedef std::unordered_map<string, std::vector<string> > AppIndex;
 typedef std::map<string, Glib::RefPtr<Gio::FileMonitor> > DesktopDirMonitors;
 
-IconsForPID apps;
-IconCache defaults;
+IconCache icons;
+IconsForPID pending;            // pid -> key of the icon being loaded for it
+Glib::RefPtr<Gdk::Texture> placeholder;
+GCancellable *cancellable;
+unsigned hits;
+unsigned misses;
 DesktopDirMonitors monitors;
-AppCache gio_apps;
+DesktopApps desktop_apps;
+AppIndex app_index;
+GCancellable *app_index_cancellable;
+bool app_index_ready;
+std::unordered_set<string> app_index_dirty;    // desktop ids changed while building
 };
 
 #endif /* _GSM_PRETTY_TABLE_H_ */
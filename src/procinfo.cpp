@@ -97,7 +97,9 @@ ProcInfo::ProcInfo(pid_t pid)
   icon (),
   pid (pid),
   ppid (-1),
-  uid (-1)
+  uid (-1),
+  visible (true),
+  in_tree (false)
 {
   ProcInfo * const info = this;
   glibtop_proc_state procstate;
@@ -142,6 +144,9 @@ ProcInfo::set_icon (Glib::RefPtr<Gdk::Texture> icon)
 {
   this->icon = icon;
 
+  if (not this->in_tree)
+    return;
+
   GtkTreeModel *model;
 
   model = gtk_tree_model_filter_get_model (GTK_TREE_MODEL_FILTER (
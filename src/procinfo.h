@@ -91,6 +91,12 @@ public:
   const pid_t pid;
   pid_t ppid;
   guint uid;
+
+  // whether the process passes the current search, see
+  // proctable_update_search ()
+  bool visible;
+  // whether node is a row of the tree store
+  bool in_tree;
 };
 
 G_BEGIN_DECLS
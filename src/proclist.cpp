@@ -9,3 +9,11 @@ ProcList::find (pid_t pid)
 
   return (it == data.end () ? nullptr : &it->second);
 }
+
+void
+ProcList::set_parent (ProcInfo *info,
+                      pid_t     ppid)
+{
+  info->ppid = ppid;
+  tree.set (info->pid, ppid, info);
+}
@@ -4,6 +4,7 @@
 #include <mutex>
 
 #include "procinfo.h"
+#include "proctree.h"
 
 class ProcList
 {
@@ -14,6 +15,7 @@ class ProcList
   typedef std::map<pid_t, ProcInfo> List;
   List data;
   std::mutex data_lock;
+  ProcTree<ProcInfo *> tree;
   public:
   std::map<pid_t, unsigned long> cpu_times;
   typedef List::iterator Iterator;
@@ -32,18 +34,33 @@ class ProcList
   {
     std::lock_guard<std::mutex> lg (data_lock);
 
+    tree.remove (it->first);
     return data.erase (it);
   }
   ProcInfo*
   add (pid_t pid)
   {
-    return &data.try_emplace (pid, pid).first->second;
+    ProcInfo *info = &data.try_emplace (pid, pid).first->second;
+
+    tree.set (pid, info->ppid, info);
+    return info;
   }
   void
   clear ()
   {
+    tree.clear ();
     return data.clear ();
   }
 
   ProcInfo * find (pid_t pid);
+
+  // keeps the parent -> children index up to date
+  void set_parent (ProcInfo *info,
+                   pid_t     ppid);
+
+  const ProcTree<ProcInfo *>&
+  get_tree () const
+  {
+    return tree;
+  }
 };
@@ -25,6 +25,7 @@
 #include <glibtop/procstate.h>
 
 #include "application.h"
+#include "gsm-sampler.h"
 #include "procactions.h"
 #include "procproperties.h"
 #include "procinfo.h"
@@ -166,7 +167,7 @@ close_dialog_action (GSimpleAction*,
   guint timer;
 
   timer = GPOINTER_TO_UINT (g_object_get_data (G_OBJECT (dialog), "timer"));
-  g_source_remove (timer);
+  gsm_sampler_remove (timer);
 
   gtk_window_destroy (dialog);
 }
@@ -179,7 +180,7 @@ close_procprop_dialog (GObject*,
   guint timer;
 
   timer = GPOINTER_TO_UINT (g_object_get_data (G_OBJECT (window), "timer"));
-  g_source_remove (timer);
+  gsm_sampler_remove (timer);
 
   gtk_window_destroy (window);
 }
@@ -265,7 +266,7 @@ create_single_procproperties_dialog (GtkTreeModel *model,
 
   gtk_window_present (GTK_WINDOW (procpropdialog));
 
-  timer = g_timeout_add_seconds (5, procprop_timer, builder);
+  timer = gsm_sampler_add (5000, procprop_timer, builder);
   g_object_set_data (G_OBJECT (procpropdialog), "timer", GUINT_TO_POINTER (timer));
 
   update_procproperties_dialog (builder);
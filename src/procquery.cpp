@@ -0,0 +1,392 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include <config.h>
+
+#include <glibtop/procstate.h>
+#include <string.h>
+
+#include "procquery.h"
+#include "procinfo.h"
+
+namespace
+{
+Glib::RefPtr<Glib::Regex>
+compile_caseless (const std::string &pattern)
+{
+  const auto flags = Glib::Regex::CompileFlags::CASELESS | Glib::Regex::CompileFlags::OPTIMIZE;
+
+  try {
+      return Glib::Regex::create (pattern, flags);
+    } catch (const Glib::Error&ex) {
+      return Glib::Regex::create (Glib::Regex::escape_string (pattern), flags);
+    }
+}
+
+// "200M", "1.5GiB", "12%" ...
+bool
+parse_number (const std::string &value,
+              double            &number)
+{
+  const char *str = value.c_str ();
+  char *end = NULL;
+
+  number = g_ascii_strtod (str, &end);
+
+  if (end == str)
+    return false;
+
+  double factor = 1.0;
+
+  switch (g_ascii_toupper (*end))
+    {
+      case 'T':
+        factor *= 1024.0;
+        [[fallthrough]];
+
+      case 'G':
+        factor *= 1024.0;
+        [[fallthrough]];
+
+      case 'M':
+        factor *= 1024.0;
+        [[fallthrough]];
+
+      case 'K':
+        factor *= 1024.0;
+        end++;
+        if (*end == 'i')
+          end++;
+        if (g_ascii_toupper (*end) == 'B')
+          end++;
+        break;
+
+      case 'B':
+      case '%':
+        end++;
+        break;
+
+      default:
+        break;
+    }
+
+  number *= factor;
+
+  return *end == '\0';
+}
+
+bool
+parse_state (const std::string &value,
+             guint             &state)
+{
+  static const struct
+  {
+    const char *letter;
+    const char *word;
+    guint state;
+  } states[] = {
+    { "R", "running", GLIBTOP_PROCESS_RUNNING },
+    { "S", "sleeping", GLIBTOP_PROCESS_INTERRUPTIBLE },
+    { "D", "uninterruptible", GLIBTOP_PROCESS_UNINTERRUPTIBLE },
+    { "Z", "zombie", GLIBTOP_PROCESS_ZOMBIE },
+    { "T", "stopped", GLIBTOP_PROCESS_STOPPED },
+  };
+
+  for (const auto &s : states)
+    {
+      if (g_ascii_strcasecmp (value.c_str (), s.letter) == 0
+          || g_ascii_strcasecmp (value.c_str (), s.word) == 0)
+        {
+          state = s.state;
+          return true;
+        }
+    }
+
+  return false;
+}
+}
+
+
+ProcQuery::ProcQuery(const std::string &query)
+{
+  std::string words;
+  gchar **tokens = g_strsplit_set (query.c_str (), " \t", -1);
+
+  for (gchar **token = tokens; *token; token++)
+    {
+      if (**token == '\0' || parse_term (*token))
+        continue;
+
+      // plain text, possibly already containing '|' separated words
+      gchar **keys = g_strsplit (*token, "|", -1);
+
+      for (gchar **key = keys; *key; key++)
+        {
+          if (**key == '\0')
+            continue;
+
+          if (not words.empty ())
+            words += '|';
+          words += *key;
+        }
+
+      g_strfreev (keys);
+    }
+
+  g_strfreev (tokens);
+
+  if (not words.empty ())
+    text = compile_caseless (words);
+}
+
+bool
+ProcQuery::parse_term (const std::string &token)
+{
+  static const struct
+  {
+    const char *name;
+    Field field;
+  } field_names[] = {
+    { "cpu", Field::CPU },
+    { "mem", Field::MEM },
+    { "memory", Field::MEM },
+    { "res", Field::RES },
+    { "rss", Field::RES },
+    { "virt", Field::VIRT },
+    { "vsz", Field::VIRT },
+    { "shared", Field::SHARED },
+    { "pid", Field::PID },
+    { "ppid", Field::PPID },
+    { "nice", Field::NICE },
+    { "read", Field::READ },
+    { "write", Field::WRITE },
+    { "user", Field::USER },
+    { "name", Field::NAME },
+    { "cmd", Field::CMD },
+    { "args", Field::CMD },
+    { "cgroup", Field::CGROUP },
+    { "unit", Field::UNIT },
+    { "state", Field::STATE },
+    { "status", Field::STATE },
+  };
+
+  const auto pos = token.find_first_of ("<>=!:");
+
+  if (pos == std::string::npos || pos == 0)
+    return false;
+
+  Term term = { Field::CPU, Op::EQUAL, 0.0, 0U, {} };
+  const std::string name = token.substr (0, pos);
+  bool known = false;
+
+  for (const auto &f : field_names)
+    {
+      if (g_ascii_strcasecmp (name.c_str (), f.name) == 0)
+        {
+          term.field = f.field;
+          known = true;
+          break;
+        }
+    }
+
+  if (not known)
+    return false;
+
+  const char *op = token.c_str () + pos;
+  size_t op_len = 1;
+
+  if (strncmp (op, ">=", 2) == 0)
+    term.op = Op::GREATER_EQUAL, op_len = 2;
+  else if (strncmp (op, "<=", 2) == 0)
+    term.op = Op::LESS_EQUAL, op_len = 2;
+  else if (strncmp (op, "!=", 2) == 0)
+    term.op = Op::NOT_EQUAL, op_len = 2;
+  else if (*op == '>')
+    term.op = Op::GREATER;
+  else if (*op == '<')
+    term.op = Op::LESS;
+  else if (*op == '=')
+    term.op = Op::EQUAL;
+  else if (*op == ':')
+    term.op = Op::CONTAINS;
+  else
+    return false;
+
+  const std::string value = token.substr (pos + op_len);
+
+  if (value.empty ())
+    return false;
+
+  switch (term.field)
+    {
+      case Field::USER:
+      case Field::NAME:
+      case Field::CMD:
+      case Field::CGROUP:
+      case Field::UNIT:
+        if (term.op == Op::CONTAINS)
+          term.regex = compile_caseless (Glib::Regex::escape_string (value));
+        else if (term.op == Op::EQUAL || term.op == Op::NOT_EQUAL)
+          term.regex = compile_caseless ("^" + Glib::Regex::escape_string (value) + "$");
+        else
+          return false;
+        break;
+
+      case Field::STATE:
+        if (term.op == Op::CONTAINS)
+          term.op = Op::EQUAL;
+        if (term.op != Op::EQUAL && term.op != Op::NOT_EQUAL)
+          return false;
+        if (not parse_state (value, term.state))
+          return false;
+        break;
+
+      default:
+        if (term.op == Op::CONTAINS)
+          term.op = Op::EQUAL;
+        if (not parse_number (value, term.number))
+          return false;
+        break;
+    }
+
+  terms.push_back (term);
+
+  return true;
+}
+
+bool
+ProcQuery::is_empty () const
+{
+  return terms.empty () && !text;
+}
+
+bool
+ProcQuery::term_matches (const Term     &term,
+                         const ProcInfo &info) const
+{
+  const std::string *str = NULL;
+  double number = 0.0;
+
+  switch (term.field)
+    {
+      case Field::CPU:
+        number = info.pcpu;
+        break;
+
+      case Field::MEM:
+        number = info.mem;
+        break;
+
+      case Field::RES:
+        number = info.memres;
+        break;
+
+      case Field::VIRT:
+        number = info.vmsize;
+        break;
+
+      case Field::SHARED:
+        number = info.memshared;
+        break;
+
+      case Field::PID:
+        number = info.pid;
+        break;
+
+      case Field::PPID:
+        number = info.ppid;
+        break;
+
+      case Field::NICE:
+        number = info.nice;
+        break;
+
+      case Field::READ:
+        number = info.disk_read_bytes_current;
+        break;
+
+      case Field::WRITE:
+        number = info.disk_write_bytes_current;
+        break;
+
+      case Field::USER:
+        str = &info.user;
+        break;
+
+      case Field::NAME:
+        str = &info.name;
+        break;
+
+      case Field::CMD:
+        str = &info.arguments;
+        break;
+
+      case Field::CGROUP:
+        str = &info.cgroup_name;
+        break;
+
+      case Field::UNIT:
+        str = &info.unit;
+        break;
+
+      case Field::STATE:
+        return (info.status == term.state) == (term.op == Op::EQUAL);
+    }
+
+  if (str)
+    {
+      const bool found = g_regex_match (term.regex->gobj (), str->c_str (), GRegexMatchFlags (0), NULL);
+
+      return term.op == Op::NOT_EQUAL ? !found : found;
+    }
+
+  switch (term.op)
+    {
+      case Op::LESS:
+        return number < term.number;
+
+      case Op::LESS_EQUAL:
+        return number <= term.number;
+
+      case Op::GREATER:
+        return number > term.number;
+
+      case Op::GREATER_EQUAL:
+        return number >= term.number;
+
+      case Op::NOT_EQUAL:
+        return number != term.number;
+
+      case Op::EQUAL:
+      case Op::CONTAINS:
+      default:
+        return number == term.number;
+    }
+}
+
+bool
+ProcQuery::text_matches (const ProcInfo &info) const
+{
+  GRegex *regex = text->gobj ();
+  char pid[16];
+
+  if (g_regex_match (regex, info.name.c_str (), GRegexMatchFlags (0), NULL)
+      || g_regex_match (regex, info.user.c_str (), GRegexMatchFlags (0), NULL)
+      || g_regex_match (regex, info.arguments.c_str (), GRegexMatchFlags (0), NULL))
+    return true;
+
+  g_snprintf (pid, sizeof pid, "%d", info.pid);
+
+  return g_regex_match (regex, pid, GRegexMatchFlags (0), NULL);
+}
+
+bool
+ProcQuery::matches (const ProcInfo &info) const
+{
+  for (const auto &term : terms)
+    if (not term_matches (term, info))
+      return false;
+
+  return !text || text_matches (info);
+}
@@ -0,0 +1,87 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <glibmm.h>
+
+#include "util.h"
+
+class ProcInfo;
+
+/*
+ * A search query for the process list, compiled once when the search
+ * text changes and then evaluated against every ProcInfo.
+ *
+ * The query is made of whitespace separated terms.  A term of the form
+ * "field<op>value" is a structured predicate, e.g. "cpu>5", "mem>200M",
+ * "user:root", "state=Z" or "cmd:python".  Supported operators are
+ * '>', '<', '>=', '<=', '=', '!=' and ':' (substring for text fields,
+ * equality for numbers).  Anything else is plain text and, like before,
+ * the plain words are OR'ed together as a case insensitive regular
+ * expression matched against the name, user, ID and command line.
+ *
+ * All structured terms and the plain text (if any) must match.
+ */
+class ProcQuery
+  : private procman::NonCopyable
+{
+public:
+  explicit ProcQuery(const std::string &query);
+
+  bool is_empty () const;
+  bool matches (const ProcInfo &info) const;
+
+private:
+  enum class Field
+  {
+    CPU,
+    MEM,
+    RES,
+    VIRT,
+    SHARED,
+    PID,
+    PPID,
+    NICE,
+    READ,
+    WRITE,
+    USER,
+    NAME,
+    CMD,
+    CGROUP,
+    UNIT,
+    STATE
+  };
+
+  enum class Op
+  {
+    LESS,
+    LESS_EQUAL,
+    GREATER,
+    GREATER_EQUAL,
+    EQUAL,
+    NOT_EQUAL,
+    CONTAINS
+  };
+
+  struct Term
+  {
+    Field field;
+    Op op;
+    double number;
+    guint state;
+    Glib::RefPtr<Glib::Regex> regex;
+  };
+
+  bool parse_term (const std::string &token);
+  bool term_matches (const Term      &term,
+                     const ProcInfo  &info) const;
+  bool text_matches (const ProcInfo &info) const;
+
+  std::vector<Term> terms;
+  Glib::RefPtr<Glib::Regex> text;
+};
@@ -40,7 +40,8 @@
 #include <time.h>
 
 #include <set>
-#include <list>
+#include <unordered_set>
+#include <vector>
 
 #include "application.h"
 #include "proctable.h"
@@ -48,9 +49,11 @@
 #include "util.h"
 #include "interface.h"
 #include "procinfo.h"
+#include "procquery.h"
 #include "gsm-selinux.h"
 #include "settings-keys.h"
 #include "gsm-cgroups.h"
+#include "gsm-sampler.h"
 #include "legacy/treeview.h"
 
 #ifdef HAVE_SYSTEMD
@@ -172,9 +175,9 @@ cb_timeout (gpointer data)
 
   if (app->smooth_refresh->get (new_interval))
     {
-      app->timeout = g_timeout_add (new_interval,
-                                    cb_timeout,
-                                    app);
+      app->timeout = gsm_sampler_add (new_interval,
+                                      cb_timeout,
+                                      app);
       return G_SOURCE_REMOVE;
     }
 
@@ -187,6 +190,8 @@ cb_refresh_icons (GtkIconTheme*,
 {
   GsmApplication *app = (GsmApplication *) data;
 
+  app->pretty_table->clear_icon_cache ();
+
   for (auto&v : app->processes)
     app->pretty_table->set_icon (v.second);
 
@@ -194,93 +199,163 @@ cb_refresh_icons (GtkIconTheme*,
 }
 
 static gboolean
-iter_matches_search_key (GtkTreeModel *model,
+process_visibility_func (GtkTreeModel *model,
                          GtkTreeIter  *iter,
-                         const gchar  *search_text)
+                         gpointer      data)
 {
-  char *name;
-  char *user;
-  pid_t pid;
-  char *pids;
-  char *args;
-  gboolean found;
-  char *search_pattern;
-  char **keys;
-  Glib::RefPtr<Glib::Regex> regex;
-
-  gtk_tree_model_get (model, iter,
-                      COL_NAME, &name,
-                      COL_USER, &user,
-                      COL_PID, &pid,
-                      COL_ARGS, &args,
-                      -1);
-
-  pids = g_strdup_printf ("%d", pid);
-
-  keys = g_strsplit_set (search_text, " |", -1);
-  search_pattern = g_strjoinv ("|", keys);
-  try {
-      regex = Glib::Regex::create (search_pattern, Glib::Regex::CompileFlags::CASELESS);
-    } catch (const Glib::Error&ex) {
-      regex = Glib::Regex::create (Glib::Regex::escape_string (search_pattern), Glib::Regex::CompileFlags::CASELESS);
-    }
+  GsmApplication * const app = static_cast<GsmApplication *>(data);
+  ProcInfo *info = NULL;
 
-  found = (name && regex->match (name)) || (user && regex->match (user))
-          || (pids && regex->match (pids)) || (args && regex->match (args));
+  if (!app->search_query || app->search_query->is_empty ())
+    return TRUE;
 
-  g_strfreev (keys);
-  g_free (search_pattern);
-  g_free (name);
-  g_free (user);
-  g_free (args);
-  g_free (pids);
+  gtk_tree_model_get (model, iter, COL_POINTER, &info, -1);
 
-  return found;
+  // the row has just been inserted and is not filled yet, it will be
+  // filtered again once its columns are set
+  return info && info->visible;
 }
 
-static gboolean
-process_visibility_func (GtkTreeModel *model,
-                         GtkTreeIter  *iter,
-                         gpointer      data)
+// the process list is shown as a tree only in dependencies view, the
+// top processes are always listed flat
+static bool
+shows_dependencies (GsmApplication *app)
 {
-  GsmApplication * const app = static_cast<GsmApplication *>(data);
-  const gchar *search_text = app->search_entry == NULL ? "" : gtk_editable_get_text (GTK_EDITABLE (app->search_entry));
-  GtkTreePath *tree_path = gtk_tree_model_get_path (model, iter);
+  return app->settings->get_boolean (GSM_SETTING_SHOW_DEPENDENCIES)
+         && not app->settings->get_boolean (GSM_SETTING_SHOW_TOP_PROCESSES);
+}
 
-  if (strcmp (search_text, "") == 0)
+// the numeric columns are sorted on keys read straight from the ProcInfo
+// of each row rather than from the model columns
+static bool
+has_sort_key (gint column)
+{
+  switch (column)
     {
-      gtk_tree_path_free (tree_path);
-      return TRUE;
+      case COL_VMSIZE:
+      case COL_MEMRES:
+      case COL_MEMSHARED:
+      case COL_MEM:
+      case COL_CPU:
+      case COL_CPU_TIME:
+      case COL_START_TIME:
+      case COL_DISK_READ_TOTAL:
+      case COL_DISK_WRITE_TOTAL:
+      case COL_DISK_READ_CURRENT:
+      case COL_DISK_WRITE_CURRENT:
+      case COL_PRIORITY:
+        return true;
+
+      default:
+        return false;
     }
+}
 
-  // in case we are in dependencies view, we show (and expand) rows not matching the text, but having a matching child
-  gboolean match = false;
-
-  if (app->settings->get_boolean (GSM_SETTING_SHOW_DEPENDENCIES))
+static gdouble
+get_sort_key (const ProcInfo &info,
+              gint            column)
+{
+  switch (column)
     {
-      GtkTreeIter child;
-      if (gtk_tree_model_iter_children (model, &child, iter))
-        {
-          gboolean child_match = FALSE;
-          do
-            {
-              child_match = process_visibility_func (model, &child, data);
-            } while (gtk_tree_model_iter_next (model, &child) && !child_match);
-          match = child_match;
-        }
+      case COL_VMSIZE:
+        return info.vmsize;
 
-      match |= iter_matches_search_key (model, iter, search_text);
-      if (match && (strlen (search_text) > 0))
-        gtk_tree_view_expand_to_path (GTK_TREE_VIEW (app->tree), tree_path);
-    }
-  else
-    {
-      match = iter_matches_search_key (model, iter, search_text);
+      case COL_MEMRES:
+        return info.memres;
+
+      case COL_MEMSHARED:
+        return info.memshared;
+
+      case COL_MEM:
+        return info.mem;
+
+      case COL_CPU:
+        return info.pcpu;
+
+      case COL_CPU_TIME:
+        return info.cpu_time;
+
+      case COL_START_TIME:
+        return info.start_time;
+
+      case COL_DISK_READ_TOTAL:
+        return info.disk_read_bytes_total;
+
+      case COL_DISK_WRITE_TOTAL:
+        return info.disk_write_bytes_total;
+
+      case COL_DISK_READ_CURRENT:
+        return info.disk_read_bytes_current;
+
+      case COL_DISK_WRITE_CURRENT:
+        return info.disk_write_bytes_current;
+
+      case COL_PRIORITY:
+        return info.nice;
+
+      default:
+        return 0.0;
     }
+}
+
+// While the rows are updated, every key compares equal so that a changed
+// row keeps its position instead of being moved (and the whole level
+// reordered) on each row-changed. The model is sorted once afterwards.
+static bool sort_frozen = false;
+
+static gint
+proc_compare_func (GtkTreeModel *model,
+                   GtkTreeIter  *first,
+                   GtkTreeIter  *second,
+                   gpointer      data)
+{
+  const gint column = GPOINTER_TO_INT (data);
+  ProcInfo *info1 = NULL;
+  ProcInfo *info2 = NULL;
+
+  if (sort_frozen)
+    return 0;
+
+  gtk_tree_model_get (model, first, COL_POINTER, &info1, -1);
+  gtk_tree_model_get (model, second, COL_POINTER, &info2, -1);
+
+  if (!info1 || !info2)
+    return (info1 != NULL) - (info2 != NULL);
+
+  const gdouble key1 = get_sort_key (*info1, column);
+  const gdouble key2 = get_sort_key (*info2, column);
+
+  if (column == COL_PRIORITY)
+    return (key1 > key2) - (key1 < key2);
+
+  // amounts are sorted from the biggest
+  return (key2 > key1) - (key2 < key1);
+}
+
+static void
+proctable_sort_freeze (GsmApplication*)
+{
+  sort_frozen = true;
+}
 
-  gtk_tree_path_free (tree_path);
+static void
+proctable_sort_thaw (GsmApplication *app)
+{
+  GtkTreeSortable *sortable = GTK_TREE_SORTABLE (gtk_tree_view_get_model (GTK_TREE_VIEW (app->tree)));
+  gint column;
+  GtkSortType order;
+
+  sort_frozen = false;
+
+  if (not gtk_tree_sortable_get_sort_column_id (sortable, &column, &order)
+      || not has_sort_key (column))
+    return;
 
-  return match;
+  // setting the function of the current sort column resorts the model
+  gtk_tree_sortable_set_sort_func (sortable, column,
+                                   proc_compare_func,
+                                   GINT_TO_POINTER (column),
+                                   NULL);
 }
 
 static void
@@ -300,20 +375,39 @@ proctable_clear_tree (GsmApplication * const app)
 }
 
 static void
-cb_show_dependencies_changed (Gio::Settings& settings,
+cb_show_dependencies_changed (Gio::Settings&,
                               Glib::ustring,
                               GsmApplication*app)
 {
   if (app->timeout)
     {
-      gtk_tree_view_set_show_expanders (GTK_TREE_VIEW (app->tree),
-                                        settings.get_boolean (GSM_SETTING_SHOW_DEPENDENCIES));
+      gtk_tree_view_set_show_expanders (GTK_TREE_VIEW (app->tree), shows_dependencies (app));
 
       proctable_clear_tree (app);
       proctable_update (app);
     }
 }
 
+static void
+cb_top_processes_count_changed (Gio::Settings&,
+                                Glib::ustring,
+                                GsmApplication *app)
+{
+  if (app->timeout && app->settings->get_boolean (GSM_SETTING_SHOW_TOP_PROCESSES))
+    proctable_update_top_processes (app);
+}
+
+static void
+cb_sort_column_changed (GtkTreeSortable*,
+                        gpointer data)
+{
+  GsmApplication * const app = static_cast<GsmApplication *>(data);
+
+  // the top processes depend on the sort column
+  if (app->timeout && app->settings->get_boolean (GSM_SETTING_SHOW_TOP_PROCESSES))
+    proctable_update_top_processes (app);
+}
+
 static void
 cb_show_whose_processes_changed (Gio::Settings&,
                                  Glib::ustring,
@@ -415,7 +509,7 @@ proctable_new (GsmApplication * const app)
   proctree = gsm_tree_view_new (settings, TRUE);
   gtk_tree_view_set_model (GTK_TREE_VIEW (proctree), GTK_TREE_MODEL (model_sort));
   gtk_tree_view_set_tooltip_column (GTK_TREE_VIEW (proctree), COL_TOOLTIP);
-  gtk_tree_view_set_show_expanders (GTK_TREE_VIEW (proctree), app->settings->get_boolean (GSM_SETTING_SHOW_DEPENDENCIES));
+  gtk_tree_view_set_show_expanders (GTK_TREE_VIEW (proctree), shows_dependencies (app));
   gtk_tree_view_set_enable_search (GTK_TREE_VIEW (proctree), FALSE);
   g_object_unref (G_OBJECT (model));
 
@@ -603,16 +697,11 @@ proctable_new (GsmApplication * const app)
           case COL_DISK_READ_CURRENT:
           case COL_DISK_WRITE_CURRENT:
           case COL_START_TIME:
-            gtk_tree_sortable_set_sort_func (GTK_TREE_SORTABLE (model_sort), i,
-                                             procman::number_compare_func,
-                                             GUINT_TO_POINTER (i),
-                                             NULL);
-            break;
-
           case COL_PRIORITY:
             gtk_tree_sortable_set_sort_func (GTK_TREE_SORTABLE (model_sort), i,
-                                             procman::priority_compare_func,
-                                             GUINT_TO_POINTER (COL_NICE), NULL);
+                                             proc_compare_func,
+                                             GINT_TO_POINTER (i),
+                                             NULL);
             break;
 
           default:
@@ -709,10 +798,21 @@ proctable_new (GsmApplication * const app)
   g_signal_connect (G_OBJECT (model_sort), "sort-column-changed",
                     G_CALLBACK (cb_save_tree_state), app);
 
+  g_signal_connect (G_OBJECT (model_sort), "sort-column-changed",
+                    G_CALLBACK (cb_sort_column_changed), app);
+
   app->settings->signal_changed (GSM_SETTING_SHOW_DEPENDENCIES).connect ([app](const Glib::ustring&key) {
     cb_show_dependencies_changed (*app->settings.operator-> (), key, app);
   });
 
+  app->settings->signal_changed (GSM_SETTING_SHOW_TOP_PROCESSES).connect ([app](const Glib::ustring&key) {
+    cb_show_dependencies_changed (*app->settings.operator-> (), key, app);
+  });
+
+  app->settings->signal_changed (GSM_SETTING_TOP_PROCESSES_COUNT).connect ([app](const Glib::ustring&key) {
+    cb_top_processes_count_changed (*app->settings.operator-> (), key, app);
+  });
+
   app->settings->signal_changed (GSM_SETTING_SHOW_WHOSE_PROCESSES).connect ([app](const Glib::ustring&key) {
     cb_show_whose_processes_changed (*app->settings.operator-> (), key, app);
   });
@@ -808,7 +908,7 @@ insert_info_to_tree (ProcInfo       *info,
   filtered = gtk_tree_model_sort_get_model (GTK_TREE_MODEL_SORT (sorted));
   model = gtk_tree_model_filter_get_model (GTK_TREE_MODEL_FILTER (filtered));
 
-  if (app->settings->get_boolean (GSM_SETTING_SHOW_DEPENDENCIES))
+  if (shows_dependencies (app))
     {
       ProcInfo *parent = 0;
 
@@ -859,6 +959,8 @@ insert_info_to_tree (ProcInfo       *info,
                       COL_SECURITYCONTEXT, info->security_context.c_str (),
                       -1);
 
+  info->in_tree = true;
+
   app->pretty_table->set_icon (*info);
 
   procman_debug ("inserted %d%s", info->pid, (forced ? " (forced)" : ""));
@@ -867,17 +969,16 @@ insert_info_to_tree (ProcInfo       *info,
 /* Removing a node with children - make sure the children are queued
 ** to be readded.
 */
-template<typename List>
 static void
-remove_info_from_tree (GsmApplication *app,
-                       GtkTreeModel   *model,
-                       ProcInfo&       current,
-                       List &          orphans,
-                       unsigned        lvl = 0)
+remove_info_from_tree (GsmApplication                *app,
+                       GtkTreeModel                  *model,
+                       ProcInfo&                      current,
+                       std::unordered_set<ProcInfo *>&orphans,
+                       unsigned                       lvl = 0)
 {
   GtkTreeIter child_node;
 
-  if (std::find (orphans.begin (), orphans.end (), &current) != orphans.end ())
+  if (orphans.count (&current))
     {
       procman_debug ("[%u] %d already removed from tree", lvl, int(current.pid));
       return;
@@ -899,9 +1000,10 @@ remove_info_from_tree (GsmApplication *app,
 
   g_assert (not gtk_tree_model_iter_has_child (model, &current.node));
 
-  orphans.push_back (&current);
+  orphans.insert (&current);
   gtk_tree_store_remove (GTK_TREE_STORE (model), &current.node);
   procman::poison (current.node, 0x69);
+  current.in_tree = false;
 }
 
 
@@ -967,7 +1069,7 @@ update_info (GsmApplication *app,
   // set the ppid only if one can exist
   // i.e. pid=0 can never have a parent
   if (info->pid > 0)
-    info->ppid = procuid.ppid;
+    app->processes.set_parent (info, procuid.ppid);
 
   g_assert (info->pid != info->ppid);
   g_assert (info->ppid != -1 || info->pid == 0);
@@ -977,6 +1079,219 @@ update_info (GsmApplication *app,
 }
 
 
+enum
+{
+  VISIT_VISIBLE = 1 << 0,
+  VISIT_CHANGED = 1 << 1
+};
+
+static void
+set_visible (ProcInfo                *info,
+             bool                     visible,
+             std::vector<ProcInfo *> &changed)
+{
+  if (info->visible != visible)
+    {
+      info->visible = visible;
+      changed.push_back (info);
+    }
+}
+
+// post-order: a process is visible if it matches or if any of its
+// descendants does. The deepest processes having a visible child are
+// queued in @expand, expanding them also expands all their ancestors.
+static unsigned
+visit_visibility (ProcInfo                   *info,
+                  const ProcQuery            &query,
+                  const ProcTree<ProcInfo *> &tree,
+                  bool                        force_expand,
+                  std::vector<ProcInfo *>    &changed,
+                  std::vector<ProcInfo *>    &expand)
+{
+  unsigned children_flags = 0;
+  const size_t expand_before = expand.size ();
+
+  for (pid_t child : tree.children (info->pid))
+    children_flags |= visit_visibility (tree.value (child), query, tree, force_expand, changed, expand);
+
+  const bool child_visible = children_flags & VISIT_VISIBLE;
+  const size_t changed_before = changed.size ();
+
+  set_visible (info, child_visible || query.matches (*info), changed);
+
+  if (child_visible && expand.size () == expand_before
+      && (force_expand || (children_flags & VISIT_CHANGED)))
+    expand.push_back (info);
+
+  return (info->visible ? VISIT_VISIBLE : 0)
+         | ((children_flags & VISIT_CHANGED) || changed.size () != changed_before ? VISIT_CHANGED : 0);
+}
+
+// Evaluates the search query once per process and stores the result in
+// ProcInfo::visible, so that the filter function is a simple lookup.
+static void
+compute_visibility (GsmApplication          *app,
+                    bool                     force_expand,
+                    std::vector<ProcInfo *> &changed,
+                    std::vector<ProcInfo *> &expand)
+{
+  const ProcQuery *query = app->search_query;
+  const bool searching = query && not query->is_empty ();
+
+  if (not searching or not shows_dependencies (app))
+    {
+      for (auto&v : app->processes)
+        set_visible (&v.second, not searching or query->matches (v.second), changed);
+      return;
+    }
+
+  const ProcTree<ProcInfo *> &tree = app->processes.get_tree ();
+
+  // same parenting rules as insert_info_to_tree ()
+  for (auto&v : app->processes)
+    {
+      ProcInfo *info = &v.second;
+
+      if (info->ppid == info->pid || not tree.contains (info->ppid))
+        visit_visibility (info, *query, tree, force_expand, changed, expand);
+    }
+}
+
+static void
+expand_processes (GsmApplication                *app,
+                  const std::vector<ProcInfo *> &expand)
+{
+  GtkTreeModel *sorted = gtk_tree_view_get_model (GTK_TREE_VIEW (app->tree));
+  GtkTreeModel *filtered = gtk_tree_model_sort_get_model (GTK_TREE_MODEL_SORT (sorted));
+  GtkTreeModel *model = gtk_tree_model_filter_get_model (GTK_TREE_MODEL_FILTER (filtered));
+
+  for (ProcInfo *info : expand)
+    {
+      GtkTreePath *path = gtk_tree_model_get_path (model, &info->node);
+      GtkTreePath *filtered_path = gtk_tree_model_filter_convert_child_path_to_path (GTK_TREE_MODEL_FILTER (filtered), path);
+
+      if (filtered_path)
+        {
+          GtkTreePath *sorted_path = gtk_tree_model_sort_convert_child_path_to_path (GTK_TREE_MODEL_SORT (sorted), filtered_path);
+
+          if (sorted_path)
+            {
+              gtk_tree_view_expand_to_path (GTK_TREE_VIEW (app->tree), sorted_path);
+              gtk_tree_path_free (sorted_path);
+            }
+          gtk_tree_path_free (filtered_path);
+        }
+      gtk_tree_path_free (path);
+    }
+}
+
+// Picks the heaviest visible processes for the current sort column (or
+// CPU when sorting on text) with a partial selection over their keys.
+static std::unordered_set<ProcInfo *>
+select_top_processes (GsmApplication *app)
+{
+  GtkTreeSortable *sortable = GTK_TREE_SORTABLE (gtk_tree_view_get_model (GTK_TREE_VIEW (app->tree)));
+  const size_t count = app->settings->get_int (GSM_SETTING_TOP_PROCESSES_COUNT);
+  std::vector<std::pair<gdouble, ProcInfo *> > keys;
+  gint column;
+  GtkSortType order;
+
+  if (not gtk_tree_sortable_get_sort_column_id (sortable, &column, &order)
+      || not has_sort_key (column))
+    column = COL_CPU;
+
+  for (auto&v : app->processes)
+    {
+      if (not v.second.visible)
+        continue;
+
+      const gdouble key = get_sort_key (v.second, column);
+
+      // a lower nice value is a higher priority
+      keys.emplace_back (column == COL_PRIORITY ? -key : key, &v.second);
+    }
+
+  if (keys.size () > count)
+    {
+      std::nth_element (keys.begin (), keys.begin () + count, keys.end (),
+                        [](const std::pair<gdouble, ProcInfo *> &a, const std::pair<gdouble, ProcInfo *> &b) {
+        return a.first > b.first;
+      });
+      keys.resize (count);
+    }
+
+  std::unordered_set<ProcInfo *> top;
+
+  for (const auto &k : keys)
+    top.insert (k.second);
+
+  return top;
+}
+
+// In top processes mode only the selected processes are rows of the
+// store, the others are kept in the process list for the next update.
+// Returns the processes inserted, whose mutable columns are still empty.
+static std::vector<ProcInfo *>
+update_top_processes (GsmApplication *app,
+                      GtkTreeModel   *model)
+{
+  const std::unordered_set<ProcInfo *> top = select_top_processes (app);
+  std::unordered_set<ProcInfo *> removed;
+  std::vector<ProcInfo *> inserted;
+
+  for (auto&v : app->processes)
+    {
+      ProcInfo *info = &v.second;
+      const bool wanted = top.count (info);
+
+      if (info->in_tree && not wanted)
+        {
+          remove_info_from_tree (app, model, *info, removed);
+        }
+      else if (not info->in_tree && wanted)
+        {
+          insert_info_to_tree (info, app);
+          inserted.push_back (info);
+        }
+    }
+
+  return inserted;
+}
+
+// Picks the top processes again from the values of the last update,
+// when only the sort column or their count changed
+void
+proctable_update_top_processes (GsmApplication *app)
+{
+  GtkTreeModel *model = gtk_tree_model_filter_get_model (GTK_TREE_MODEL_FILTER (
+                                                           gtk_tree_model_sort_get_model (GTK_TREE_MODEL_SORT (
+                                                                                            gtk_tree_view_get_model (GTK_TREE_VIEW (app->tree))))));
+
+  for (ProcInfo *info : update_top_processes (app, model))
+    update_info_mutable_cols (info);
+}
+
+void
+proctable_update_search (GsmApplication *app)
+{
+  std::vector<ProcInfo *> changed;
+  std::vector<ProcInfo *> expand;
+
+  delete app->search_query;
+  app->search_query = new ProcQuery (gtk_editable_get_text (GTK_EDITABLE (app->search_entry)));
+
+  compute_visibility (app, true, changed, expand);
+
+  if (app->settings->get_boolean (GSM_SETTING_SHOW_TOP_PROCESSES))
+    proctable_update_top_processes (app);
+
+  gtk_tree_model_filter_refilter (GTK_TREE_MODEL_FILTER (gtk_tree_model_sort_get_model (
+                                                           GTK_TREE_MODEL_SORT (gtk_tree_view_get_model (
+                                                                                  GTK_TREE_VIEW (app->tree))))));
+  expand_processes (app, expand);
+}
+
+
 void
 proctable_refresh_summary_headers(GsmApplication * app)
 {
@@ -1145,12 +1460,15 @@ refresh_list (GsmApplication *app,
               const pid_t    *pid_list,
               const guint     n)
 {
-  typedef std::list<ProcInfo*> ProcList;
-  ProcList addition;
+  // new processes and processes that have to be moved in the tree
+  std::unordered_set<ProcInfo *> addition;
+  std::vector<ProcInfo *> reparented;
 
   GtkTreeModel    *model = gtk_tree_model_filter_get_model (GTK_TREE_MODEL_FILTER (
                                                               gtk_tree_model_sort_get_model (GTK_TREE_MODEL_SORT (
                                                                                                gtk_tree_view_get_model (GTK_TREE_VIEW (app->tree))))));
+  const bool show_dependencies = shows_dependencies (app);
+  const bool show_top = app->settings->get_boolean (GSM_SETTING_SHOW_TOP_PROCESSES);
   guint i;
 
   // Add or update processes in the process list
@@ -1161,10 +1479,17 @@ refresh_list (GsmApplication *app,
       if (!info)
         {
           info = app->processes.add (pid_list[i]);
-          addition.push_back (info);
+          addition.insert (info);
+          update_info (app, info);
+          continue;
         }
 
+      const pid_t ppid = info->ppid;
+
       update_info (app, info);
+
+      if (info->ppid != ppid)
+        reparented.push_back (info);
     }
 
 
@@ -1182,8 +1507,9 @@ refresh_list (GsmApplication *app,
       if (pids.find (info.pid) == pids.end ())
         {
           procman_debug ("ripping %d", info.pid);
-          remove_info_from_tree (app, model, info, addition);
-          addition.remove (&info);
+          if (info.in_tree)
+            remove_info_from_tree (app, model, info, addition);
+          addition.erase (&info);
           it = app->processes.erase (it);
         }
       else
@@ -1192,72 +1518,55 @@ refresh_list (GsmApplication *app,
         }
     }
 
+  // Processes adopted by a new parent that is still alive are moved
+  // with their children. The ones whose parent died are already queued.
+  if (show_dependencies)
+    {
+      for (ProcInfo *info : reparented)
+        {
+          if (addition.count (info))
+            continue;
+
+          procman_debug ("reparenting %d to %d", int(info->pid), int(info->ppid));
+          remove_info_from_tree (app, model, *info, addition);
+        }
+    }
+
   // INVARIANT
   // pid_list == ProcInfo::all + addition
 
+  // match the search once for every process before inserting the new
+  // ones, the filter only reads the result
+  std::vector<ProcInfo *> visibility_changed;
+  std::vector<ProcInfo *> expand;
 
-  if (app->settings->get_boolean (GSM_SETTING_SHOW_DEPENDENCIES))
-    {
-      // insert process in the tree. walk through the addition list
-      // (new process + process that have a new parent). This loop
-      // handles the dependencies because we cannot insert a process
-      // until its parent is in the tree.
-
-      std::set<pid_t> in_tree (pids);
+  compute_visibility (app, false, visibility_changed, expand);
 
-      for (ProcList::iterator it (addition.begin ()); it != addition.end (); ++it)
-        in_tree.erase ((*it)->pid);
+  if (show_top)
+    {
+      update_top_processes (app, model);
+    }
+  else if (show_dependencies)
+    {
+      // insert the processes in the tree, parents before their
+      // children, in a single pass over the parent -> children index.
+      // A process is inserted at the top level if it has no parent
+      // (ppid = -1, ie the [kernel] on FreeBSD), if it is init or if its
+      // parent is unreachable.
 
+      std::unordered_set<pid_t> addition_pids;
 
-      while (not addition.empty ())
-        {
-          procman_debug ("looking for %d parents", int(addition.size ()));
-          ProcList::iterator it (addition.begin ());
+      for (ProcInfo *info : addition)
+        addition_pids.insert (info->pid);
 
-          while (it != addition.end ())
-            {
-              procman_debug ("looking for %d's parent with ppid %d",
-                             int((*it)->pid), int((*it)->ppid));
-
-
-              // inserts the process in the treeview if :
-              // - it has no parent (ppid = -1),
-              //   ie it is for example the [kernel] on FreeBSD
-              // - it is init
-              // - its parent is already in tree
-              // - its parent is unreachable
-              //
-              // rounds == 2 means that addition contains processes with
-              // unreachable parents
-              //
-              // FIXME: this is broken if the unreachable parent becomes active
-              // i.e. it gets active or changes ower
-              // so we just clear the tree on __each__ update
-              // see proctable_update (ProcData * const procdata)
-
-
-              if ((*it)->ppid <= 0 or in_tree.find ((*it)->ppid) != in_tree.end ())
-                {
-                  insert_info_to_tree (*it, app);
-                  in_tree.insert ((*it)->pid);
-                  it = addition.erase (it);
-                  continue;
-                }
+      procman_debug ("inserting %d processes", int(addition_pids.size ()));
 
-              ProcInfo *parent = app->processes.find ((*it)->ppid);
-              // if the parent is unreachable
-              if (not parent)
-                {
-                  // or std::find(addition.begin(), addition.end(), parent) == addition.end()) {
-                  insert_info_to_tree (*it, app, true);
-                  in_tree.insert ((*it)->pid);
-                  it = addition.erase (it);
-                  continue;
-                }
+      app->processes.get_tree ().foreach_topological (addition_pids, [app](pid_t pid) {
+        ProcInfo *info = app->processes.find (pid);
+        const bool unreachable = info->ppid > 0 && not app->processes.find (info->ppid);
 
-              ++it;
-            }
-        }
+        insert_info_to_tree (info, app, unreachable);
+      });
     }
   else
     {
@@ -1266,11 +1575,25 @@ refresh_list (GsmApplication *app,
         insert_info_to_tree (v, app);
     }
 
+  // let the filter reconsider the rows whose visibility changed
+  for (ProcInfo *info : visibility_changed)
+    {
+      if (not info->in_tree)
+        continue;
+
+      GtkTreePath *path = gtk_tree_model_get_path (model, &info->node);
+      gtk_tree_model_row_changed (model, path, &info->node);
+      gtk_tree_path_free (path);
+    }
+
+  expand_processes (app, expand);
+
   // update Header
   proctable_refresh_summary_headers(app);
 
   for (auto&v : app->processes)
-    update_info_mutable_cols (&v.second);
+    if (v.second.in_tree)
+      update_info_mutable_cols (&v.second);
 }
 
 void
@@ -1278,7 +1601,6 @@ proctable_update (GsmApplication *app)
 {
   pid_t*pid_list;
   glibtop_proclist proclist;
-  glibtop_cpu cpu;
   int which = 0;
   int arg = 0;
   auto whose_processes = app->settings->get_string (GSM_SETTING_SHOW_WHOSE_PROCESSES);
@@ -1303,14 +1625,18 @@ proctable_update (GsmApplication *app)
 
   /* FIXME: total cpu time elapsed should be calculated on an individual basis here
   ** should probably have a total_time_last gint in the ProcInfo structure */
-  glibtop_get_cpu (&cpu);
+  const glibtop_cpu &cpu = *gsm_sampler_get_cpu (NULL);
   app->cpu_total_time = MAX (cpu.total - app->cpu_total_time_last, 1);
   app->cpu_total_time_last = cpu.total;
 
   // FIXME: not sure if glibtop always returns a sorted list of pid
   // but it is important otherwise refresh_list won't find the parent
   std::sort (pid_list, pid_list + proclist.number);
+
+  // the rows are sorted once after the whole update
+  proctable_sort_freeze (app);
   refresh_list (app, pid_list, proclist.number);
+  proctable_sort_thaw (app);
 
   // juggling with tree scroll position to fix https://bugzilla.gnome.org/show_bug.cgi?id=92724
   GtkTreePath*current_top;
@@ -1346,6 +1672,14 @@ proctable_update (GsmApplication *app)
   g_free (pid_list);
 
   /* proclist.number == g_list_length(procdata->info) == g_hash_table_size(procdata->pids) */
+
+  static bool first_update = true;
+
+  if (G_UNLIKELY (first_update))
+    {
+      procman_startup_phase ("first process list");
+      first_update = false;
+    }
 }
 
 void
@@ -1359,7 +1693,7 @@ proctable_freeze (GsmApplication *app)
 {
   if (app->timeout)
     {
-      g_source_remove (app->timeout);
+      gsm_sampler_remove (app->timeout);
       app->timeout = 0;
     }
 }
@@ -1370,9 +1704,9 @@ proctable_thaw (GsmApplication *app)
   if (app->timeout)
     return;
 
-  app->timeout = g_timeout_add (app->config.update_interval,
-                                cb_timeout,
-                                app);
+  app->timeout = gsm_sampler_add (app->config.update_interval,
+                                  cb_timeout,
+                                  app);
 }
 
 void
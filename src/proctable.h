@@ -67,6 +67,8 @@ void          proctable_free_table (GsmApplication *app);
 void          proctable_freeze (GsmApplication *app);
 void          proctable_thaw (GsmApplication *app);
 void          proctable_reset_timeout (GsmApplication *app);
+void          proctable_update_search (GsmApplication *app);
+void          proctable_update_top_processes (GsmApplication *app);
 
 void          get_process_memory_writable (ProcInfo *info);
 void          get_last_selected (GtkTreeModel *model,
@@ -0,0 +1,234 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#pragma once
+
+#include <sys/types.h>
+
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+/*
+ * Parent -> children index of the process list.
+ *
+ * Every process is keyed by its pid and carries a value (a ProcInfo * in
+ * ProcList).  A parent does not need to be known to have children: they
+ * hang on a placeholder node until the parent shows up or the last child
+ * goes away.  Adding, removing and reparenting a process are O(1).
+ */
+template<typename T>
+class ProcTree
+{
+public:
+  // adds @pid, or moves it under @ppid if it is already known
+  void
+  set (pid_t pid,
+       pid_t ppid,
+       T     value)
+  {
+    Node &node = nodes[pid];
+
+    node.value = value;
+
+    if (node.present && node.parent == ppid)
+      return;
+
+    if (node.present)
+      unlink (pid, node);
+
+    node.present = true;
+    node.parent = ppid;
+
+    if (ppid != pid)
+      {
+        std::vector<pid_t> &siblings = nodes[ppid].children;
+
+        node.index = siblings.size ();
+        siblings.push_back (pid);
+      }
+  }
+
+  void
+  remove (pid_t pid)
+  {
+    auto it = nodes.find (pid);
+
+    if (it == nodes.end () || not it->second.present)
+      return;
+
+    unlink (pid, it->second);
+    it->second.present = false;
+    it->second.value = T ();
+
+    if (it->second.children.empty ())
+      nodes.erase (it);
+  }
+
+  void
+  clear ()
+  {
+    nodes.clear ();
+  }
+
+  size_t
+  size () const
+  {
+    size_t n = 0;
+
+    for (const auto &v : nodes)
+      n += v.second.present;
+
+    return n;
+  }
+
+  bool
+  contains (pid_t pid) const
+  {
+    auto it = nodes.find (pid);
+
+    return it != nodes.end () && it->second.present;
+  }
+
+  T
+  value (pid_t pid) const
+  {
+    auto it = nodes.find (pid);
+
+    return it != nodes.end () ? it->second.value : T ();
+  }
+
+  pid_t
+  parent (pid_t pid) const
+  {
+    auto it = nodes.find (pid);
+
+    return it != nodes.end () && it->second.present ? it->second.parent : -1;
+  }
+
+  const std::vector<pid_t> &
+  children (pid_t pid) const
+  {
+    static const std::vector<pid_t> none;
+    auto it = nodes.find (pid);
+
+    return it != nodes.end () ? it->second.children : none;
+  }
+
+  // Calls @func on every pid of @pids, a process always coming after its
+  // parent when both are in @pids.  O(|pids|).
+  template<typename Func>
+  void
+  foreach_topological (const std::unordered_set<pid_t> &pids,
+                       Func                             func) const
+  {
+    std::vector<pid_t> stack;
+    size_t visited = 0;
+
+    for (pid_t pid : pids)
+      {
+        const pid_t ppid = parent (pid);
+
+        // will be reached from its parent
+        if (ppid != pid && pids.count (ppid))
+          continue;
+
+        stack.push_back (pid);
+
+        while (not stack.empty ())
+          {
+            const pid_t current = stack.back ();
+
+            stack.pop_back ();
+            func (current);
+            visited++;
+
+            for (pid_t child : children (current))
+              if (pids.count (child))
+                stack.push_back (child);
+          }
+      }
+
+    if (visited == pids.size ())
+      return;
+
+    // the parents changed while they were read and formed a loop,
+    // still hand out every process once
+    std::unordered_set<pid_t> seen;
+
+    for (pid_t pid : pids)
+      {
+        const pid_t ppid = parent (pid);
+
+        if (ppid == pid || not pids.count (ppid))
+          {
+            seen.insert (pid);
+            for (pid_t child : descendants_in (pid, pids))
+              seen.insert (child);
+          }
+      }
+
+    for (pid_t pid : pids)
+      if (seen.insert (pid).second)
+        func (pid);
+  }
+
+private:
+  struct Node
+  {
+    T value = T ();
+    pid_t parent = -1;
+    size_t index = 0;             // position in the parent's children
+    bool present = false;
+    std::vector<pid_t> children;
+  };
+
+  std::vector<pid_t>
+  descendants_in (pid_t                            pid,
+                  const std::unordered_set<pid_t> &pids) const
+  {
+    std::vector<pid_t> result;
+    std::vector<pid_t> stack (1, pid);
+
+    while (not stack.empty ())
+      {
+        const pid_t current = stack.back ();
+
+        stack.pop_back ();
+        for (pid_t child : children (current))
+          if (pids.count (child))
+            {
+              result.push_back (child);
+              stack.push_back (child);
+            }
+      }
+
+    return result;
+  }
+
+  void
+  unlink (pid_t pid,
+          Node &node)
+  {
+    if (node.parent == pid)
+      return;
+
+    auto it = nodes.find (node.parent);
+
+    if (it == nodes.end ())
+      return;
+
+    std::vector<pid_t> &siblings = it->second.children;
+    const pid_t last = siblings.back ();
+
+    siblings[node.index] = last;
+    nodes[last].index = node.index;
+    siblings.pop_back ();
+
+    if (siblings.empty () && not it->second.present)
+      nodes.erase (it);
+  }
+
+  std::unordered_map<pid_t, Node> nodes;
+};
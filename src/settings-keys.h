@@ -19,27 +19,42 @@
 #define GSM_SETTING_RESOURCES_MEM_EXPANDED  "resources-mem-expanded"
 #define GSM_SETTING_RESOURCES_NET_EXPANDED  "resources-net-expanded"
 #define GSM_SETTING_RESOURCES_DISK_EXPANDED "resources-disk-expanded"
+#define GSM_SETTING_RESOURCES_PRESSURE_EXPANDED "resources-pressure-expanded"
+#define GSM_SETTING_RESOURCES_CPU_TIMES_EXPANDED "resources-cpu-times-expanded"
 #define GSM_SETTING_PROCESS_UPDATE_INTERVAL "update-interval"
 #define GSM_SETTING_SHOW_WHOSE_PROCESSES    "show-whose-processes"
 #define GSM_SETTING_SHOW_DEPENDENCIES       "show-dependencies"
+#define GSM_SETTING_SHOW_TOP_PROCESSES      "show-top-processes"
+#define GSM_SETTING_TOP_PROCESSES_COUNT     "top-processes-count"
 #define GSM_SETTING_SHOW_KILL_DIALOG        "kill-dialog"
 #define GSM_SETTING_SOLARIS_MODE            "solaris-mode"
 #define GSM_SETTING_PROCESS_MEMORY_IN_IEC   "process-memory-in-iec"
 #define GSM_SETTING_GRAPH_UPDATE_INTERVAL   "graph-update-interval"
 #define GSM_SETTING_CPU_COLORS              "cpu-colors"
+#define GSM_SETTING_CPU_TIMES_COLORS        "cpu-times-colors"
 #define GSM_SETTING_MEM_COLOR               "mem-color"
 #define GSM_SETTING_SWAP_COLOR              "swap-color"
 #define GSM_SETTING_NET_IN_COLOR            "net-in-color"
 #define GSM_SETTING_NET_OUT_COLOR           "net-out-color"
 #define GSM_SETTING_DISK_READ_COLOR         "disk-read-color"
 #define GSM_SETTING_DISK_WRITE_COLOR        "disk-write-color"
+#define GSM_SETTING_PRESSURE_CPU_COLOR      "pressure-cpu-color"
+#define GSM_SETTING_PRESSURE_MEMORY_COLOR   "pressure-memory-color"
+#define GSM_SETTING_PRESSURE_IO_COLOR       "pressure-io-color"
 #define GSM_SETTING_LOGARITHMIC_SCALE       "logarithmic-scale"
 #define GSM_SETTING_DRAW_STACKED            "cpu-stacked-area-chart"
 #define GSM_SETTING_DRAW_SMOOTH             "cpu-smooth-graph"
+#define GSM_SETTING_DRAW_HEATMAP            "cpu-heatmap"
+#define GSM_SETTING_SHOW_CPU_TIMES          "cpu-times"
+#define GSM_SETTING_CPU_TIMES_CPU           "cpu-times-cpu"
 #define GSM_SETTING_RESOURCES_MEMORY_IN_IEC "resources-memory-in-iec"
 #define GSM_SETTING_NETWORK_IN_BITS         "network-in-bits"
 #define GSM_SETTING_GRAPH_DATA_POINTS       "graph-data-points"
 #define GSM_SETTING_NETWORK_TOTAL_IN_BITS   "network-total-in-bits"
+#define GSM_SETTING_NETWORK_INTERFACE       "network-interface"
+#define GSM_SETTING_DISK_DEVICE             "disk-device"
+#define GSM_SETTING_PRESSURE_CGROUP         "pressure-cgroup"
+#define GSM_SETTING_PRESSURE_SNAPSHOT       "pressure-snapshot"
 #define GSM_SETTING_SHOW_CPU                "show-cpu"
 #define GSM_SETTING_SHOW_MEM                "show-mem"
 #define GSM_SETTING_SHOW_NETWORK            "show-network"
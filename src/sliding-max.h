@@ -0,0 +1,89 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#pragma once
+
+#include <glib.h>
+
+#include <deque>
+
+/*
+ * Maximum of the values of the latest points of a graph.
+ *
+ * Only the points that can still become the maximum are kept, in
+ * decreasing values: a new point drops the smaller ones before it, and
+ * the oldest one leaves once out of the window, so that adding a point
+ * is amortized O(1) and the maximum is the front.
+ */
+class SlidingMax
+{
+public:
+  SlidingMax ()
+    : window (0),
+    n_pushed (0),
+    candidates ()
+  {
+  }
+
+  explicit SlidingMax (guint points)
+    : window (points),
+    n_pushed (0),
+    candidates ()
+  {
+  }
+
+  // adds a new latest point, the oldest one leaves the window
+  void
+  push (guint64 value)
+  {
+    n_pushed++;
+
+    while (!candidates.empty () && candidates.back ().value <= value)
+      candidates.pop_back ();
+
+    candidates.push_back ({ n_pushed, value });
+    expire ();
+  }
+
+  // 0 without points
+  guint64
+  max () const
+  {
+    return candidates.empty () ? 0 : candidates.front ().value;
+  }
+
+  // as if every point of the window had @value
+  void
+  fill (guint64 value)
+  {
+    candidates.clear ();
+    candidates.push_back ({ n_pushed, value });
+  }
+
+  // keeps the latest points
+  void
+  resize (guint points)
+  {
+    window = points;
+    expire ();
+  }
+
+private:
+  struct Candidate
+  {
+    guint64 index;
+    guint64 value;
+  };
+
+  void
+  expire ()
+  {
+    while (!candidates.empty () && candidates.front ().index + window <= n_pushed)
+      candidates.pop_front ();
+  }
+
+  guint window;
+  guint64 n_pushed;
+  std::deque<Candidate> candidates;
+};
@@ -7,6 +7,7 @@
 #include <glibtop/cpu.h>
 
 #include "smooth_refresh.h"
+#include "gsm-sampler.h"
 #include "application.h"
 #include "settings-keys.h"
 #include "update_interval.h"
@@ -20,12 +21,11 @@ const string SmoothRefresh::KEY (GSM_SETTING_SMOOTH_REFRESH);
 unsigned
 SmoothRefresh::get_own_cpu_usage ()
 {
-  glibtop_cpu cpu;
+  const glibtop_cpu &cpu = *gsm_sampler_get_cpu (NULL);
   glibtop_proc_time proctime;
   guint64 elapsed;
   unsigned usage = PCPU_LO;
 
-  glibtop_get_cpu (&cpu);
   elapsed = cpu.total - this->last_total_time;
 
   if (elapsed)     // avoid division by 0
@@ -74,10 +74,9 @@ SmoothRefresh::SmoothRefresh(Glib::RefPtr<Gio::Settings> a_settings)
 void
 SmoothRefresh::reset ()
 {
-  glibtop_cpu cpu;
+  const glibtop_cpu &cpu = *gsm_sampler_get_cpu (NULL);
   glibtop_proc_time proctime;
 
-  glibtop_get_cpu (&cpu);
   glibtop_get_proc_time (&proctime, getpid ());
 
   this->interval = GsmApplication::get ().config.update_interval;
@@ -0,0 +1,184 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include <config.h>
+
+#include <glib.h>
+#include <glibmm.h>
+#include <glibtop/procstate.h>
+#include <unistd.h>
+
+#include "procinfo.h"
+#include "procquery.h"
+
+
+static ProcInfo *
+make_info (void)
+{
+  ProcInfo *info = new ProcInfo (getpid ());
+
+  info->name = "python3";
+  info->user = "root";
+  info->arguments = "/usr/bin/python3 -m http.server";
+  info->cgroup_name = "/user.slice/user-1000.slice";
+  info->unit = "session-2.scope";
+  info->status = GLIBTOP_PROCESS_RUNNING;
+  info->pcpu = 12.5;
+  info->mem = 300UL * 1024 * 1024;
+  info->memres = 2UL * 1024 * 1024 * 1024;
+  info->vmsize = 4096UL;
+  info->nice = -5;
+
+  return info;
+}
+
+
+static bool
+query_matches (const char     *query,
+               const ProcInfo *info)
+{
+  return ProcQuery (query).matches (*info);
+}
+
+
+static void
+test_procquery_empty (void)
+{
+  g_assert_true (ProcQuery ("").is_empty ());
+  g_assert_true (ProcQuery (" \t ").is_empty ());
+  g_assert_true (ProcQuery ("|").is_empty ());
+  g_assert_false (ProcQuery ("cpu>5").is_empty ());
+  g_assert_false (ProcQuery ("python").is_empty ());
+}
+
+
+static void
+test_procquery_operators (void)
+{
+  ProcInfo *info = make_info ();
+
+  g_assert_true (query_matches ("cpu>5", info));
+  g_assert_false (query_matches ("cpu>12.5", info));
+  g_assert_true (query_matches ("cpu>=12.5", info));
+  g_assert_true (query_matches ("cpu<=12.5", info));
+  g_assert_false (query_matches ("cpu<12.5", info));
+  g_assert_true (query_matches ("cpu=12.5", info));
+  g_assert_true (query_matches ("cpu:12.5", info));
+  g_assert_false (query_matches ("cpu!=12.5", info));
+  g_assert_true (query_matches ("nice<0", info));
+  g_assert_true (query_matches ("NICE=-5", info));
+
+  /* Whole value for '=', substring for ':', both case insensitive */
+  g_assert_true (query_matches ("user=ROOT", info));
+  g_assert_false (query_matches ("user=ro", info));
+  g_assert_true (query_matches ("user:ro", info));
+  g_assert_true (query_matches ("user!=nobody", info));
+  g_assert_true (query_matches ("cmd:http.server", info));
+  g_assert_false (query_matches ("cmd:http-server", info));
+  g_assert_true (query_matches ("cgroup:user-1000", info));
+  g_assert_true (query_matches ("unit=session-2.scope", info));
+
+  g_assert_true (query_matches ("state=R", info));
+  g_assert_true (query_matches ("status:running", info));
+  g_assert_false (query_matches ("state!=r", info));
+  g_assert_false (query_matches ("state=zombie", info));
+
+  /* All terms and the plain text must match */
+  g_assert_true (query_matches ("cpu>5 user:root python", info));
+  g_assert_false (query_matches ("cpu>5 user:nobody", info));
+  g_assert_false (query_matches ("cpu>5 perl", info));
+  g_assert_true (query_matches ("perl python", info));
+  g_assert_true (query_matches ("perl|python", info));
+
+  delete info;
+}
+
+
+static void
+test_procquery_units (void)
+{
+  ProcInfo *info = make_info ();
+
+  g_assert_true (query_matches ("mem>200M", info));
+  g_assert_true (query_matches ("mem=300MiB", info));
+  g_assert_true (query_matches ("mem=300mb", info));
+  g_assert_true (query_matches ("mem<0.5G", info));
+  g_assert_true (query_matches ("res=2GiB", info));
+  g_assert_true (query_matches ("res=2097152K", info));
+  g_assert_true (query_matches ("res<0.01T", info));
+  g_assert_true (query_matches ("virt=4096B", info));
+  g_assert_true (query_matches ("cpu>10%", info));
+
+  delete info;
+}
+
+
+static void
+test_procquery_quoting (void)
+{
+  ProcInfo *info = make_info ();
+
+  /* The values are matched literally, not as regular expressions */
+  g_assert_false (query_matches ("cmd:python.*server", info));
+  g_assert_false (query_matches ("name=python.", info));
+  info->arguments = "/usr/bin/python3 -c print(1+1)";
+  g_assert_true (query_matches ("cmd:(1+1)", info));
+  g_assert_false (query_matches ("cmd:(11)", info));
+
+  /* Plain text that is not a valid regular expression is escaped */
+  info->name = "a(b";
+  g_assert_true (query_matches ("a(b", info));
+  g_assert_false (query_matches ("ab", info));
+
+  delete info;
+}
+
+
+static void
+test_procquery_malformed (void)
+{
+  ProcInfo *info = make_info ();
+
+  /* Not structured, so they are searched as plain text instead */
+  info->name = "cpu>lots";
+  g_assert_true (query_matches ("cpu>lots", info));
+  info->name = "mem>200X";
+  g_assert_true (query_matches ("mem>200X", info));
+  info->name = "state=busy";
+  g_assert_true (query_matches ("state=busy", info));
+  info->name = "state>R";
+  g_assert_true (query_matches ("state>R", info));
+  info->name = "user>root";
+  g_assert_true (query_matches ("user>root", info));
+  info->name = "cpu>";
+  g_assert_true (query_matches ("cpu>", info));
+  info->name = "=5";
+  g_assert_true (query_matches ("=5", info));
+  info->name = "color=red";
+  g_assert_true (query_matches ("color=red", info));
+
+  /* ... which these do not match */
+  info->name = "python3";
+  g_assert_false (query_matches ("cpu>lots", info));
+  g_assert_false (query_matches ("mem>200X", info));
+  g_assert_false (query_matches ("color=red", info));
+
+  delete info;
+}
+
+
+int
+main (int argc, char *argv[])
+{
+  Glib::init ();
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/gnome-system-monitor/procquery/empty", test_procquery_empty);
+  g_test_add_func ("/gnome-system-monitor/procquery/operators", test_procquery_operators);
+  g_test_add_func ("/gnome-system-monitor/procquery/units", test_procquery_units);
+  g_test_add_func ("/gnome-system-monitor/procquery/quoting", test_procquery_quoting);
+  g_test_add_func ("/gnome-system-monitor/procquery/malformed", test_procquery_malformed);
+
+  return g_test_run ();
+}
@@ -190,43 +190,6 @@ get_relative_time (void)
   return 1e-6 * g_get_monotonic_time () - start_time;
 }
 
-static gdouble
-get_size_from_column (GtkTreeModel*model,
-                      GtkTreeIter *first,
-                      const guint  index)
-{
-  GValue value = G_VALUE_INIT;
-
-  gtk_tree_model_get_value (model, first, index, &value);
-
-  gdouble size;
-
-  switch (G_VALUE_TYPE (&value))
-    {
-      case G_TYPE_UINT:
-        size = g_value_get_uint (&value);
-        break;
-
-      case G_TYPE_ULONG:
-        size = g_value_get_ulong (&value);
-        break;
-
-      case G_TYPE_UINT64:
-        size = g_value_get_uint64 (&value);
-        break;
-
-      case G_TYPE_DOUBLE:
-        size = g_value_get_double (&value);
-        break;
-
-      default:
-        g_assert_not_reached ();
-    }
-
-  g_value_unset (&value);
-  return size;
-}
-
 void
 procman_debug_real (const char *file,
                     int         line,
@@ -250,6 +213,36 @@ procman_debug_real (const char *file,
 }
 
 
+// time from the application startup to the first frame
+#define STARTUP_BUDGET_MS 500.0
+
+void
+procman_startup_phase (const char *phase,
+                       bool        last)
+{
+  static gint64 start_time;
+  static gint64 last_time;
+
+  if (G_LIKELY (!is_debug_enabled ()))
+    return;
+
+  const gint64 now = g_get_monotonic_time ();
+
+  if (!start_time)
+    start_time = last_time = now;
+
+  const double total = (now - start_time) / 1000.0;
+
+  procman_debug ("startup: %s in %.1f ms (%.1f ms since startup)",
+                 phase, (now - last_time) / 1000.0, total);
+
+  last_time = now;
+
+  if (last && total > STARTUP_BUDGET_MS)
+    procman_debug ("startup: over the %.0f ms budget by %.1f ms",
+                   STARTUP_BUDGET_MS, total - STARTUP_BUDGET_MS);
+}
+
 // h is in [0.0; 1.0] (and not [0°; 360°] )
 // s is in [0.0; 1.0]
 // v is in [0.0; 1.0]
@@ -612,45 +605,6 @@ priority_cell_data_func (GtkTreeViewColumn *,
   g_object_set (renderer, "text", procman::get_nice_level (priority), NULL);
 }
 
-gint
-priority_compare_func (GtkTreeModel*model,
-                       GtkTreeIter *first,
-                       GtkTreeIter *second,
-                       gpointer     user_data)
-{
-  const guint index = GPOINTER_TO_UINT (user_data);
-  GValue value1 = G_VALUE_INIT;
-  GValue value2 = G_VALUE_INIT;
-
-  gtk_tree_model_get_value (model, first, index, &value1);
-  gtk_tree_model_get_value (model, second, index, &value2);
-  gint result = g_value_get_int (&value1) - g_value_get_int (&value2);
-
-  g_value_unset (&value1);
-  g_value_unset (&value2);
-  return result;
-}
-
-gint
-number_compare_func (GtkTreeModel*model,
-                     GtkTreeIter *first,
-                     GtkTreeIter *second,
-                     gpointer     user_data)
-{
-  const guint index = GPOINTER_TO_UINT (user_data);
-
-  gdouble size1, size2;
-
-  size1 = get_size_from_column (model, first, index);
-  size2 = get_size_from_column (model, second, index);
-
-  if (size2 > size1)
-    return 1;
-  else if (size2 < size1)
-    return -1;
-  return 0;
-}
-
 template<>
 void
 tree_store_update<const char>(GtkTreeModel*model,
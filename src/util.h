@@ -25,6 +25,12 @@ procman_debug_real (const char *file,
 
 #define procman_debug(FMT, ...) procman_debug_real (__FILE__, __LINE__, __func__, FMT, ## __VA_ARGS__)
 
+// reports how long the startup phase ending now took, @last checks the
+// whole startup against its budget
+void
+procman_startup_phase (const char *phase,
+                       bool        last = false);
+
 GtkLabel *                         init_tnum_label (gint     char_width,
                                                     GtkAlign halign);
 GtkLabel *                         make_tnum_label (void);
@@ -102,14 +108,6 @@ void priority_cell_data_func (GtkTreeViewColumn *col,
                               GtkTreeModel      *model,
                               GtkTreeIter       *iter,
                               gpointer           user_data);
-gint priority_compare_func (GtkTreeModel*model,
-                            GtkTreeIter *first,
-                            GtkTreeIter *second,
-                            gpointer     user_data);
-gint number_compare_func (GtkTreeModel*model,
-                          GtkTreeIter *first,
-                          GtkTreeIter *second,
-                          gpointer     user_data);
 
 
 template<typename T>